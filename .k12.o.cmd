@@ -0,0 +1 @@
+cc -D_POSIX_C_SOURCE=200809L -D_XOPEN_SOURCE=700  -std=c11 -O3 -Wall -Wextra -pipe -pthread  -c -o k12.o k12.c
@@ -0,0 +1,419 @@
+/* SPDX-License-Identifier: 0BSD
+ *
+ * Copyright © 2022 Alex Minghella <a@minghella.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Benchmark.
+ *
+ * Every case is timed on every kernel set the CPU supports, for every message
+ * size up to the maximum, with the input both 64-byte aligned and offset by one
+ * byte. Each measurement is the median of several samples, each of which runs
+ * the case enough times to take at least the target sample time. Results are
+ * written to standard output as a single JSON document.
+ *
+ * Cycles are counted with the time-stamp counter on x86 and the virtual
+ * counter on arm64. Neither necessarily ticks at the core clock, so the
+ * counter is named in the output and cycles per byte should only be compared
+ * between runs on the same machine.
+ */
+
+#include "sha3.h"
+#include "keccak.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(KECCAK_HAVE_X86)
+	#include <x86intrin.h>
+	#define COUNTER "rdtsc"
+#elif defined(KECCAK_HAVE_ARM64)
+	#define COUNTER "cntvct"
+#endif
+
+#define SAMPLES 5
+#define BATCH   64
+
+static const char *const kernels[] = {
+	"generic", "generic-lc", "generic32", "avx2", "avx512", "arm-sha3",
+};
+
+static uint64_t counter(void)
+{
+#if defined(KECCAK_HAVE_X86)
+	return __rdtsc();
+#elif defined(KECCAK_HAVE_ARM64)
+	uint64_t x;
+	__asm__ volatile("isb; mrs %0, cntvct_el0" : "=r"(x));
+	return x;
+#else
+	return 0;
+#endif
+}
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * A benchmark case hashes @len bytes at @buf once. @param selects the
+ * algorithm within the API. @max, if non-zero, limits the message size, and
+ * @scale is the number of messages hashed per call, for the batch cases.
+ */
+struct bench {
+	const char *api;
+	const char *algo;
+	void (*run)(const struct bench *b, const uint8_t *buf, size_t len);
+	unsigned param;
+	size_t max;
+	size_t scale;
+};
+
+static uint8_t out[BATCH * 64];
+
+static void run_update(const struct bench *b, const uint8_t *buf, size_t len)
+{
+	struct sha3_ctx ctx;
+
+	sha3_init(&ctx, b->param);
+	sha3_update(&ctx, buf, len);
+	sha3_final(&ctx, out);
+}
+
+static void run_oneshot(const struct bench *b, const uint8_t *buf, size_t len)
+{
+	switch (b->param) {
+	case SHA3_224:
+		sha3_224(buf, len, out);
+		break;
+	case SHA3_256:
+		sha3_256(buf, len, out);
+		break;
+	case SHA3_384:
+		sha3_384(buf, len, out);
+		break;
+	case SHA3_512:
+		sha3_512(buf, len, out);
+		break;
+	}
+}
+
+static void run_batch(const struct bench *b, const uint8_t *buf, size_t len)
+{
+	const void *bufs[BATCH];
+	size_t lens[BATCH];
+
+	for (size_t i = 0; i < BATCH; i++) {
+		bufs[i] = buf + i * len;
+		lens[i] = len;
+	}
+
+	sha3_hash_many(b->param, bufs, lens, BATCH, out);
+}
+
+static void run_shake(const struct bench *b, const uint8_t *buf, size_t len)
+{
+	struct sha3_ctx ctx;
+
+	shake_init(&ctx, b->param);
+	sha3_update(&ctx, buf, len);
+	shake_final(&ctx);
+	shake_squeeze(&ctx, out, 2 * b->param);
+}
+
+/* The input length is the output length for the XOF cases. */
+static void run_squeeze(const struct bench *b, const uint8_t *buf, size_t len)
+{
+	struct sha3_ctx ctx;
+
+	shake_init(&ctx, b->param);
+	shake_final(&ctx);
+	shake_squeeze(&ctx, (uint8_t *)buf, len);
+}
+
+static void run_k12(const struct bench *b, const uint8_t *buf, size_t len)
+{
+	k12(b->param, buf, len, NULL, 0, out, 2 * b->param, NULL);
+}
+
+static void run_parallelhash(const struct bench *b, const uint8_t *buf,
+                             size_t len)
+{
+	parallelhash(b->param, buf, len, 8192, NULL, 0, out, 2 * b->param, NULL);
+}
+
+static void run_kmac(const struct bench *b, const uint8_t *buf, size_t len)
+{
+	static struct sha3_ctx key[2];
+	struct sha3_ctx *k = &key[b->param == SHAKE256];
+
+	if (!k->rate)
+		kmac_init(k, b->param, "key", 3, NULL, 0);
+
+	kmac(k, buf, len, out, 2 * b->param);
+}
+
+static const struct bench benches[] = {
+	{ "update", "sha3-224", run_update, SHA3_224, 0, 1 },
+	{ "update", "sha3-256", run_update, SHA3_256, 0, 1 },
+	{ "update", "sha3-384", run_update, SHA3_384, 0, 1 },
+	{ "update", "sha3-512", run_update, SHA3_512, 0, 1 },
+	{ "oneshot", "sha3-224", run_oneshot, SHA3_224, 0, 1 },
+	{ "oneshot", "sha3-256", run_oneshot, SHA3_256, 0, 1 },
+	{ "oneshot", "sha3-384", run_oneshot, SHA3_384, 0, 1 },
+	{ "oneshot", "sha3-512", run_oneshot, SHA3_512, 0, 1 },
+	{ "batch", "sha3-256", run_batch, SHA3_256, 1 << 16, BATCH },
+	{ "batch", "sha3-512", run_batch, SHA3_512, 1 << 16, BATCH },
+	{ "update", "shake128", run_shake, SHAKE128, 0, 1 },
+	{ "update", "shake256", run_shake, SHAKE256, 0, 1 },
+	{ "squeeze", "shake128", run_squeeze, SHAKE128, 0, 1 },
+	{ "squeeze", "shake256", run_squeeze, SHAKE256, 0, 1 },
+	{ "oneshot", "kt128", run_k12, KT128, 0, 1 },
+	{ "oneshot", "kt256", run_k12, KT256, 0, 1 },
+	{ "oneshot", "parallelhash128", run_parallelhash, SHAKE128, 0, 1 },
+	{ "oneshot", "parallelhash256", run_parallelhash, SHAKE256, 0, 1 },
+	{ "oneshot", "kmac128", run_kmac, SHAKE128, 0, 1 },
+	{ "oneshot", "kmac256", run_kmac, SHAKE256, 0, 1 },
+};
+
+struct sample {
+	double sec;
+	uint64_t cycles;
+};
+
+static int cmp_sample(const void *a, const void *b)
+{
+	const struct sample *x = a, *y = b;
+	return (x->sec > y->sec) - (x->sec < y->sec);
+}
+
+/**
+ * measure - Time a benchmark case.
+ *
+ * @b:      Benchmark case.
+ * @buf:    Input buffer.
+ * @len:    Message size in bytes.
+ * @target: Minimum time per sample in seconds.
+ * @iters:  Set to the number of calls per sample.
+ *
+ * @return: The median sample.
+ *
+ * The number of calls per sample is found by doubling from one call, which
+ * also serves to warm up the caches and branch predictors. Cases that take
+ * longer than @target for a single call, such as those on the largest sizes,
+ * only take one sample.
+ */
+static struct sample measure(const struct bench *b, const uint8_t *buf,
+                             size_t len, double target, size_t *iters)
+{
+	struct sample s[SAMPLES];
+	size_t n = 1;
+	size_t samples = SAMPLES;
+
+	for (;;) {
+		double t = now();
+		for (size_t i = 0; i < n; i++)
+			b->run(b, buf, len);
+		t = now() - t;
+
+		if (t >= target) {
+			if (n == 1)
+				samples = 1;
+			break;
+		}
+		n *= 2;
+	}
+
+	for (size_t k = 0; k < samples; k++) {
+		double t = now();
+		uint64_t c = counter();
+		for (size_t i = 0; i < n; i++)
+			b->run(b, buf, len);
+		s[k].cycles = counter() - c;
+		s[k].sec = now() - t;
+	}
+
+	qsort(s, samples, sizeof(s[0]), cmp_sample);
+	*iters = n;
+	return s[samples / 2];
+}
+
+/**
+ * report - Write one result as a JSON object.
+ *
+ * @kernel:  Kernel set name.
+ * @b:       Benchmark case.
+ * @len:     Message size in bytes.
+ * @aligned: Whether the input was 64-byte aligned.
+ * @s:       Median sample.
+ * @iters:   Number of calls per sample.
+ *
+ * @return: None.
+ */
+static void report(const char *kernel, const struct bench *b, size_t len,
+                   bool aligned, struct sample s, size_t iters)
+{
+	static const char *sep = "\n";
+	double ops = (double)b->scale * iters;
+	double bytes = ops * len;
+
+	printf("%s    {\"kernel\": \"%s\", \"api\": \"%s\", \"algo\": \"%s\", "
+	       "\"size\": %zu, \"aligned\": %s, \"iterations\": %zu, "
+	       "\"ns_per_op\": %.1f, \"mib_per_s\": %.2f, ",
+	       sep, kernel, b->api, b->algo, len, aligned ? "true" : "false",
+	       iters, s.sec * 1e9 / ops, bytes / s.sec / (1 << 20));
+
+#if defined(COUNTER)
+	printf("\"cycles_per_op\": %.1f, ", s.cycles / ops);
+	if (len)
+		printf("\"cycles_per_byte\": %.3f}", s.cycles / bytes);
+	else
+		printf("\"cycles_per_byte\": null}");
+#else
+	printf("\"cycles_per_op\": null, \"cycles_per_byte\": null}");
+#endif
+
+	fflush(stdout);
+	sep = ",\n";
+}
+
+/**
+ * bench_kernel - Run every benchmark case on the selected kernel set.
+ *
+ * @kernel: Kernel set name.
+ * @mem:    64-byte aligned input buffer.
+ * @max:    Largest message size in bytes.
+ * @target: Minimum time per sample in seconds.
+ *
+ * @return: None.
+ */
+static void bench_kernel(const char *kernel, const uint8_t *mem, size_t max,
+                         double target)
+{
+	for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+		const struct bench *b = &benches[i];
+		size_t lim = b->max && b->max < max ? b->max : max;
+
+		/* Sizes are zero and then powers of four from one byte. */
+		for (size_t len = 0; len <= lim; len = len ? len * 4 : 1) {
+			for (size_t u = 0; u < 2; u++) {
+				size_t iters;
+				struct sample s = measure(b, mem + u, len,
+				                          target, &iters);
+				report(kernel, b, len, !u, s, iters);
+			}
+
+			if (len > lim / 4)
+				break;
+		}
+	}
+}
+
+static size_t parse_size(const char *s)
+{
+	char *end;
+	unsigned long long x = strtoull(s, &end, 0);
+
+	switch (*end) {
+	case 'G':
+		x <<= 10;
+		/* Fallthrough */
+	case 'M':
+		x <<= 10;
+		/* Fallthrough */
+	case 'K':
+		x <<= 10;
+	}
+
+	return x;
+}
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+	        "usage: %s [-k kernel] [-m max-size] [-t sample-ms]\n"
+	        "\n"
+	        "  -k  Only benchmark the named kernel set.\n"
+	        "  -m  Largest message size, with an optional K, M, or G\n"
+	        "      suffix. (default 1G)\n"
+	        "  -t  Minimum time per sample in milliseconds. (default 20)\n",
+	        argv0);
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	const char *only = NULL;
+	size_t max = (size_t)1 << 30;
+	double target = 0.02;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "k:m:t:")) != -1) {
+		switch (opt) {
+		case 'k':
+			only = optarg;
+			break;
+		case 'm':
+			max = parse_size(optarg);
+			break;
+		case 't':
+			target = atof(optarg) / 1000;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	/* The batch cases need room for BATCH messages of their largest size. */
+	size_t bufsize = max > BATCH << 16 ? max : BATCH << 16;
+	uint8_t *mem;
+	if (posix_memalign((void **)&mem, 64, bufsize + 64)) {
+		perror("posix_memalign");
+		return 1;
+	}
+
+	for (size_t i = 0; i < bufsize + 64; i++)
+		mem[i] = i * 0x9e3779b1U >> 24;
+
+	const char *initial = sha3_kernel();
+
+	printf("{\n");
+#if defined(COUNTER)
+	printf("  \"counter\": \"%s\",\n", COUNTER);
+#else
+	printf("  \"counter\": null,\n");
+#endif
+	printf("  \"default_kernel\": \"%s\",\n", initial);
+	printf("  \"results\": [");
+
+	for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+		if (only && strcmp(only, kernels[k]))
+			continue;
+		if (keccak_select(kernels[k]))
+			bench_kernel(kernels[k], mem, max, target);
+	}
+
+	printf("\n  ]\n}\n");
+	keccak_select(initial);
+	free(mem);
+	return 0;
+}
@@ -0,0 +1,154 @@
+/* SPDX-License-Identifier: 0BSD
+ *
+ * Copyright © 2022 Alex Minghella <a@minghella.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Checks of the C++ interface.
+ *
+ * The compile-time digests are checked against FIPS 202 vectors with
+ * static_assert, so a wrong constexpr permutation fails the build. At run
+ * time, sha3::hasher<> and sha3::digest<>() are checked against the digests
+ * computed at compile time and against the C API for messages either side of
+ * the block sizes. The C API itself is checked by sha3-check.
+ */
+
+#include "sha3.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+constexpr unsigned hexval(char c)
+{
+	return c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+}
+
+template <std::size_t N>
+constexpr std::array<std::byte, N / 2> hex(const char (&s)[N + 1])
+{
+	std::array<std::byte, N / 2> a{};
+	for (std::size_t i = 0; i < N / 2; i++)
+		a[i] = std::byte(hexval(s[2 * i]) << 4 | hexval(s[2 * i + 1]));
+	return a;
+}
+
+static_assert(sha3::digest<256>("") == hex<64>(
+	"a7ffc6f8bf1ed76651c14756a061d662f580ff4de43b49fa82d80a4b80f8434a"));
+static_assert(sha3::digest<256>("abc") == hex<64>(
+	"3a985da74fe225b2045c172d6bd390bd855f086e3e9d525b46bfe24511431532"));
+static_assert(sha3::digest<512>("abc") == hex<128>(
+	"b751850b1a57168a5693cd924b6b096e08f621827444f70d884f5d0240d2712e"
+	"10e116e9192af3c91a7ec57647e3934057340b4cf408d5a56592f8274eec53f0"));
+
+/*
+ * Messages of 00 01 02 ... long enough for several blocks at every rate.
+ */
+constexpr std::size_t max_len = 1000;
+
+constexpr std::array<std::byte, max_len> seq = [] {
+	std::array<std::byte, max_len> a{};
+	for (std::size_t i = 0; i < max_len; i++)
+		a[i] = std::byte(i);
+	return a;
+}();
+
+unsigned tests;
+unsigned failures;
+
+void report(unsigned bits, std::size_t len, const char *how, bool ok)
+{
+	tests++;
+	if (!ok) {
+		failures++;
+		std::printf("FAIL: SHA3-%u of %zu bytes, %s\n", bits, len, how);
+	}
+}
+
+void oneshot(unsigned bits, const void *buf, std::size_t len, void *md)
+{
+	switch (bits) {
+	case 224:
+		sha3_224(buf, len, md);
+		break;
+	case 256:
+		sha3_256(buf, len, md);
+		break;
+	case 384:
+		sha3_384(buf, len, md);
+		break;
+	case 512:
+		sha3_512(buf, len, md);
+		break;
+	}
+}
+
+template <unsigned Bits>
+void check(const std::array<std::byte, Bits / 8> &whole)
+{
+	std::span<const std::byte> m(seq);
+	std::array<std::byte, Bits / 8> want;
+
+	oneshot(Bits, m.data(), m.size(), want.data());
+	report(Bits, m.size(), "constexpr digest<>()", whole == want);
+
+	for (std::size_t len = 0; len <= max_len; len += 17) {
+		auto part = m.first(len);
+		oneshot(Bits, part.data(), len, want.data());
+
+		report(Bits, len, "digest<>()",
+		       sha3::digest<Bits>(part) == want);
+
+		sha3::hasher<Bits> h;
+		h.update(part.first(len / 3)).update(part.subspan(len / 3));
+		sha3::hasher<Bits> copy = h;
+		report(Bits, len, "hasher<>", h.final() == want);
+		report(Bits, len, "copied hasher<>", copy.final() == want);
+
+		h.reset();
+		h.update(std::string_view(
+			reinterpret_cast<const char *>(part.data()), len));
+		report(Bits, len, "hasher<> from a string_view",
+		       h.final() == want);
+	}
+}
+
+} /* namespace */
+
+int main()
+{
+	const char *want = std::getenv("SHA3_KERNEL");
+	const char *kernel = sha3_kernel();
+
+	if (want && std::strcmp(want, kernel)) {
+		std::printf("%s: not supported, skipped\n", want);
+		return 0;
+	}
+
+	constexpr std::span<const std::byte> m(seq);
+	constexpr auto md224 = sha3::digest<224>(m);
+	constexpr auto md256 = sha3::digest<256>(m);
+	constexpr auto md384 = sha3::digest<384>(m);
+	constexpr auto md512 = sha3::digest<512>(m);
+
+	check<224>(md224);
+	check<256>(md256);
+	check<384>(md384);
+	check<512>(md512);
+
+	std::printf("%s, C++: %u tests, %u failed\n", kernel, tests, failures);
+	return failures != 0;
+}
@@ -0,0 +1,1851 @@
+/* SPDX-License-Identifier: 0BSD
+ *
+ * Copyright © 2022 Alex Minghella <a@minghella.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Known-answer tests.
+ *
+ * Each part of the library is checked against the sample vectors of FIPS 202,
+ * SP 800-185, and RFC 9861 where there are any, and otherwise against the same
+ * computation done by hand with functions that are already checked. Each is
+ * checked through every entry point that can compute it, with input and output
+ * split at awkward boundaries and with unaligned buffers. Only the public API
+ * is used, and the expected values are byte strings, so the results don't
+ * depend on the host's byte order.
+ *
+ * One run tests the kernel set selected when the library was loaded. `make
+ * check` runs it once for each kernel set with SHA3_KERNEL set, and a kernel
+ * set that the CPU doesn't support is reported and skipped. Failures are
+ * written to standard output and the exit status is 1 if there were any.
+ *
+ * It's also built with SHA3_IMPLEMENTATION, as sha3-check-inline, so that the
+ * same checks go through the inline functions of sha3-inline.h.
+ */
+
+#include "sha3.h"
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*
+ * Vectors with output longer than MAX_OUT bytes aren't supported.
+ */
+#define MAX_OUT 10032
+
+/*
+ * Batches are BATCH messages, enough for a full group of eight and one more.
+ */
+#define BATCH 9
+
+/**
+ * struct msg - A test message.
+ *
+ * @hex:  The message in hexadecimal, or NULL if it's a pattern.
+ * @len:  Length of the pattern in bytes.
+ * @mod:  Byte i of the pattern is i % @mod, or @fill if @mod is zero.
+ * @fill: Fill byte of the pattern.
+ *
+ * SEQ() is the 00 01 02 ... pattern of the SP 800-185 samples and PTN() is
+ * the ptn() pattern of RFC 9861.
+ */
+struct msg {
+	const char *hex;
+	size_t len;
+	unsigned mod;
+	uint8_t fill;
+};
+
+#define HEX(s)    { (s), 0, 0, 0 }
+#define SEQ(n)    { NULL, (n), 256, 0 }
+#define PTN(n)    { NULL, (n), 251, 0 }
+#define REP(b, n) { NULL, (n), 0, (b) }
+
+/*
+ * Steps that input is absorbed and output is read in, where zero means all of
+ * it at once. They fall on and either side of lane boundaries and straddle
+ * the SHA3-512 rate.
+ */
+static const size_t steps[] = { 0, 1, 5, 8, 13, 71 };
+
+#define STEPS (sizeof(steps) / sizeof(steps[0]))
+
+static struct sha3_pool *pool;
+static unsigned tests;
+static unsigned failures;
+static uint8_t out[MAX_OUT];
+
+static size_t step_len(size_t step, size_t left)
+{
+	return step && step < left ? step : left;
+}
+
+static unsigned hexval(char c)
+{
+	return c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+}
+
+static uint8_t hexbyte(const char *s)
+{
+	return hexval(s[0]) << 4 | hexval(s[1]);
+}
+
+/*
+ * Returns an allocated copy of @m, placed @off bytes past an 8-byte boundary,
+ * and writes its length to @len. The caller frees the returned pointer minus
+ * @off.
+ */
+static uint8_t *msg_make(const struct msg *m, size_t off, size_t *len)
+{
+	size_t n = m->hex ? strlen(m->hex) / 2 : m->len;
+	uint8_t *p = malloc(n + off + 8);
+	if (!p) {
+		perror("malloc");
+		exit(2);
+	}
+
+	p += off;
+	for (size_t i = 0; i < n; i++) {
+		if (m->hex)
+			p[i] = hexbyte(m->hex + 2 * i);
+		else
+			p[i] = m->mod ? i % m->mod : m->fill;
+	}
+
+	*len = n;
+	return p;
+}
+
+/*
+ * Counts a test of vector @i of @what computed with @how, and reports it as a
+ * failure unless @ok.
+ */
+static void report(const char *what, size_t i, const char *how, bool ok)
+{
+	tests++;
+	if (!ok) {
+		failures++;
+		printf("FAIL: %s %zu, %s\n", what, i, how);
+	}
+}
+
+/*
+ * Checks that the last strlen(@md) / 2 bytes of the @len bytes at @buf are
+ * @md.
+ */
+static void expect(const char *what, size_t i, const char *how,
+                   const uint8_t *buf, size_t len, const char *md)
+{
+	size_t n = strlen(md) / 2;
+	bool ok = n <= len;
+
+	buf += len - n;
+	for (size_t j = 0; ok && j < n; j++)
+		ok = buf[j] == hexbyte(md + 2 * j);
+
+	report(what, i, how, ok);
+}
+
+static void update(struct sha3_ctx *ctx, size_t step, const uint8_t *buf,
+                   size_t len)
+{
+	for (size_t off = 0, n; off < len; off += n) {
+		n = step_len(step, len - off);
+		sha3_update(ctx, buf + off, n);
+	}
+}
+
+static void squeeze(struct sha3_ctx *ctx, size_t step, size_t outlen)
+{
+	for (size_t off = 0, n; off < outlen; off += n) {
+		n = step_len(step, outlen - off);
+		shake_squeeze(ctx, out + off, n);
+	}
+}
+
+/*
+ * Splits @len bytes at @buf into at most @max buffers of irregular sizes,
+ * some of them empty, and returns the number of buffers.
+ */
+static int split(struct iovec *iov, int max, const uint8_t *buf, size_t len)
+{
+	static const size_t sizes[] = { 3, 0, 1, 9, 8, 29, 0, 64, 2, 7 };
+	int n = 0;
+
+	for (size_t off = 0; n < max - 1 && off < len; n++) {
+		size_t k = step_len(sizes[n % 10], len - off);
+		iov[n].iov_base = (void *)(buf + off);
+		iov[n].iov_len = k;
+		off += k;
+		if (n == max - 2 && off < len) {
+			iov[++n].iov_base = (void *)(buf + off);
+			iov[n].iov_len = len - off;
+		}
+	}
+
+	return n;
+}
+
+/*
+ * KECCAK-f[1600] and KECCAK-p[1600, 12] applied to the all-zero state.
+ */
+static const uint64_t p1600_24[25] = {
+	UINT64_C(0xf1258f7940e1dde7), UINT64_C(0x84d5ccf933c0478a),
+	UINT64_C(0xd598261ea65aa9ee), UINT64_C(0xbd1547306f80494d),
+	UINT64_C(0x8b284e056253d057), UINT64_C(0xff97a42d7f8e6fd4),
+	UINT64_C(0x90fee5a0a44647c4), UINT64_C(0x8c5bda0cd6192e76),
+	UINT64_C(0xad30a6f71b19059c), UINT64_C(0x30935ab7d08ffc64),
+	UINT64_C(0xeb5aa93f2317d635), UINT64_C(0xa9a6e6260d712103),
+	UINT64_C(0x81a57c16dbcf555f), UINT64_C(0x43b831cd0347c826),
+	UINT64_C(0x01f22f1a11a5569f), UINT64_C(0x05e5635a21d9ae61),
+	UINT64_C(0x64befef28cc970f2), UINT64_C(0x613670957bc46611),
+	UINT64_C(0xb87c5a554fd00ecb), UINT64_C(0x8c3ee88a1ccf32c8),
+	UINT64_C(0x940c7922ae3a2614), UINT64_C(0x1841f924a2c509e4),
+	UINT64_C(0x16f53526e70465c2), UINT64_C(0x75f644e97f30a13b),
+	UINT64_C(0xeaf1ff7b5ceca249),
+};
+
+static const uint64_t p1600_12[25] = {
+	UINT64_C(0x8e5e5438b9a78617), UINT64_C(0xd9cd6a50f259d01e),
+	UINT64_C(0x87b8e7c652a91f35), UINT64_C(0x1093e067cde4e0c5),
+	UINT64_C(0xb033ab90f2d95a45), UINT64_C(0xe0a72f72a8dd1a45),
+	UINT64_C(0xc53780aa14672f9c), UINT64_C(0x3edd47f50051071d),
+	UINT64_C(0xb3a31d310c178acc), UINT64_C(0x79b586a59257aaa0),
+	UINT64_C(0xbc4a7c3db3b1f99b), UINT64_C(0x68874063e68a6793),
+	UINT64_C(0x5c6c03332e0e2566), UINT64_C(0x9caa1202b9f030da),
+	UINT64_C(0x5f3b9a782bcf7a9f), UINT64_C(0xe536c1e061ae7923),
+	UINT64_C(0x6de9b618b73c87ec), UINT64_C(0x2abed1f170918ac2),
+	UINT64_C(0x6aabbd53daed24b7), UINT64_C(0xbfc1416a2c2ee15a),
+	UINT64_C(0xc6cfe036b90952af), UINT64_C(0x45503617dc7060d7),
+	UINT64_C(0x625611b2c29f7ae4), UINT64_C(0xd43671db2c30647a),
+	UINT64_C(0xcffd0d76222ca01c),
+};
+
+static void check_p1600(void)
+{
+	uint64_t state[25];
+
+	memset(state, 0, sizeof(state));
+	keccak_p1600(state, 24);
+	report("KECCAK-f[1600]", 0, "keccak_p1600()",
+	       !memcmp(state, p1600_24, sizeof(state)));
+
+	memset(state, 0, sizeof(state));
+	keccak_p1600(state, 12);
+	report("KECCAK-p[1600, 12]", 0, "keccak_p1600()",
+	       !memcmp(state, p1600_12, sizeof(state)));
+}
+
+/**
+ * struct sha3_kat - SHA-3 vector.
+ *
+ * @algo: Algorithm.
+ * @m:    Message.
+ * @md:   Digest in hexadecimal.
+ */
+struct sha3_kat {
+	enum sha3_algo algo;
+	struct msg m;
+	const char *md;
+};
+
+static const struct sha3_kat sha3_kats[] = {
+	{ SHA3_224, HEX(""),
+	  "6b4e03423667dbb73b6e15454f0eb1abd4597f9a1b078e3f5b5a6bc7" },
+	{ SHA3_224, HEX("616263"),
+	  "e642824c3f8cf24ad09234ee7d3c766fc9a3a5168d0c94ad73b46fdf" },
+	{ SHA3_224, REP(0xa3, 200),
+	  "9376816aba503f72f96ce7eb65ac095deee3be4bf9bbc2a1cb7e11e0" },
+	{ SHA3_224, PTN(1000),
+	  "51481b8dbd6b73dd110a967f438aa22facfcdce1eb5d2b36a5ec023f" },
+	{ SHA3_256, HEX(""),
+	  "a7ffc6f8bf1ed76651c14756a061d662f580ff4de43b49fa82d80a4b80f8434a" },
+	{ SHA3_256, HEX("616263"),
+	  "3a985da74fe225b2045c172d6bd390bd855f086e3e9d525b46bfe24511431532" },
+	{ SHA3_256, REP(0xa3, 200),
+	  "79f38adec5c20307a98ef76e8324afbfd46cfd81b22e3973c65fa1bd9de31787" },
+	{ SHA3_256, PTN(1000),
+	  "48e66a01861d0eadaacdb7a6ae7db6b9ac79242ecced4154a9fbb33c4e3cc571" },
+	{ SHA3_384, HEX(""),
+	  "0c63a75b845e4f7d01107d852e4c2485c51a50aaaa94fc61995e71bbee983a2a"
+	  "c3713831264adb47fb6bd1e058d5f004" },
+	{ SHA3_384, HEX("616263"),
+	  "ec01498288516fc926459f58e2c6ad8df9b473cb0fc08c2596da7cf0e49be4b2"
+	  "98d88cea927ac7f539f1edf228376d25" },
+	{ SHA3_384, REP(0xa3, 200),
+	  "1881de2ca7e41ef95dc4732b8f5f002b189cc1e42b74168ed1732649ce1dbcdd"
+	  "76197a31fd55ee989f2d7050dd473e8f" },
+	{ SHA3_384, PTN(1000),
+	  "43e60a7ef818a0e367fcd4ede8f5fabbdb7090cb45972bb7a84038cc3abf4fc2"
+	  "6c4f44b59d3a0306c973b66e84c8890b" },
+	{ SHA3_512, HEX(""),
+	  "a69f73cca23a9ac5c8b567dc185a756e97c982164fe25859e0d1dcc1475c80a6"
+	  "15b2123af1f5f94c11e3e9402c3ac558f500199d95b6d3e301758586281dcd26" },
+	{ SHA3_512, HEX("616263"),
+	  "b751850b1a57168a5693cd924b6b096e08f621827444f70d884f5d0240d2712e"
+	  "10e116e9192af3c91a7ec57647e3934057340b4cf408d5a56592f8274eec53f0" },
+	{ SHA3_512, REP(0xa3, 200),
+	  "e76dfad22084a8b1467fcf2ffa58361bec7628edf5f3fdc0e4805dc48caeeca8"
+	  "1b7c13c30adf52a3659584739a2df46be589c51ca1a4a8416df6545a1ce8ba00" },
+	{ SHA3_512, PTN(1000),
+	  "b8030d306ae990bc794bfb3a6100f67851889d6c272257afac7d1077a18660d6"
+	  "ea8d0da5d2299c3ebaa0d34baf62cc58ac1fd4476506cf512a4897bb083a6fc4" },
+};
+
+static void oneshot(enum sha3_algo algo, const uint8_t *buf, size_t len,
+                    void *md)
+{
+	switch (algo) {
+	case SHA3_224:
+		sha3_224(buf, len, md);
+		break;
+	case SHA3_256:
+		sha3_256(buf, len, md);
+		break;
+	case SHA3_384:
+		sha3_384(buf, len, md);
+		break;
+	case SHA3_512:
+		sha3_512(buf, len, md);
+		break;
+	}
+}
+
+static void oneshot_short(enum sha3_algo algo, const uint8_t *buf, size_t len,
+                          void *md)
+{
+	switch (algo) {
+	case SHA3_224:
+		sha3_224_short(buf, len, md);
+		break;
+	case SHA3_256:
+		sha3_256_short(buf, len, md);
+		break;
+	case SHA3_384:
+		sha3_384_short(buf, len, md);
+		break;
+	case SHA3_512:
+		sha3_512_short(buf, len, md);
+		break;
+	}
+}
+
+static void check_sha3(void)
+{
+	static uint8_t outs[BATCH * 64];
+
+	for (size_t i = 0; i < sizeof(sha3_kats) / sizeof(sha3_kats[0]); i++) {
+		const struct sha3_kat *k = &sha3_kats[i];
+		struct sha3_ctx ctx;
+		size_t len;
+		uint8_t *m = msg_make(&k->m, 0, &len);
+		uint8_t *u = msg_make(&k->m, 3, &len);
+		size_t size = k->algo;
+		size_t half = len / 2;
+
+		for (size_t j = 0; j < STEPS; j++) {
+			sha3_init(&ctx, k->algo);
+			update(&ctx, steps[j], m, len);
+			sha3_final(&ctx, out);
+			expect("SHA-3", i, "sha3_update()", out, size, k->md);
+
+			sha3_init(&ctx, k->algo);
+			update(&ctx, steps[j], u, len);
+			sha3_final(&ctx, out);
+			expect("SHA-3", i, "unaligned sha3_update()", out, size,
+			       k->md);
+		}
+
+		struct iovec iov[128];
+		sha3_init(&ctx, k->algo);
+		sha3_updatev(&ctx, iov, split(iov, 128, u, len));
+		sha3_final(&ctx, out);
+		expect("SHA-3", i, "sha3_updatev()", out, size, k->md);
+
+		oneshot(k->algo, u, len, out);
+		expect("SHA-3", i, "one-shot", out, size, k->md);
+
+		oneshot_short(k->algo, u, len, out);
+		expect("SHA-3", i, "one-shot short", out, size, k->md);
+
+		uint8_t exp[SHA3_EXPORT_SIZE];
+		sha3_init(&ctx, k->algo);
+		sha3_update(&ctx, m, half);
+		sha3_export(&ctx, exp);
+		memset(&ctx, 0, sizeof(ctx));
+		if (sha3_import(&ctx, exp))
+			memset(&ctx, 0, sizeof(ctx));
+		sha3_update(&ctx, m + half, len - half);
+		sha3_final(&ctx, out);
+		expect("SHA-3", i, "sha3_export()", out, size, k->md);
+
+		struct keccak_sponge s;
+		keccak_sponge_init(&s, 200 - 2 * size, 0x06, 24);
+		keccak_sponge_absorb(&s, m, half);
+		keccak_sponge_absorb(&s, m + half, len - half);
+		keccak_sponge_squeeze(&s, out, 1);
+		keccak_sponge_squeeze(&s, out + 1, size - 1);
+		expect("SHA-3", i, "keccak_sponge", out, size, k->md);
+
+		const void *full[BATCH], *rest[BATCH];
+		for (size_t j = 0; j < BATCH; j++) {
+			full[j] = j & 1 ? u : m;
+			rest[j] = (j & 1 ? u : m) + half;
+		}
+
+		struct sha3_ctx_x4 x4;
+		void *md[8];
+		for (size_t j = 0; j < 8; j++)
+			md[j] = outs + j * 64;
+
+		memset(outs, 0, sizeof(outs));
+		sha3_init_x4(&x4, k->algo);
+		sha3_update_x4(&x4, full, 0);
+		sha3_update_x4(&x4, full, half);
+		sha3_update_x4(&x4, rest, len - half);
+		sha3_final_x4(&x4, md);
+		for (size_t j = 0; j < 4; j++)
+			expect("SHA-3", i, "sha3_update_x4()", md[j], size,
+			       k->md);
+
+		struct sha3_ctx_x8 x8;
+		memset(outs, 0, sizeof(outs));
+		sha3_init_x8(&x8, k->algo);
+		sha3_update_x8(&x8, full, half);
+		sha3_update_x8(&x8, rest, len - half);
+		sha3_final_x8(&x8, md);
+		for (size_t j = 0; j < 8; j++)
+			expect("SHA-3", i, "sha3_update_x8()", md[j], size,
+			       k->md);
+
+		size_t lens[BATCH];
+		for (size_t j = 0; j < BATCH; j++)
+			lens[j] = len;
+
+		memset(outs, 0, sizeof(outs));
+		sha3_hash_many(k->algo, full, lens, BATCH, outs);
+		for (size_t j = 0; j < BATCH; j++)
+			expect("SHA-3", i, "sha3_hash_many()", outs + j * size,
+			       size, k->md);
+
+		struct sha3_ctx mid;
+		sha3_init(&mid, k->algo);
+		sha3_update(&mid, m, half);
+
+		sha3_ctx_clone(&ctx, &mid);
+		sha3_update(&ctx, u + half, len - half);
+		sha3_final(&ctx, out);
+		expect("SHA-3", i, "sha3_ctx_clone()", out, size, k->md);
+
+		size_t rlens[BATCH];
+		for (size_t j = 0; j < BATCH; j++)
+			rlens[j] = len - half;
+
+		memset(outs, 0, sizeof(outs));
+		sha3_hash_many_from(&mid, rest, rlens, BATCH, outs);
+		for (size_t j = 0; j < BATCH; j++)
+			expect("SHA-3", i, "sha3_hash_many_from()",
+			       outs + j * size, size, k->md);
+
+		memset(outs, 0, sizeof(outs));
+		if (!sha3_init_x4_from(&x4, &mid)) {
+			sha3_update_x4(&x4, rest, len - half);
+			sha3_final_x4(&x4, md);
+		}
+		for (size_t j = 0; j < 4; j++)
+			expect("SHA-3", i, "sha3_init_x4_from()", md[j], size,
+			       k->md);
+
+		memset(outs, 0, sizeof(outs));
+		if (!sha3_init_x8_from(&x8, &mid)) {
+			sha3_update_x8(&x8, rest, len - half);
+			sha3_final_x8(&x8, md);
+		}
+		for (size_t j = 0; j < 8; j++)
+			expect("SHA-3", i, "sha3_init_x8_from()", md[j], size,
+			       k->md);
+
+		free(m);
+		free(u - 3);
+	}
+}
+
+/**
+ * struct shake_kat - SHAKE vector.
+ *
+ * @algo:   Algorithm.
+ * @m:      Message.
+ * @outlen: Output length in bytes.
+ * @md:     The end of the output in hexadecimal.
+ */
+struct shake_kat {
+	enum shake_algo algo;
+	struct msg m;
+	size_t outlen;
+	const char *md;
+};
+
+static const struct shake_kat shake_kats[] = {
+	{ SHAKE128, HEX(""), 32,
+	  "7f9c2ba4e88f827d616045507605853ed73b8093f6efbc88eb1a6eacfa66ef26" },
+	{ SHAKE128, HEX(""), 512,
+	  "43e41b45a653f2a5c4492c1add544512dda2529833462b71a41a45be97290b6f" },
+	{ SHAKE128, REP(0xa3, 200), 32,
+	  "131ab8d2b594946b9c81333f9bb6e0ce75c3b93104fa3469d3917457385da037" },
+	{ SHAKE128, REP(0xa3, 200), 512,
+	  "44c9fb359fd56ac0a9a75a743cff6862f17d7259ab075216c0699511643b6439" },
+	{ SHAKE256, HEX(""), 32,
+	  "46b9dd2b0ba88d13233b3feb743eeb243fcd52ea62b81b82b50c27646ed5762f" },
+	{ SHAKE256, HEX(""), 512,
+	  "ab0bae316339894304e35877b0c28a9b1fd166c796b9cc258a064a8f57e27f2a" },
+	{ SHAKE256, REP(0xa3, 200), 32,
+	  "cd8a920ed141aa0407a22d59288652e9d9f1a7ee0c1e7c1ca699424da84a904d" },
+	{ SHAKE256, REP(0xa3, 200), 512,
+	  "6a1a9d7846436e4dca5728b6f760eef0ca92bf0be5615e96959d767197a0beeb" },
+};
+
+static void check_shake(void)
+{
+	size_t n = sizeof(shake_kats) / sizeof(shake_kats[0]);
+
+	for (size_t i = 0; i < n; i++) {
+		const struct shake_kat *k = &shake_kats[i];
+		struct sha3_ctx ctx;
+		size_t len;
+		uint8_t *m = msg_make(&k->m, 5, &len);
+
+		for (size_t j = 0; j < STEPS; j++) {
+			shake_init(&ctx, k->algo);
+			update(&ctx, steps[j], m, len);
+			shake_final(&ctx);
+			squeeze(&ctx, steps[STEPS - 1 - j], k->outlen);
+			expect("SHAKE", i, "shake_squeeze()", out, k->outlen,
+			       k->md);
+		}
+
+		cshake_init(&ctx, k->algo, NULL, 0, NULL, 0);
+		sha3_update(&ctx, m, len);
+		shake_final(&ctx);
+		shake_squeeze(&ctx, out, k->outlen);
+		expect("SHAKE", i, "cshake_init()", out, k->outlen, k->md);
+
+		struct keccak_sponge s;
+		keccak_sponge_init(&s, 200 - 2 * k->algo, 0x1f, 24);
+		keccak_sponge_absorb(&s, m, len);
+		keccak_sponge_squeeze(&s, out, k->outlen);
+		expect("SHAKE", i, "keccak_sponge", out, k->outlen, k->md);
+
+		free(m - 5);
+	}
+}
+
+/**
+ * struct turboshake_kat - TurboSHAKE vector.
+ *
+ * @algo:   Algorithm.
+ * @m:      Message.
+ * @ds:     Domain separation byte.
+ * @outlen: Output length in bytes.
+ * @md:     The end of the output in hexadecimal.
+ */
+struct turboshake_kat {
+	enum shake_algo algo;
+	struct msg m;
+	uint8_t ds;
+	size_t outlen;
+	const char *md;
+};
+
+static const struct turboshake_kat turboshake_kats[] = {
+	{ SHAKE128, HEX(""), 0x1f, 32,
+	  "1e415f1c5983aff2169217277d17bb538cd945a397ddec541f1ce41af2c1b74c" },
+	{ SHAKE128, HEX(""), 0x1f, 10032,
+	  "a3b9b0385900ce761f22aed548e754da10a5242d62e8c658e3f3a923a7555607" },
+	{ SHAKE128, PTN(1), 0x1f, 32,
+	  "55cedd6f60af7bb29a4042ae832ef3f58db7299f893ebb9247247d856958daa9" },
+	{ SHAKE128, PTN(17), 0x1f, 32,
+	  "9c97d036a3bac819db70ede0ca554ec6e4c2a1a4ffbfd9ec269ca6a111161233" },
+	{ SHAKE128, PTN(289), 0x1f, 32,
+	  "96c77c279e0126f7fc07c9b07f5cdae1e0be60bdbe10620040e75d7223a624d2" },
+	{ SHAKE128, PTN(4913), 0x1f, 32,
+	  "d4976eb56bcf118520582b709f73e1d6853e001fdaf80e1b13e0d0599d5fb372" },
+	{ SHAKE128, PTN(83521), 0x1f, 32,
+	  "da67c7039e98bf530cf7a37830c6664e14cbab7f540f58403b1b82951318ee5c" },
+	{ SHAKE128, HEX("ffffff"), 0x01, 32,
+	  "bf323f940494e88ee1c540fe660be8a0c93f43d15ec006998462fa994eed5dab" },
+	{ SHAKE128, HEX("ff"), 0x06, 32,
+	  "8ec9c66465ed0d4a6c35d13506718d687a25cb05c74cca1e42501abd83874a67" },
+	{ SHAKE128, HEX("ffffff"), 0x07, 32,
+	  "b658576001cad9b1e5f399a9f77723bba05458042d68206f7252682dba3663ed" },
+	{ SHAKE128, HEX("ffffffffffffff"), 0x0b, 32,
+	  "8deeaa1aec47ccee569f659c21dfa8e112db3cee37b18178b2acd805b799cc37" },
+	{ SHAKE128, HEX("ff"), 0x30, 32,
+	  "553122e2135e363c3292bed2c6421fa232bab03daa07c7d6636603286506325b" },
+	{ SHAKE128, HEX("ffffff"), 0x7f, 32,
+	  "16274cc656d44cefd422395d0f9053bda6d28e122aba15c765e5ad0e6eaf26f9" },
+	{ SHAKE256, HEX(""), 0x1f, 64,
+	  "367a329dafea871c7802ec67f905ae13c57695dc2c6663c61035f59a18f8e7db"
+	  "11edc0e12e91ea60eb6b32df06dd7f002fbafabb6e13ec1cc20d995547600db0" },
+	{ SHAKE256, HEX(""), 0x1f, 10032,
+	  "abefa11630c661269249742685ec082f207265dccf2f43534e9c61ba0c9d1d75" },
+	{ SHAKE256, PTN(1), 0x1f, 32,
+	  "3e1712f928f8eaf1054632b2aa0a246ed8b0c378728f60bc970410155c28820e" },
+	{ SHAKE256, PTN(17), 0x1f, 32,
+	  "b3bab0300e6a191fbe6137939835923578794ea54843f5011090fa2f3780a9e5" },
+	{ SHAKE256, PTN(289), 0x1f, 32,
+	  "66b810db8e90780424c0847372fdc95710882fde31c6df75beb9d4cd9305cfca" },
+	{ SHAKE256, PTN(4913), 0x1f, 32,
+	  "c74ebc919a5b3b0dd1228185ba02d29ef442d69d3d4276a93efe0bf9a16a7dc0" },
+	{ SHAKE256, PTN(83521), 0x1f, 32,
+	  "02cc3a8897e6f4f6ccb6fd46631b1f5207b66c6de9c7b55b2d1a23134a170afd" },
+	{ SHAKE256, HEX("ffffff"), 0x01, 32,
+	  "d21c6fbbf587fa2282f29aea620175fb0257413af78a0b1b2a87419ce031d933" },
+	{ SHAKE256, HEX("ff"), 0x06, 32,
+	  "738d7b4e37d18b7f22ad1b5313e357e3dd7d07056a26a303c433fa3533455280" },
+	{ SHAKE256, HEX("ffffff"), 0x07, 32,
+	  "18b3b5b7061c2e67c1753a00e6ad7ed7ba1c906cf93efb7092eaf27fbeebb755" },
+	{ SHAKE256, HEX("ffffffffffffff"), 0x0b, 32,
+	  "bb36764951ec97e9d85f7ee9a67a7718fc005cf42556be79ce12c0bde50e5736" },
+	{ SHAKE256, HEX("ff"), 0x30, 32,
+	  "f3fe12873d34bcbb2e608779d6b70e7f86bec7e90bf113cbd4fdd0c4e2f4625e" },
+	{ SHAKE256, HEX("ffffff"), 0x7f, 32,
+	  "abe569c1f77ec340f02705e7d37c9ab7e155516e4a6a150021d70b6fac0bb40c" },
+};
+
+static void check_turboshake(void)
+{
+	size_t n = sizeof(turboshake_kats) / sizeof(turboshake_kats[0]);
+
+	for (size_t i = 0; i < n; i++) {
+		const struct turboshake_kat *k = &turboshake_kats[i];
+		struct sha3_ctx ctx;
+		size_t len;
+		uint8_t *m = msg_make(&k->m, 1, &len);
+
+		for (size_t j = 0; j < STEPS; j++) {
+			turboshake_init(&ctx, k->algo);
+			update(&ctx, steps[j], m, len);
+			turboshake_final(&ctx, k->ds);
+			squeeze(&ctx, steps[j], k->outlen);
+			expect("TurboSHAKE", i, "shake_squeeze()", out,
+			       k->outlen, k->md);
+		}
+
+		struct keccak_sponge s;
+		keccak_sponge_init(&s, 200 - 2 * k->algo, k->ds, 12);
+		keccak_sponge_absorb(&s, m, len);
+		keccak_sponge_squeeze(&s, out, k->outlen);
+		expect("TurboSHAKE", i, "keccak_sponge", out, k->outlen, k->md);
+
+		free(m - 1);
+	}
+}
+
+/**
+ * struct k12_kat - KangarooTwelve vector.
+ *
+ * @algo:   Algorithm.
+ * @m:      Message.
+ * @c:      Customisation string.
+ * @outlen: Output length in bytes.
+ * @md:     The end of the output in hexadecimal.
+ */
+struct k12_kat {
+	enum k12_algo algo;
+	struct msg m;
+	struct msg c;
+	size_t outlen;
+	const char *md;
+};
+
+static const struct k12_kat k12_kats[] = {
+	{ KT128, HEX(""), HEX(""), 32,
+	  "1ac2d450fc3b4205d19da7bfca1b37513c0803577ac7167f06fe2ce1f0ef39e5" },
+	{ KT128, HEX(""), HEX(""), 10032,
+	  "e8dc563642f7228c84684c898405d3a834799158c079b12880277a1d28e2ff6d" },
+	{ KT128, PTN(1), HEX(""), 32,
+	  "2bda92450e8b147f8a7cb629e784a058efca7cf7d8218e02d345dfaa65244a1f" },
+	{ KT128, PTN(17), HEX(""), 32,
+	  "6bf75fa2239198db4772e36478f8e19b0f371205f6a9a93a273f51df37122888" },
+	{ KT128, PTN(289), HEX(""), 32,
+	  "0c315ebcdedbf61426de7dcf8fb725d1e74675d7f5327a5067f367b108ecb67c" },
+	{ KT128, PTN(4913), HEX(""), 32,
+	  "cb552e2ec77d9910701d578b457ddf772c12e322e4ee7fe417f92c758f0d59d0" },
+	{ KT128, PTN(83521), HEX(""), 32,
+	  "8701045e22205345ff4dda05555cbb5c3af1a771c2b89baef37db43d9998b9fe" },
+	{ KT128, HEX(""), PTN(1), 32,
+	  "fab658db63e94a246188bf7af69a133045f46ee984c56e3c3328caaf1aa1a583" },
+	{ KT128, HEX("ff"), PTN(41), 32,
+	  "d848c5068ced736f4462159b9867fd4c20b808acc3d5bc48e0b06ba0a3762ec4" },
+	{ KT128, HEX("ffffff"), PTN(1681), 32,
+	  "c389e5009ae57120854c2e8c64670ac01358cf4c1baf89447a724234dc7ced74" },
+	{ KT128, HEX("ffffffffffffff"), PTN(68921), 32,
+	  "75d2f86a2e644566726b4fbcfc5657b9dbcf070c7b0dca06450ab291d7443bcf" },
+	{ KT128, PTN(8191), PTN(8), 32,
+	  "0b8c314f210b7a08c08e5246de8f9551929666c011a09e2c6bf71c5c33d80852" },
+	{ KT128, PTN(8192), PTN(8), 32,
+	  "ca124bb9c0bcb2fbd0c1627abd5bdfd2536e61e20bd4751850348d9f48ed695b" },
+	{ KT128, PTN(8192), PTN(8189), 32,
+	  "3ed12f70fb05ddb58689510ab3e4d23c6c6033849aa01e1d8c220a297fedcd0b" },
+	{ KT128, PTN(8192), PTN(8190), 32,
+	  "6a7c1b6a5cd0d8c9ca943a4a216cc64604559a2ea45f78570a15253d67ba00ae" },
+	{ KT256, HEX(""), HEX(""), 64,
+	  "b23d2e9cea9f4904e02bec06817fc10ce38ce8e93ef4c89e6537076af8646404"
+	  "e3e8b68107b8833a5d30490aa33482353fd4adc7148ecb782855003aaebde4a9" },
+	{ KT256, HEX(""), HEX(""), 10032,
+	  "ad4a1d718cf950506709a4c33396139b4449041fc79a05d68da35f1e453522e0" },
+	{ KT256, PTN(1), HEX(""), 64,
+	  "0d005a194085360217128cf17f91e1f71314efa5564539d444912e3437efa17f"
+	  "82db6f6ffe76e781eaa068bce01f2bbf81eacb983d7230f2fb02834a21b1ddd0" },
+	{ KT256, PTN(17), HEX(""), 64,
+	  "1ba3c02b1fc514474f06c8979978a9056c8483f4a1b63d0dccefe3a28a2f323e"
+	  "1cdcca40ebf006ac76ef0397152346837b1277d3e7faa9c9653b19075098527b" },
+	{ KT256, PTN(289), HEX(""), 64,
+	  "de8ccbc63e0f133ebb4416814d4c66f691bbf8b6a61ec0a7700f836b086cb029"
+	  "d54f12ac7159472c72db118c35b4e6aa213c6562caaa9dcc518959e69b10f3ba" },
+	{ KT256, PTN(4913), HEX(""), 64,
+	  "647efb49fe9d717500171b41e7f11bd491544443209997ce1c2530d15eb1ffbb"
+	  "598935ef954528ffc152b1e4d731ee2683680674365cd191d562bae753b84aa5" },
+	{ KT256, PTN(83521), HEX(""), 64,
+	  "b06275d284cd1cf205bcbe57dccd3ec1ff6686e3ed15776383e1f2fa3c6ac8f0"
+	  "8bf8a162829db1a44b2a43ff83dd89c3cf1ceb61ede659766d5ccf817a62ba8d" },
+	{ KT256, HEX(""), PTN(1), 64,
+	  "9280f5cc39b54a5a594ec63de0bb99371e4609d44bf845c2f5b8c316d72b1598"
+	  "11f748f23e3fabbe5c3226ec96c62186df2d33e9df74c5069ceecbb4dd10eff6" },
+	{ KT256, HEX("ff"), PTN(41), 64,
+	  "47ef96dd616f200937aa7847e34ec2feae8087e3761dc0f8c1a154f51dc9ccf8"
+	  "45d7adbce57ff64b639722c6a1672e3bf5372d87e00aff89be97240756998853" },
+	{ KT256, HEX("ffffff"), PTN(1681), 64,
+	  "3b48667a5051c5966c53c5d42b95de451e05584e7806e2fb765eda959074172c"
+	  "b438a9e91dde337c98e9c41bed94c4e0aef431d0b64ef2324f7932caa6f54969" },
+	{ KT256, HEX("ffffffffffffff"), PTN(68921), 64,
+	  "e0911cc00025e1540831e266d94add9b98712142b80d2629e643aac4efaf5a3a"
+	  "30a88cbf4ac2a91a2432743054fbcc9897670e86ba8cec2fc2ace9c966369724" },
+	{ KT256, PTN(8191), PTN(8), 64,
+	  "49604e501677abdca8ccd4bd4f2886e19bcc82888d5f4795d9e5912d7304485e"
+	  "70983b5780a561b12f5ecbce6a415ccf4cf7ed6a739cf3f463ffa00239b9e345" },
+	{ KT256, PTN(8192), PTN(8), 64,
+	  "8b1ecd9a386d0098dcd531ca699c9c2a0681d830d3139826f03e9a36d309df2a"
+	  "9db55809866b2c0b7c3fcaae6fdbedb41ea7391661e28ed041deb12c9bec657f" },
+	{ KT256, PTN(8192), PTN(8189), 64,
+	  "74e47879f10a9c5d11bd2da7e194fe57e86378bf3c3f7448eff3c576a0f18c5c"
+	  "aae0999979512090a7f348af4260d4de3c37f1ecaf8d2c2c96c1d16c64b12496" },
+	{ KT256, PTN(8192), PTN(8190), 64,
+	  "f4b5908b929ffe01e0f79ec2f21243d41a396b2e7303a6af1d6399cd6c7a0a2d"
+	  "d7c4f607e8277f9c9b1cb4ab9ddc59d4b92d1fc7558441f1832c3279a4241b8b" },
+};
+
+static void check_k12(void)
+{
+	static const size_t k12_steps[] = { 0, 1, 8191, 8192, 10000 };
+
+	for (size_t i = 0; i < sizeof(k12_kats) / sizeof(k12_kats[0]); i++) {
+		const struct k12_kat *k = &k12_kats[i];
+		struct k12_ctx ctx;
+		size_t len, clen;
+		uint8_t *m = msg_make(&k->m, 0, &len);
+		uint8_t *c = msg_make(&k->c, 0, &clen);
+
+		k12(k->algo, m, len, c, clen, out, k->outlen, NULL);
+		expect("KangarooTwelve", i, "k12()", out, k->outlen, k->md);
+		k12(k->algo, m, len, c, clen, out, k->outlen, pool);
+		expect("KangarooTwelve", i, "k12() on a pool", out, k->outlen,
+		       k->md);
+
+		for (size_t j = 0; j < 5; j++) {
+			size_t step = k12_steps[j];
+			k12_init(&ctx, k->algo, j & 1 ? pool : NULL);
+			for (size_t off = 0, n; off < len; off += n) {
+				n = step_len(step, len - off);
+				k12_update(&ctx, m + off, n);
+			}
+			k12_final(&ctx, c, clen);
+			for (size_t off = 0, n; off < k->outlen; off += n) {
+				n = step_len(steps[j], k->outlen - off);
+				k12_squeeze(&ctx, out + off, n);
+			}
+			expect("KangarooTwelve", i, "k12_update()", out,
+			       k->outlen, k->md);
+		}
+
+		free(m);
+		free(c);
+	}
+}
+
+/**
+ * struct cshake_kat - cSHAKE vector.
+ *
+ * @algo:   Algorithm.
+ * @m:      Message.
+ * @n:      Function-name string N.
+ * @s:      Customisation string S.
+ * @outlen: Output length in bytes.
+ * @md:     Output in hexadecimal.
+ */
+struct cshake_kat {
+	enum shake_algo algo;
+	struct msg m;
+	const char *n;
+	const char *s;
+	size_t outlen;
+	const char *md;
+};
+
+static const struct cshake_kat cshake_kats[] = {
+	{ SHAKE128, SEQ(4), "", "Email Signature", 32,
+	  "c1c36925b6409a04f1b504fcbca9d82b4017277cb5ed2b2065fc1d3814d5aaf5" },
+	{ SHAKE128, SEQ(200), "", "Email Signature", 32,
+	  "c5221d50e4f822d96a2e8881a961420f294b7b24fe3d2094baed2c6524cc166b" },
+	{ SHAKE128, SEQ(200), "KMAC", "", 32,
+	  "98c27ea4580de95b02d51b59fd4fb3a963f43cbca30853aa8be9cc90a15fc3be" },
+	{ SHAKE128, SEQ(200), "", "", 32,
+	  "0c4234ca1e31801ae606f8b8d8e0665c66f42a21d601c2681858a92c79ad5d69" },
+	{ SHAKE256, SEQ(4), "", "Email Signature", 64,
+	  "d008828e2b80ac9d2218ffee1d070c48b8e4c87bff32c9699d5b6896eee0edd1"
+	  "64020e2be0560858d9c00c037e34a96937c561a74c412bb4c746469527281c8c" },
+	{ SHAKE256, SEQ(200), "", "Email Signature", 64,
+	  "07dc27b11e51fbac75bc7b3c1d983e8b4b85fb1defaf218912ac864302730917"
+	  "27f42b17ed1df63e8ec118f04b23633c1dfb1574c8fb55cb45da8e25afb092bb" },
+	{ SHAKE256, SEQ(200), "KMAC", "", 64,
+	  "5f1263983d2957241a396638216c017ba1ab60f36eed2599e7b1edd3f792287e"
+	  "e14783e1001dd22bb82575baec1c3daa235442e0cebf5e443003724d067ddd00" },
+	{ SHAKE256, SEQ(200), "", "", 64,
+	  "4ee1ca03272b05d3bfb1e1c79a967f823b9fc5e4bb3987b1ba9e9cb5afb07a5e"
+	  "e3a07fbd457a94364964a841e7f466e5a022e21ab7f673c18ba98cdb1d5aecfa" },
+};
+
+static void check_cshake(void)
+{
+	size_t n = sizeof(cshake_kats) / sizeof(cshake_kats[0]);
+
+	for (size_t i = 0; i < n; i++) {
+		const struct cshake_kat *k = &cshake_kats[i];
+		struct sha3_ctx ctx;
+		size_t len;
+		uint8_t *m = msg_make(&k->m, 7, &len);
+
+		for (size_t j = 0; j < STEPS; j++) {
+			cshake_init(&ctx, k->algo, k->n, strlen(k->n), k->s,
+			            strlen(k->s));
+			update(&ctx, steps[j], m, len);
+			shake_final(&ctx);
+			squeeze(&ctx, steps[j], k->outlen);
+			expect("cSHAKE", i, "cshake_init()", out, k->outlen,
+			       k->md);
+		}
+
+		struct sha3_ctx mid;
+		cshake_init(&mid, k->algo, k->n, strlen(k->n), k->s,
+		            strlen(k->s));
+		for (size_t j = 0; j < 2; j++) {
+			cshake(&mid, m, len, out, k->outlen);
+			expect("cSHAKE", i, "cshake()", out, k->outlen, k->md);
+		}
+
+		free(m - 7);
+	}
+}
+
+/**
+ * struct parallelhash_kat - ParallelHash vector.
+ *
+ * @algo:   Algorithm.
+ * @m:      Message.
+ * @block:  Block size B in bytes.
+ * @s:      Customisation string S.
+ * @outlen: Output length in bytes.
+ * @xof:    Whether this is ParallelHashXOF.
+ * @md:     Output in hexadecimal.
+ */
+struct parallelhash_kat {
+	enum shake_algo algo;
+	struct msg m;
+	size_t block;
+	const char *s;
+	size_t outlen;
+	bool xof;
+	const char *md;
+};
+
+static const struct parallelhash_kat parallelhash_kats[] = {
+	{ SHAKE128, HEX("000102030405060710111213141516172021222324252627"), 8,
+	  "", 32, false,
+	  "ba8dc1d1d979331d3f813603c67f72609ab5e44b94a0b8f9af46514454a2b4f5" },
+	{ SHAKE128, HEX("000102030405060710111213141516172021222324252627"), 8,
+	  "Parallel Data", 32, false,
+	  "fc484dcb3f84dceedc353438151bee58157d6efed0445a81f165e495795b7206" },
+	{ SHAKE128, PTN(10000), 1000, "Parallel Data", 32, false,
+	  "f1f54ff52e82df97798efda1e18e16523506895fdfad4cce6db1bd4d407b47f4" },
+	{ SHAKE256, HEX("000102030405060710111213141516172021222324252627"), 8,
+	  "", 64, false,
+	  "bc1ef124da34495e948ead207dd9842235da432d2bbc54b4c110e64c45110553"
+	  "1b7f2a3e0ce055c02805e7c2de1fb746af97a1dd01f43b824e31b87612410429" },
+	{ SHAKE256, HEX("000102030405060710111213141516172021222324252627"), 8,
+	  "Parallel Data", 64, false,
+	  "cdf15289b54f6212b4bc270528b49526006dd9b54e2b6add1ef6900dda3963bb"
+	  "33a72491f236969ca8afaea29c682d47a393c065b38e29fae651a2091c833110" },
+	{ SHAKE256, PTN(10000), 1000, "Parallel Data", 64, false,
+	  "e165e0a5a30a9a013afbac875dbcab18402605f329627cc267897667c1c2a031"
+	  "e40f2231b24d23ac356996c97c709f2120d6466298a6c8e56e3847a8b6ba01e5" },
+	{ SHAKE128, HEX("000102030405060710111213141516172021222324252627"), 8,
+	  "", 32, true,
+	  "fe47d661e49ffe5b7d999922c062356750caf552985b8e8ce6667f2727c3c8d3" },
+	{ SHAKE128, HEX("000102030405060710111213141516172021222324252627"), 8,
+	  "Parallel Data", 32, true,
+	  "ea2a793140820f7a128b8eb70a9439f93257c6e6e79b4a540d291d6dae7098d7" },
+	{ SHAKE128, PTN(10000), 1000, "Parallel Data", 32, true,
+	  "8634d48432b1ee37e07eba79f17f0203823dea452f845869fd32a54fc4799c4c" },
+	{ SHAKE256, HEX("000102030405060710111213141516172021222324252627"), 8,
+	  "", 64, true,
+	  "c10a052722614684144d28474850b410757e3cba87651ba167a5cbddff7f4666"
+	  "75fbf84bcae7378ac444be681d729499afca667fb879348bfdda427863c82f1c" },
+	{ SHAKE256, HEX("000102030405060710111213141516172021222324252627"), 8,
+	  "Parallel Data", 64, true,
+	  "538e105f1a22f44ed2f5cc1674fbd40be803d9c99bf5f8d90a2c8193f3fe6ea7"
+	  "68e5c1a20987e2c9c65febed03887a51d35624ed12377594b5585541dc377efc" },
+	{ SHAKE256, PTN(10000), 1000, "Parallel Data", 64, true,
+	  "83a44c2efe2f198d920350bf9061b7d95d093e69888c0442b8eddbbd2392c3f9"
+	  "d1258770fd404a2288367e6c04ed507db17ee842dbda8aa17a78d292c944101d" },
+};
+
+static void check_parallelhash(void)
+{
+	size_t n = sizeof(parallelhash_kats) / sizeof(parallelhash_kats[0]);
+
+	for (size_t i = 0; i < n; i++) {
+		const struct parallelhash_kat *k = &parallelhash_kats[i];
+		struct parallelhash_ctx ctx;
+		size_t len;
+		uint8_t *m = msg_make(&k->m, 0, &len);
+		size_t slen = strlen(k->s);
+
+		for (size_t j = 0; j < 2; j++) {
+			struct sha3_pool *p = j ? pool : NULL;
+			if (k->xof)
+				parallelhash_xof(k->algo, m, len, k->block,
+				                 k->s, slen, out, k->outlen, p);
+			else
+				parallelhash(k->algo, m, len, k->block, k->s,
+				             slen, out, k->outlen, p);
+			expect("ParallelHash", i, "parallelhash()", out,
+			       k->outlen, k->md);
+		}
+
+		for (size_t j = 0; j < STEPS; j++) {
+			size_t step = steps[j];
+			parallelhash_init(&ctx, k->algo, k->block, k->s, slen,
+			                  j & 1 ? pool : NULL);
+			for (size_t off = 0, n; off < len; off += n) {
+				n = step_len(step, len - off);
+				parallelhash_update(&ctx, m + off, n);
+			}
+			parallelhash_final(&ctx, k->xof ? 0 : k->outlen);
+			for (size_t off = 0, n; off < k->outlen; off += n) {
+				n = step_len(step, k->outlen - off);
+				parallelhash_squeeze(&ctx, out + off, n);
+			}
+			expect("ParallelHash", i, "parallelhash_update()", out,
+			       k->outlen, k->md);
+		}
+
+		free(m);
+	}
+}
+
+/**
+ * struct kmac_kat - KMAC vector, all with the key of the SP 800-185 samples.
+ *
+ * @algo:   Algorithm.
+ * @m:      Message.
+ * @s:      Customisation string S.
+ * @outlen: Output length in bytes.
+ * @xof:    Whether this is KMACXOF.
+ * @md:     Output in hexadecimal.
+ */
+struct kmac_kat {
+	enum shake_algo algo;
+	struct msg m;
+	const char *s;
+	size_t outlen;
+	bool xof;
+	const char *md;
+};
+
+static const struct msg kmac_key =
+	HEX("404142434445464748494a4b4c4d4e4f505152535455565758595a5b5c5d5e5f");
+
+static const struct kmac_kat kmac_kats[] = {
+	{ SHAKE128, SEQ(4), "", 32, false,
+	  "e5780b0d3ea6f7d3a429c5706aa43a00fadbd7d49628839e3187243f456ee14e" },
+	{ SHAKE128, SEQ(4), "My Tagged Application", 32, false,
+	  "3b1fba963cd8b0b59e8c1a6d71888b7143651af8ba0a7070c0979e2811324aa5" },
+	{ SHAKE128, SEQ(200), "My Tagged Application", 32, false,
+	  "1f5b4e6cca02209e0dcb5ca635b89a15e271ecc760071dfd805faa38f9729230" },
+	{ SHAKE256, SEQ(4), "My Tagged Application", 64, false,
+	  "20c570c31346f703c9ac36c61c03cb64c3970d0cfc787e9b79599d273a68d2f7"
+	  "f69d4cc3de9d104a351689f27cf6f5951f0103f33f4f24871024d9c27773a8dd" },
+	{ SHAKE256, SEQ(200), "", 64, false,
+	  "75358cf39e41494e949707927cee0af20a3ff553904c86b08f21cc414bcfd691"
+	  "589d27cf5e15369cbbff8b9a4c2eb17800855d0235ff635da82533ec6b759b69" },
+	{ SHAKE256, SEQ(200), "My Tagged Application", 64, false,
+	  "b58618f71f92e1d56c1b8c55ddd7cd188b97b4ca4d99831eb2699a837da2e4d9"
+	  "70fbacfde50033aea585f1a2708510c32d07880801bd182898fe476876fc8965" },
+	{ SHAKE128, SEQ(4), "", 32, true,
+	  "cd83740bbd92ccc8cf032b1481a0f4460e7ca9dd12b08a0c4031178bacd6ec35" },
+	{ SHAKE128, SEQ(4), "My Tagged Application", 32, true,
+	  "31a44527b4ed9f5c6101d11de6d26f0620aa5c341def41299657fe9df1a3b16c" },
+	{ SHAKE128, SEQ(200), "My Tagged Application", 32, true,
+	  "47026c7cd793084aa0283c253ef658490c0db61438b8326fe9bddf281b83ae0f" },
+	{ SHAKE256, SEQ(4), "My Tagged Application", 64, true,
+	  "1755133f1534752aad0748f2c706fb5c784512cab835cd15676b16c0c6647fa9"
+	  "6faa7af634a0bf8ff6df39374fa00fad9a39e322a7c92065a64eb1fb0801eb2b" },
+	{ SHAKE256, SEQ(200), "", 64, true,
+	  "ff7b171f1e8a2b24683eed37830ee797538ba8dc563f6da1e667391a75edc02c"
+	  "a633079f81ce12a25f45615ec89972031d18337331d24ceb8f8ca8e6a19fd98b" },
+	{ SHAKE256, SEQ(200), "My Tagged Application", 64, true,
+	  "d5be731c954ed7732846bb59dbe3a8e30f83e77a4bff4459f2f1c2b4ecebb8ce"
+	  "67ba01c62e8ab8578d2d499bd1bb276768781190020a306a97de281dcc30305d" },
+};
+
+static void check_kmac(void)
+{
+	static uint8_t outs[BATCH * 64];
+	size_t klen;
+	uint8_t *key = msg_make(&kmac_key, 0, &klen);
+
+	for (size_t i = 0; i < sizeof(kmac_kats) / sizeof(kmac_kats[0]); i++) {
+		const struct kmac_kat *k = &kmac_kats[i];
+		struct sha3_ctx ctx, mid;
+		size_t len;
+		uint8_t *m = msg_make(&k->m, 1, &len);
+
+		kmac_init(&mid, k->algo, key, klen, k->s, strlen(k->s));
+
+		for (size_t j = 0; j < STEPS; j++) {
+			sha3_ctx_clone(&ctx, &mid);
+			update(&ctx, steps[j], m, len);
+			kmac_final(&ctx, k->xof ? 0 : k->outlen);
+			squeeze(&ctx, steps[j], k->outlen);
+			expect("KMAC", i, "kmac_final()", out, k->outlen,
+			       k->md);
+		}
+
+		if (!k->xof) {
+			const void *bufs[BATCH];
+			size_t lens[BATCH];
+			for (size_t j = 0; j < BATCH; j++) {
+				bufs[j] = m;
+				lens[j] = len;
+			}
+
+			kmac(&mid, m, len, out, k->outlen);
+			expect("KMAC", i, "kmac()", out, k->outlen, k->md);
+
+			memset(outs, 0, sizeof(outs));
+			kmac_many(&mid, bufs, lens, BATCH, outs, k->outlen);
+			for (size_t j = 0; j < BATCH; j++)
+				expect("KMAC", i, "kmac_many()",
+				       outs + j * k->outlen, k->outlen, k->md);
+		}
+
+		free(m - 1);
+	}
+
+	free(key);
+}
+
+/**
+ * struct tuplehash_kat - TupleHash vector.
+ *
+ * @algo:   Algorithm.
+ * @elems:  Elements of the tuple.
+ * @n:      Number of elements.
+ * @s:      Customisation string S.
+ * @outlen: Output length in bytes.
+ * @xof:    Whether this is TupleHashXOF.
+ * @md:     Output in hexadecimal.
+ */
+struct tuplehash_kat {
+	enum shake_algo algo;
+	struct msg elems[3];
+	int n;
+	const char *s;
+	size_t outlen;
+	bool xof;
+	const char *md;
+};
+
+static const struct tuplehash_kat tuplehash_kats[] = {
+	{ SHAKE128, { HEX("000102"), HEX("101112131415"), HEX("") }, 2, "", 32,
+	  false,
+	  "c5d8786c1afb9b82111ab34b65b2c0048fa64e6d48e263264ce1707d3ffc8ed1" },
+	{ SHAKE128, { HEX("000102"), HEX("101112131415"), HEX("") }, 2,
+	  "My Tuple App", 32, false,
+	  "75cdb20ff4db1154e841d758e24160c54bae86eb8c13e7f5f40eb35588e96dfb" },
+	{ SHAKE128,
+	  { HEX("000102"), HEX("101112131415"), HEX("202122232425262728") }, 3,
+	  "My Tuple App", 32, false,
+	  "e60f202c89a2631eda8d4c588ca5fd07f39e5151998deccf973adb3804bb6e84" },
+	{ SHAKE256, { HEX("000102"), HEX("101112131415"), HEX("") }, 2, "", 64,
+	  false,
+	  "cfb7058caca5e668f81a12a20a2195ce97a925f1dba3e7449a56f82201ec6073"
+	  "11ac2696b1ab5ea2352df1423bde7bd4bb78c9aed1a853c78672f9eb23bbe194" },
+	{ SHAKE256, { HEX("000102"), HEX("101112131415"), HEX("") }, 2,
+	  "My Tuple App", 64, false,
+	  "147c2191d5ed7efd98dbd96d7ab5a11692576f5fe2a5065f3e33de6bba9f3aa1"
+	  "c4e9a068a289c61c95aab30aee1e410b0b607de3620e24a4e3bf9852a1d4367e" },
+	{ SHAKE256,
+	  { HEX("000102"), HEX("101112131415"), HEX("202122232425262728") }, 3,
+	  "My Tuple App", 64, false,
+	  "45000be63f9b6bfd89f54717670f69a9bc763591a4f05c50d68891a744bcc6e7"
+	  "d6d5b5e82c018da999ed35b0bb49c9678e526abd8e85c13ed254021db9e790ce" },
+	{ SHAKE128, { HEX("000102"), HEX("101112131415"), HEX("") }, 2, "", 32,
+	  true,
+	  "2f103cd7c32320353495c68de1a8129245c6325f6f2a3d608d92179c96e68488" },
+	{ SHAKE128, { HEX("000102"), HEX("101112131415"), HEX("") }, 2,
+	  "My Tuple App", 32, true,
+	  "3fc8ad69453128292859a18b6c67d7ad85f01b32815e22ce839c49ec374e9b9a" },
+	{ SHAKE128,
+	  { HEX("000102"), HEX("101112131415"), HEX("202122232425262728") }, 3,
+	  "My Tuple App", 32, true,
+	  "900fe16cad098d28e74d632ed852f99daab7f7df4d99e775657885b4bf76d6f8" },
+	{ SHAKE256, { HEX("000102"), HEX("101112131415"), HEX("") }, 2, "", 64,
+	  true,
+	  "03ded4610ed6450a1e3f8bc44951d14fbc384ab0efe57b000df6b6df5aae7cd5"
+	  "68e77377daf13f37ec75cf5fc598b6841d51dd207c991cd45d210ba60ac52eb9" },
+	{ SHAKE256, { HEX("000102"), HEX("101112131415"), HEX("") }, 2,
+	  "My Tuple App", 64, true,
+	  "6483cb3c9952eb20e830af4785851fc597ee3bf93bb7602c0ef6a65d741aeca7"
+	  "e63c3b128981aa05c6d27438c79d2754bb1b7191f125d6620fca12ce658b2442" },
+	{ SHAKE256,
+	  { HEX("000102"), HEX("101112131415"), HEX("202122232425262728") }, 3,
+	  "My Tuple App", 64, true,
+	  "0c59b11464f2336c34663ed51b2b950bec743610856f36c28d1d088d8a244628"
+	  "4dd09830a6a178dc752376199fae935d86cfdee5913d4922dfd369b66a53c897" },
+};
+
+static void check_tuplehash(void)
+{
+	size_t n = sizeof(tuplehash_kats) / sizeof(tuplehash_kats[0]);
+
+	for (size_t i = 0; i < n; i++) {
+		const struct tuplehash_kat *k = &tuplehash_kats[i];
+		struct sha3_ctx ctx, mid;
+		struct iovec elems[3];
+		size_t outlen = k->xof ? 0 : k->outlen;
+
+		for (int j = 0; j < k->n; j++) {
+			size_t len;
+			elems[j].iov_base = msg_make(&k->elems[j], 0, &len);
+			elems[j].iov_len = len;
+		}
+
+		tuplehash_init(&mid, k->algo, k->s, strlen(k->s));
+
+		if (k->xof)
+			tuplehash_xof(&mid, elems, k->n, out, k->outlen);
+		else
+			tuplehash(&mid, elems, k->n, out, k->outlen);
+		expect("TupleHash", i, "tuplehash()", out, k->outlen, k->md);
+
+		sha3_ctx_clone(&ctx, &mid);
+		for (int j = 0; j < k->n; j++)
+			tuplehash_update(&ctx, elems[j].iov_base,
+			                 elems[j].iov_len);
+		tuplehash_final(&ctx, outlen);
+		shake_squeeze(&ctx, out, k->outlen);
+		expect("TupleHash", i, "tuplehash_update()", out, k->outlen,
+		       k->md);
+
+		sha3_ctx_clone(&ctx, &mid);
+		tuplehash_updatev(&ctx, elems, k->n);
+		tuplehash_final(&ctx, outlen);
+		shake_squeeze(&ctx, out, k->outlen);
+		expect("TupleHash", i, "tuplehash_updatev()", out, k->outlen,
+		       k->md);
+
+		sha3_ctx_clone(&ctx, &mid);
+		for (int j = 0; j < k->n; j++) {
+			tuplehash_element(&ctx, elems[j].iov_len);
+			update(&ctx, 1, elems[j].iov_base, elems[j].iov_len);
+		}
+		tuplehash_final(&ctx, outlen);
+		squeeze(&ctx, 1, k->outlen);
+		expect("TupleHash", i, "tuplehash_element()", out, k->outlen,
+		       k->md);
+
+		for (int j = 0; j < k->n; j++)
+			free(elems[j].iov_base);
+	}
+}
+
+/*
+ * Creates a temporary file holding the @len bytes at @buf, writes its name to
+ * @path, and returns a descriptor for it open for reading at offset zero.
+ */
+static int make_file(char path[256], const uint8_t *buf, size_t len)
+{
+	const char *dir = getenv("TMPDIR");
+	int fd;
+
+	if (snprintf(path, 256, "%s/sha3-check.XXXXXX", dir ? dir : "/tmp")
+	    >= 256) {
+		fprintf(stderr, "TMPDIR is too long\n");
+		exit(2);
+	}
+
+	fd = mkstemp(path);
+	if (fd < 0) {
+		perror("mkstemp");
+		exit(2);
+	}
+
+	for (size_t off = 0; off < len; ) {
+		ssize_t n = write(fd, buf + off, len - off);
+		if (n < 0) {
+			perror("write");
+			exit(2);
+		}
+		off += n;
+	}
+
+	lseek(fd, 0, SEEK_SET);
+	return fd;
+}
+
+/*
+ * Each file is hashed whole by name and by descriptor, and from an offset
+ * after hashing the bytes before it from memory. Files of 1 MiB or more take
+ * the pipelined or memory-mapped paths.
+ */
+static const size_t file_sizes[] = {
+	0, 1000, (1 << 20) + 13,
+	(12 << 20) + 7,
+};
+
+static void check_file(void)
+{
+	size_t n = sizeof(file_sizes) / sizeof(file_sizes[0]);
+	uint8_t want[SHA3_256_SIZE], md[SHA3_256_SIZE];
+
+	for (size_t i = 0; i < n; i++) {
+		struct msg spec = PTN(file_sizes[i]);
+		struct sha3_ctx ctx;
+		char path[256];
+		size_t len;
+		uint8_t *m = msg_make(&spec, 0, &len);
+		size_t off = len / 3;
+
+		sha3_256(m, len, want);
+		int fd = make_file(path, m, len);
+
+		memset(md, 0, sizeof(md));
+		report("file", i, "sha3_hash_path()",
+		       !sha3_hash_path(path, SHA3_256, md)
+		       && !memcmp(md, want, sizeof(md)));
+
+		memset(md, 0, sizeof(md));
+		report("file", i, "sha3_hash_fd()",
+		       !sha3_hash_fd(fd, SHA3_256, md)
+		       && !memcmp(md, want, sizeof(md))
+		       && lseek(fd, 0, SEEK_CUR) == (off_t)len);
+
+		memset(md, 0, sizeof(md));
+		lseek(fd, off, SEEK_SET);
+		sha3_init(&ctx, SHA3_256);
+		sha3_update(&ctx, m, off);
+		if (!sha3_update_fd(&ctx, fd))
+			sha3_final(&ctx, md);
+		report("file", i, "sha3_update_fd() at an offset",
+		       !memcmp(md, want, sizeof(md))
+		       && lseek(fd, 0, SEEK_CUR) == (off_t)len);
+
+		close(fd);
+		unlink(path);
+		free(m);
+	}
+}
+
+/*
+ * Pipes can't be mapped or read at an offset, so they're read ahead by a
+ * thread. The writer is a child process so that the pipe never fills up with
+ * nobody reading it.
+ */
+static void check_pipe(void)
+{
+	static const size_t sizes[] = { 0, 1000, (3 << 20) + 5 };
+	uint8_t want[SHA3_256_SIZE], md[SHA3_256_SIZE];
+
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		struct msg spec = PTN(sizes[i]);
+		size_t len;
+		uint8_t *m = msg_make(&spec, 0, &len);
+		int fds[2], status;
+		pid_t pid;
+
+		sha3_256(m, len, want);
+
+		if (pipe(fds) || (pid = fork()) < 0) {
+			perror("pipe");
+			exit(2);
+		}
+
+		if (!pid) {
+			close(fds[0]);
+			for (size_t off = 0; off < len; ) {
+				ssize_t n = write(fds[1], m + off, len - off);
+				if (n < 0)
+					_exit(1);
+				off += n;
+			}
+			_exit(0);
+		}
+
+		close(fds[1]);
+		memset(md, 0, sizeof(md));
+		bool ok = !sha3_hash_fd(fds[0], SHA3_256, md)
+		          && !memcmp(md, want, sizeof(md));
+		close(fds[0]);
+		waitpid(pid, &status, 0);
+		report("pipe", i, "sha3_hash_fd()", ok && !status);
+
+		free(m);
+	}
+}
+
+/*
+ * Computes the root of a Merkle tree over the @len bytes at @data the long way
+ * round, a level at a time with sha3_init(), as described for merkle_init().
+ */
+static void merkle_ref(const uint8_t *data, size_t len, size_t chunk,
+                       uint8_t md[SHA3_256_SIZE])
+{
+	size_t n = len ? (len - 1) / chunk + 1 : 1;
+	uint8_t *h = malloc(n * SHA3_256_SIZE);
+	struct sha3_ctx ctx;
+
+	if (!h) {
+		perror("malloc");
+		exit(2);
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		size_t off = i * chunk;
+		sha3_init(&ctx, SHA3_256);
+		sha3_update(&ctx, "\x00", 1);
+		sha3_update(&ctx, data + off,
+		            len - off < chunk ? len - off : chunk);
+		sha3_final(&ctx, h + i * SHA3_256_SIZE);
+	}
+
+	for (; n > 1; n = (n + 1) / 2) {
+		for (size_t i = 0; i < n / 2; i++) {
+			sha3_init(&ctx, SHA3_256);
+			sha3_update(&ctx, "\x01", 1);
+			sha3_update(&ctx, h + 2 * i * SHA3_256_SIZE,
+			            2 * SHA3_256_SIZE);
+			sha3_final(&ctx, h + i * SHA3_256_SIZE);
+		}
+		if (n & 1)
+			memcpy(h + n / 2 * SHA3_256_SIZE,
+			       h + (n - 1) * SHA3_256_SIZE, SHA3_256_SIZE);
+	}
+
+	memcpy(md, h, SHA3_256_SIZE);
+	free(h);
+}
+
+/*
+ * Trees over an empty buffer, a single short or whole chunk, an odd number of
+ * leaves, a short last chunk, and enough leaves for the pool to be used, each
+ * with and without a pool.
+ */
+static const struct {
+	size_t len;
+	size_t chunk;
+} merkle_cases[] = {
+	{ 0, 64 },
+	{ 10, 64 },
+	{ 64, 64 },
+	{ 5 * 64, 64 },
+	{ 7 * 64 + 13, 64 },
+	{ 1001 * 64 + 1, 64 },
+	{ (1 << 20) + 5, 1000 },
+};
+
+static void check_merkle(void)
+{
+	size_t n = sizeof(merkle_cases) / sizeof(merkle_cases[0]);
+	uint8_t want[SHA3_256_SIZE], md[SHA3_256_SIZE];
+
+	for (size_t i = 0; i < 2 * n; i++) {
+		size_t chunk = merkle_cases[i / 2].chunk;
+		struct msg spec = PTN(merkle_cases[i / 2].len);
+		struct sha3_pool *p = i & 1 ? pool : NULL;
+		struct merkle_tree t, fresh;
+		size_t len;
+		uint8_t *m = msg_make(&spec, 0, &len);
+
+		if (merkle_init(&t, m, len, chunk, p)) {
+			perror("merkle_init");
+			exit(2);
+		}
+
+		merkle_ref(m, len, chunk, want);
+		merkle_root(&t, md);
+		report("Merkle tree", i, "merkle_root()",
+		       !memcmp(md, want, sizeof(md)));
+		merkle_root(&t, md);
+		report("Merkle tree", i, "merkle_root() again",
+		       !memcmp(md, want, sizeof(md)));
+
+		if (len) {
+			/*
+			 * Change the first and last bytes, one in the middle,
+			 * and a run across a chunk boundary, and mark a range
+			 * that runs off the end of the buffer.
+			 */
+			size_t run = chunk < len ? chunk - 3 : 0;
+			m[0] ^= 0x5a;
+			m[len / 2] ^= 0x5a;
+			m[len - 1] ^= 0x5a;
+			for (size_t j = run; j < run + 6 && j < len; j++)
+				m[j] ^= 0xa5;
+
+			merkle_dirty(&t, 0, 1);
+			merkle_dirty(&t, len / 2, 1);
+			merkle_dirty(&t, run, 6);
+			merkle_dirty(&t, len - 1, 100);
+			merkle_dirty(&t, len, 10);
+
+			merkle_ref(m, len, chunk, want);
+			merkle_root(&t, md);
+			report("Merkle tree", i, "merkle_dirty()",
+			       !memcmp(md, want, sizeof(md)));
+
+			memset(md, 0, sizeof(md));
+			if (!merkle_init(&fresh, m, len, chunk, p)) {
+				merkle_root(&fresh, md);
+				merkle_free(&fresh);
+			}
+			report("Merkle tree", i, "merkle_init() after changes",
+			       !memcmp(md, want, sizeof(md)));
+		}
+
+		merkle_free(&t);
+		free(m);
+	}
+}
+
+/*
+ * The counters are only kept when the library is built with SHA3_STATS, so this
+ * does nothing otherwise. Only the calling thread is counted, so none of these
+ * use a pool.
+ */
+static void check_stats(void)
+{
+	static const uint8_t zero[1000];
+	struct sha3_stats st;
+	struct keccak_sponge s;
+	uint64_t A[25] = { 0 };
+
+	if (sha3_stats_get(&st))
+		return;
+
+	/* 7 blocks of 136 bytes and the last block. */
+	sha3_stats_reset();
+	sha3_256(zero, sizeof(zero), out);
+	sha3_stats_get(&st);
+	report("counters", 0, "sha3_256()",
+	       st.permutations == 8 && st.finals == 1);
+
+	/* Rates that only the generic absorb loop handles. */
+	sha3_stats_reset();
+	keccak_sponge_init(&s, 16, 0x1f, 24);
+	keccak_sponge_absorb(&s, zero, 160);
+	sha3_stats_get(&st);
+	report("counters", 1, "keccak_sponge_absorb()",
+	       st.permutations == 10 && st.finals == 0);
+
+	sha3_stats_reset();
+	keccak_p1600(A, 24);
+	sha3_stats_get(&st);
+	report("counters", 2, "keccak_p1600()", st.permutations == 1);
+
+	/* Two blocks each of nine messages, one alone in its group. */
+	const void *bufs[BATCH];
+	size_t lens[BATCH];
+	for (size_t j = 0; j < BATCH; j++) {
+		bufs[j] = zero;
+		lens[j] = 100;
+	}
+
+	sha3_stats_reset();
+	sha3_hash_many(SHA3_512, bufs, lens, BATCH, out);
+	sha3_stats_get(&st);
+	report("counters", 3, "sha3_hash_many()",
+	       st.permutations == 2 * BATCH && st.finals == BATCH);
+}
+
+/*
+ * Writes SHAKE(@seed || @pad) to @buf, where @pad is @padlen bytes of @ds
+ * followed by zeros, with the top bit of the last byte set, for @rate-byte
+ * blocks, followed by @zlen zero bytes and @next. This is what a generator
+ * seeded with @seed and reseeded with @next computes.
+ */
+static void rng_ref(enum shake_algo algo, const uint8_t *seed, size_t slen,
+                    size_t zblocks, const uint8_t *next, size_t nlen,
+                    uint8_t *buf, size_t len)
+{
+	static const uint8_t zero[200];
+	struct sha3_ctx ctx;
+	size_t rate = 200 - 2 * algo;
+	uint8_t pad[200] = { 0x1f };
+	size_t padlen = rate - slen % rate;
+
+	pad[padlen - 1] |= 0x80;
+
+	shake_init(&ctx, algo);
+	sha3_update(&ctx, seed, slen);
+	if (next) {
+		sha3_update(&ctx, pad, padlen);
+		for (size_t i = 0; i < zblocks; i++)
+			sha3_update(&ctx, zero, rate);
+		sha3_update(&ctx, next, nlen);
+	}
+	shake_final(&ctx);
+	shake_squeeze(&ctx, buf, len);
+}
+
+/*
+ * Uneven read sizes, which add up to RNG_LEN.
+ */
+static const size_t rng_reads[] = { 1, 7, 0, 168, 13, 136, 500, 3000, 2 };
+
+#define RNG_LEN 3827
+
+static void check_rng(void)
+{
+	/* Room for RNG_LEN bytes of each stream rounded up to whole blocks. */
+	static uint8_t got[8 * (RNG_LEN + 200)], want[8 * (RNG_LEN + 200)];
+	static const uint8_t seed[] = "sha3-check seed";
+	static const uint8_t next[] = "sha3-check reseed";
+	size_t slen = sizeof(seed) - 1, nlen = sizeof(next) - 1;
+	struct sha3_rng rng, one[8];
+	struct sha3_rng_x8 x8;
+
+	for (size_t i = 0; i < 2; i++) {
+		enum shake_algo algo = i ? SHAKE256 : SHAKE128;
+		size_t rate = 200 - 2 * algo;
+
+		sha3_rng_seed(&rng, algo, seed, slen);
+		for (size_t j = 0, off = 0; j < 9; off += rng_reads[j++])
+			sha3_rng_fill(&rng, got + off, rng_reads[j]);
+		rng_ref(algo, seed, slen, 0, NULL, 0, want, RNG_LEN);
+		report("random", i, "sha3_rng_fill()",
+		       !memcmp(got, want, RNG_LEN));
+
+		/*
+		 * Reseeding permutes the state first, so the reseed follows as
+		 * many blocks of zeros as blocks of output had been started,
+		 * or one if none had.
+		 */
+		static const size_t before[] = { 0, 1, 136, 168, 169, 500 };
+		for (size_t j = 0; j < 6; j++) {
+			size_t z = (before[j] + rate - 1) / rate;
+			sha3_rng_seed(&rng, algo, seed, slen);
+			sha3_rng_fill(&rng, got, before[j]);
+			sha3_rng_reseed(&rng, next, nlen);
+			sha3_rng_fill(&rng, got, 300);
+			rng_ref(algo, seed, slen, z ? z : 1, next, nlen, want,
+			        300);
+			report("random", i, "sha3_rng_reseed()",
+			       !memcmp(got, want, 300));
+		}
+
+		/*
+		 * Stream j of the eight-way generator is SHAKE(seed || j),
+		 * interleaved a block at a time.
+		 */
+		size_t blocks = (RNG_LEN + rate - 1) / rate;
+		for (size_t j = 0; j < 8; j++) {
+			uint8_t s[sizeof(seed)];
+			memcpy(s, seed, slen);
+			s[slen] = j;
+			rng_ref(algo, s, slen + 1, 0, NULL, 0, got,
+			        blocks * rate);
+			for (size_t b = 0; b < blocks; b++)
+				memcpy(want + (8 * b + j) * rate,
+				       got + b * rate, rate);
+		}
+
+		sha3_rng_seed_x8(&x8, algo, seed, slen);
+		for (size_t j = 0, off = 0; j < 9; off += 8 * rng_reads[j++])
+			sha3_rng_fill_x8(&x8, got + off, 8 * rng_reads[j]);
+		report("random", i, "sha3_rng_fill_x8()",
+		       !memcmp(got, want, 8 * RNG_LEN));
+
+		/*
+		 * After two blocks of each stream, reseeding the eight-way
+		 * generator is reseeding generators seeded with seed || j with
+		 * next || j.
+		 */
+		sha3_rng_seed_x8(&x8, algo, seed, slen);
+		sha3_rng_fill_x8(&x8, got, 16 * rate);
+		sha3_rng_reseed_x8(&x8, next, nlen);
+		sha3_rng_fill_x8(&x8, got, 16 * rate);
+
+		for (size_t j = 0; j < 8; j++) {
+			uint8_t s[sizeof(seed)], t[sizeof(next)];
+			memcpy(s, seed, slen);
+			memcpy(t, next, nlen);
+			s[slen] = t[nlen] = j;
+			sha3_rng_seed(&one[j], algo, s, slen + 1);
+			sha3_rng_fill(&one[j], want, 2 * rate);
+			sha3_rng_reseed(&one[j], t, nlen + 1);
+		}
+		for (size_t b = 0; b < 16; b++)
+			sha3_rng_fill(&one[b % 8], want + b * rate, rate);
+		report("random", i, "sha3_rng_reseed_x8()",
+		       !memcmp(got, want, 16 * rate));
+	}
+
+	/*
+	 * A child must not produce the output that the parent goes on to
+	 * produce next.
+	 */
+	struct sha3_rng *local = sha3_rng_local();
+	int fds[2], status;
+	pid_t pid;
+
+	report("random", 0, "sha3_rng_local()", local);
+	if (!local)
+		return;
+
+	sha3_rng_fill(local, got, 32);
+	if (pipe(fds) || (pid = fork()) < 0) {
+		perror("pipe");
+		exit(2);
+	}
+
+	if (!pid) {
+		struct sha3_rng *r = sha3_rng_local();
+		if (!r)
+			_exit(1);
+		sha3_rng_fill(r, got, 32);
+		_exit(write(fds[1], got, 32) != 32);
+	}
+
+	close(fds[1]);
+	sha3_rng_fill(local, want, 32);
+	bool ok = read(fds[0], got, 32) == 32;
+	close(fds[0]);
+	waitpid(pid, &status, 0);
+	report("random", 0, "sha3_rng_local() after fork()",
+	       ok && !status && memcmp(got, want, 32));
+}
+
+/**
+ * struct model - A sponge modelled a byte at a time on top of keccak_p1600().
+ *
+ * @A:         State.
+ * @rate:      Rate in bytes.
+ * @index:     Byte index of the next byte to absorb or squeeze.
+ * @ds:        Domain separation byte.
+ * @nrounds:   Number of rounds.
+ * @squeezing: Whether output has been read since the last input.
+ */
+struct model {
+	uint64_t A[25];
+	size_t rate;
+	size_t index;
+	uint8_t ds;
+	unsigned nrounds;
+	bool squeezing;
+};
+
+static void model_xor(struct model *s, size_t i, uint8_t b)
+{
+	s->A[i / 8] ^= (uint64_t)b << 8 * (i % 8);
+}
+
+static uint8_t model_byte(const struct model *s, size_t i)
+{
+	return s->A[i / 8] >> 8 * (i % 8);
+}
+
+static void model_pad(struct model *s, size_t len)
+{
+	model_xor(s, len, s->ds);
+	model_xor(s, s->rate - 1, 0x80);
+	keccak_p1600(s->A, s->nrounds);
+}
+
+static void model_absorb(struct model *s, const uint8_t *buf, size_t len)
+{
+	if (s->squeezing) {
+		keccak_p1600(s->A, s->nrounds);
+		s->index = 0;
+		s->squeezing = false;
+	}
+
+	for (size_t i = 0; i < len; i++) {
+		model_xor(s, s->index++, buf[i]);
+		if (s->index == s->rate) {
+			keccak_p1600(s->A, s->nrounds);
+			s->index = 0;
+		}
+	}
+}
+
+static void model_squeeze(struct model *s, uint8_t *buf, size_t len)
+{
+	if (!s->squeezing) {
+		model_pad(s, s->index);
+		s->index = 0;
+		s->squeezing = true;
+	}
+
+	for (size_t i = 0; i < len; i++) {
+		if (s->index == s->rate) {
+			keccak_p1600(s->A, s->nrounds);
+			s->index = 0;
+		}
+		buf[i] = model_byte(s, s->index++);
+	}
+}
+
+/*
+ * Sponge parameters: the SHAKE128 and SHA3-256 rates, and rates that no
+ * standard function uses, with reduced rounds.
+ */
+static const struct {
+	size_t rate;
+	uint8_t ds;
+	unsigned nrounds;
+} sponge_cases[] = {
+	{ 168, 0x1f, 24 },
+	{ 136, 0x06, 24 },
+	{ 16, 0x0b, 12 },
+	{ 8, 0x01, 1 },
+};
+
+/*
+ * Alternating calls to absorb and squeeze, as lengths, with squeezes negative.
+ */
+static const long sponge_ops[] = { 0, -5, 200, 3, -300, -1, 1, -168, 17, -8 };
+
+static void check_sponge(void)
+{
+	static uint8_t got[8 * 200], want[8 * 200];
+	struct msg spec = PTN(256);
+	size_t len;
+	uint8_t *m = msg_make(&spec, 1, &len);
+
+	for (size_t i = 0; i < sizeof(sponge_cases) / sizeof(sponge_cases[0]);
+	     i++) {
+		struct keccak_sponge s;
+		struct model ref = {
+			.rate = sponge_cases[i].rate,
+			.ds = sponge_cases[i].ds,
+			.nrounds = sponge_cases[i].nrounds,
+		};
+		size_t rate = ref.rate, off = 0;
+
+		keccak_sponge_init(&s, rate, ref.ds, ref.nrounds);
+		for (size_t j = 0; j < sizeof(sponge_ops) / sizeof(long); j++) {
+			long op = sponge_ops[j];
+			if (op >= 0) {
+				keccak_sponge_absorb(&s, m, op);
+				model_absorb(&ref, m, op);
+			} else {
+				keccak_sponge_squeeze(&s, got + off, -op);
+				model_squeeze(&ref, want + off, -op);
+				off += -op;
+			}
+		}
+		report("sponge", i, "keccak_sponge", !memcmp(got, want, off));
+
+		/*
+		 * Each duplexing call pads its input into one block and reads
+		 * up to a block of output.
+		 */
+		memset(&ref.A, 0, sizeof(ref.A));
+		keccak_sponge_init(&s, rate, ref.ds, ref.nrounds);
+		off = 0;
+		for (size_t j = 0; j < 8; j++) {
+			size_t inlen = j * 7 % rate;
+			size_t outlen = rate - j * 3 % rate;
+			keccak_duplex(&s, m, inlen, got + off, outlen);
+			for (size_t k = 0; k < inlen; k++)
+				model_xor(&ref, k, m[k]);
+			model_pad(&ref, inlen);
+			for (size_t k = 0; k < outlen; k++)
+				want[off + k] = model_byte(&ref, k);
+			off += outlen;
+		}
+		report("sponge", i, "keccak_duplex()", !memcmp(got, want, off));
+	}
+
+	free(m - 1);
+}
+
+int main(void)
+{
+	const char *want = getenv("SHA3_KERNEL");
+	const char *kernel = sha3_kernel();
+
+	if (want && strcmp(want, kernel)) {
+		printf("%s: not supported, skipped\n", want);
+		return 0;
+	}
+
+	pool = sha3_pool_create(2);
+	if (!pool) {
+		perror("sha3_pool_create");
+		return 2;
+	}
+
+	check_p1600();
+	check_sha3();
+	check_shake();
+	check_turboshake();
+	check_k12();
+	check_cshake();
+	check_parallelhash();
+	check_kmac();
+	check_tuplehash();
+	check_file();
+	check_pipe();
+	check_merkle();
+	check_stats();
+	check_rng();
+	check_sponge();
+
+	sha3_pool_destroy(pool);
+#if defined(SHA3_IMPLEMENTATION)
+	printf("%s, inline: %u tests, %u failed\n", kernel, tests, failures);
+#else
+	printf("%s: %u tests, %u failed\n", kernel, tests, failures);
+#endif
+	return failures != 0;
+}
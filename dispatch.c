@@ -0,0 +1,331 @@
+/* SPDX-License-Identifier: 0BSD
+ *
+ * Copyright © 2022 Alex Minghella <a@minghella.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Runtime kernel selection.
+ *
+ * keccak_impl starts out pointing at the best kernels for the target
+ * baseline, so it's always usable, and is replaced from a constructor with the
+ * best kernels the running CPU supports. The SHA3_KERNEL environment variable
+ * may name a specific kernel set to use instead, which is useful for comparing
+ * implementations on the same machine. A kernel set that the CPU can't run is
+ * never selected, whatever SHA3_KERNEL says.
+ */
+
+#include "sha3.h"
+#include "keccak.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(KECCAK_HAVE_ARM64) && defined(__linux__)
+	#include <sys/auxv.h>
+#elif defined(KECCAK_HAVE_ARM64) && defined(__APPLE__)
+	#include <sys/sysctl.h>
+#endif
+
+static void p1600_x4_generic(uint64_t A[100], size_t nr)
+{
+	keccakp_1600_xn(A, 4, nr);
+}
+
+static void p1600_x8_generic(uint64_t A[200], size_t nr)
+{
+	keccakp_1600_xn(A, 8, nr);
+}
+
+#if defined(KECCAK_HAVE_X86)
+static void p1600_x4_avx2(uint64_t A[100], size_t nr)
+{
+	keccakp_1600_x4_avx2(A, 4, nr);
+}
+
+static void p1600_x8_avx2(uint64_t A[200], size_t nr)
+{
+	keccakp_1600_x4_avx2(A + 0, 8, nr);
+	keccakp_1600_x4_avx2(A + 4, 8, nr);
+}
+#endif
+
+#if defined(KECCAK_HAVE_ARM64)
+static void p1600_x4_arm_sha3(uint64_t A[100], size_t nr)
+{
+	keccakp_1600_x2_arm_sha3(A + 0, 4, nr);
+	keccakp_1600_x2_arm_sha3(A + 2, 4, nr);
+}
+
+static void p1600_x8_arm_sha3(uint64_t A[200], size_t nr)
+{
+	for (size_t j = 0; j < 8; j += 2)
+		keccakp_1600_x2_arm_sha3(A + j, 8, nr);
+}
+#endif
+
+static void p1600_x4_lc(uint64_t A[100], size_t nr)
+{
+	keccakp_1600_xn_lc(A, 4, nr);
+}
+
+static void p1600_x8_lc(uint64_t A[200], size_t nr)
+{
+	keccakp_1600_xn_lc(A, 8, nr);
+}
+
+static void p1600_x4_32(uint64_t A[100], size_t nr)
+{
+	keccakp_1600_xn_32(A, 4, nr);
+}
+
+static void p1600_x8_32(uint64_t A[200], size_t nr)
+{
+	keccakp_1600_xn_32(A, 8, nr);
+}
+
+/*
+ * The bit-interleaved kernels only beat the generic ones where 64-bit
+ * operations have to be emulated.
+ */
+#if UINTPTR_MAX == UINT32_MAX
+	#define KECCAK_PREFER_32 1
+#endif
+
+/*
+ * The lane-complementing kernels save a NOT per lane in χ, which only matters
+ * where a ^ (~b & c) can't be done with an and-not instruction. The AVX2 kernel
+ * set uses them for single states too, since its scalar code is built for the
+ * same baseline.
+ */
+#if defined(__x86_64__) && !defined(__BMI__)
+	#define KECCAK_PREFER_LC 1
+#elif defined(__riscv) && !defined(__riscv_zbb)
+	#define KECCAK_PREFER_LC 1
+#endif
+
+/*
+ * Kernel sets, in order of preference.
+ */
+enum {
+#if defined(KECCAK_HAVE_X86)
+	IMPL_AVX512,
+	IMPL_AVX2,
+#endif
+#if defined(KECCAK_HAVE_ARM64)
+	IMPL_ARM_SHA3,
+#endif
+#if defined(KECCAK_PREFER_32)
+	IMPL_GENERIC32,
+	IMPL_GENERIC,
+	IMPL_GENERIC_LC,
+#elif defined(KECCAK_PREFER_LC)
+	IMPL_GENERIC_LC,
+	IMPL_GENERIC,
+	IMPL_GENERIC32,
+#else
+	IMPL_GENERIC,
+	IMPL_GENERIC_LC,
+	IMPL_GENERIC32,
+#endif
+	IMPL_COUNT
+};
+
+static const struct keccak_impl impls[IMPL_COUNT] = {
+#if defined(KECCAK_HAVE_X86)
+	[IMPL_AVX512] = {
+		.name = "avx512",
+		.width = 8,
+		.p1600 = keccakp_1600_avx512,
+		.p1600_x4 = p1600_x4_avx2,
+		.p1600_x8 = keccakp_1600_x8_avx512,
+		.absorb = keccak_absorb_avx512,
+	},
+	[IMPL_AVX2] = {
+		.name = "avx2",
+		.width = 4,
+#if defined(KECCAK_PREFER_LC)
+		.p1600 = keccakp_1600_lc,
+		.absorb = keccak_absorb_lc,
+#else
+		.p1600 = keccakp_1600,
+		.absorb = keccak_absorb_generic,
+#endif
+		.p1600_x4 = p1600_x4_avx2,
+		.p1600_x8 = p1600_x8_avx2,
+	},
+#endif
+#if defined(KECCAK_HAVE_ARM64)
+	[IMPL_ARM_SHA3] = {
+		.name = "arm-sha3",
+		.width = 2,
+		.p1600 = keccakp_1600_arm_sha3,
+		.p1600_x4 = p1600_x4_arm_sha3,
+		.p1600_x8 = p1600_x8_arm_sha3,
+		.absorb = keccak_absorb,
+	},
+#endif
+	[IMPL_GENERIC] = {
+		.name = "generic",
+		.width = 1,
+		.p1600 = keccakp_1600,
+		.p1600_x4 = p1600_x4_generic,
+		.p1600_x8 = p1600_x8_generic,
+		.absorb = keccak_absorb_generic,
+	},
+	[IMPL_GENERIC_LC] = {
+		.name = "generic-lc",
+		.width = 1,
+		.p1600 = keccakp_1600_lc,
+		.p1600_x4 = p1600_x4_lc,
+		.p1600_x8 = p1600_x8_lc,
+		.absorb = keccak_absorb_lc,
+	},
+	[IMPL_GENERIC32] = {
+		.name = "generic32",
+		.width = 1,
+		.p1600 = keccakp_1600_32,
+		.p1600_x4 = p1600_x4_32,
+		.p1600_x8 = p1600_x8_32,
+		.absorb = keccak_absorb_32,
+	},
+};
+
+/*
+ * The AVX-512 kernel set also uses the AVX2 four-way permutation, so requires
+ * both. Every CPU with AVX-512F has AVX2 anyway.
+ */
+#if defined(KECCAK_HAVE_X86) && defined(__AVX512F__) && defined(__AVX2__)
+	#define IMPL_BASELINE IMPL_AVX512
+#elif defined(KECCAK_HAVE_X86) && defined(__AVX2__)
+	#define IMPL_BASELINE IMPL_AVX2
+#elif defined(KECCAK_HAVE_ARM64) && defined(__ARM_FEATURE_SHA3)
+	#define IMPL_BASELINE IMPL_ARM_SHA3
+#elif defined(KECCAK_PREFER_32)
+	#define IMPL_BASELINE IMPL_GENERIC32
+#elif defined(KECCAK_PREFER_LC)
+	#define IMPL_BASELINE IMPL_GENERIC_LC
+#else
+	#define IMPL_BASELINE IMPL_GENERIC
+#endif
+
+const struct keccak_impl *keccak_impl = &impls[IMPL_BASELINE];
+const struct keccak_impl *keccak_kernels = &impls[IMPL_BASELINE];
+
+#if defined(SHA3_STATS)
+/*
+ * With SHA3_STATS, keccak_impl points at a copy of the selected kernel set
+ * whose single-state functions count permutations before calling the real
+ * kernels in keccak_kernels, which keeps the counting out of every caller. The
+ * multi-buffer kernels are used as they are, and counted by their callers,
+ * since only they know how many of the states are in use. Anything hashed before the
+ * constructor runs goes straight to the baseline kernels and isn't counted.
+ */
+static void stats_p1600(uint64_t A[25], size_t nr)
+{
+	KECCAK_STAT(permutations, 1);
+	keccak_kernels->p1600(A, nr);
+}
+
+static size_t stats_absorb(uint64_t A[25], const void *buf, size_t len,
+                           size_t rate, size_t nr)
+{
+	size_t n = keccak_kernels->absorb(A, buf, len, rate, nr);
+	KECCAK_STAT(permutations, n / rate);
+	return n;
+}
+
+static struct keccak_impl stats_wrap = {
+	.p1600 = stats_p1600,
+	.absorb = stats_absorb,
+};
+#endif
+
+static void set_impl(const struct keccak_impl *impl)
+{
+	keccak_kernels = impl;
+#if defined(SHA3_STATS)
+	stats_wrap.name = impl->name;
+	stats_wrap.width = impl->width;
+	stats_wrap.p1600_x4 = impl->p1600_x4;
+	stats_wrap.p1600_x8 = impl->p1600_x8;
+	keccak_impl = &stats_wrap;
+#else
+	keccak_impl = impl;
+#endif
+}
+
+static bool impl_supported(size_t i)
+{
+	switch (i) {
+#if defined(KECCAK_HAVE_X86)
+	case IMPL_AVX512:
+		return __builtin_cpu_supports("avx512f")
+		       && __builtin_cpu_supports("avx2");
+	case IMPL_AVX2:
+		return __builtin_cpu_supports("avx2");
+#endif
+#if defined(KECCAK_HAVE_ARM64) && defined(__linux__)
+	case IMPL_ARM_SHA3:
+		return getauxval(AT_HWCAP) & (1UL << 17); /* HWCAP_SHA3 */
+#elif defined(KECCAK_HAVE_ARM64) && defined(__APPLE__)
+	case IMPL_ARM_SHA3: {
+		int v = 0;
+		size_t n = sizeof(v);
+		return !sysctlbyname("hw.optional.armv8_2_sha3", &v, &n, NULL, 0)
+		       && v;
+	}
+#endif
+	default:
+		return i == IMPL_BASELINE || i == IMPL_GENERIC
+		       || i == IMPL_GENERIC_LC || i == IMPL_GENERIC32;
+	}
+}
+
+__attribute__((constructor))
+static void keccak_dispatch_init(void)
+{
+#if defined(KECCAK_HAVE_X86)
+	__builtin_cpu_init();
+#endif
+
+	size_t best = IMPL_GENERIC;
+	for (size_t i = IMPL_COUNT; i--; ) {
+		if (impl_supported(i))
+			best = i;
+	}
+
+	set_impl(&impls[best]);
+
+	const char *env = getenv("SHA3_KERNEL");
+	if (env)
+		keccak_select(env);
+}
+
+bool keccak_select(const char *name)
+{
+	for (size_t i = 0; i < IMPL_COUNT; i++) {
+		if (!strcmp(name, impls[i].name) && impl_supported(i)) {
+			set_impl(&impls[i]);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+const char *sha3_kernel(void)
+{
+	return keccak_impl->name;
+}
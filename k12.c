@@ -0,0 +1,272 @@
+/* SPDX-License-Identifier: 0BSD
+ *
+ * Copyright © 2022 Alex Minghella <a@minghella.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * References
+ *
+ * [1] RFC 9861, KangarooTwelve and TurboSHAKE, B. Viguier, D. Wong, G. Van
+ *     Assche, Q. Dang, J. Daemen, October 2025,
+ *     https://www.rfc-editor.org/rfc/rfc9861
+ */
+
+/*
+ * TurboSHAKE and KangarooTwelve.
+ *
+ * TurboSHAKE is SHAKE with the permutation reduced to 12 rounds and a caller
+ * chosen domain separation byte, so it's just a struct sha3_ctx with a
+ * different round count.
+ *
+ * KangarooTwelve splits its input S = M || C || length_encode(|C|) into 8 KiB
+ * chunks. The first chunk is absorbed straight into the final node, and every
+ * other chunk is hashed independently as a leaf to a chaining value which is
+ * then absorbed into the final node in order. [1] Since the leaves are
+ * independent, any run of whole chunks in the input is hashed with the
+ * multi-buffer permutations and spread over a worker pool if there is one.
+ */
+
+#include "sha3.h"
+#include "keccak.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define K12_CHUNK 8192
+
+/*
+ * Maximum number of whole chunks hashed before their chaining values are
+ * absorbed into the final node, and the number of chunks in each pool task.
+ */
+#define K12_SEGMENT 256
+#define K12_TASK    16
+
+void turboshake_init(struct sha3_ctx *ctx, enum shake_algo algo)
+{
+	shake_init(ctx, algo);
+	ctx->rounds = 12;
+}
+
+void turboshake_final(struct sha3_ctx *ctx, uint8_t ds)
+{
+	keccak_pad(ctx, ds);
+}
+
+/**
+ * length_encode - Encode an integer as defined for KangarooTwelve.
+ *
+ * @x:   Integer to encode.
+ * @buf: Output buffer of at least 9 bytes.
+ *
+ * @return: Length of the encoding in bytes.
+ *
+ * This is the big-endian encoding of @x with no leading zeros, followed by a
+ * byte holding the length of that encoding. Zero is encoded as a single zero
+ * byte.
+ */
+static size_t length_encode(uint64_t x, uint8_t buf[9])
+{
+	uint8_t be[8];
+	size_t n = 0;
+	for (uint64_t y = x; y; y >>= 8)
+		n++;
+
+	/*
+	 * The encoding is built in full and its tail copied, so that the
+	 * compiler can see it's never more than 8 bytes.
+	 */
+	for (size_t i = 0; i < 8; i++)
+		be[i] = x >> 8 * (7 - i);
+	memcpy(buf, be + 8 - n, n);
+	buf[n] = n;
+
+	return n + 1;
+}
+
+struct leaves {
+	enum k12_algo algo;
+	const uint8_t *p;
+	size_t count;
+	uint8_t *cv;
+};
+
+static void leaves_task(void *arg, size_t t)
+{
+	const struct leaves *l = arg;
+	const void *bufs[K12_TASK];
+	size_t lens[K12_TASK];
+
+	size_t first = t * K12_TASK;
+	size_t n = l->count - first < K12_TASK ? l->count - first : K12_TASK;
+
+	for (size_t i = 0; i < n; i++) {
+		bufs[i] = l->p + (first + i) * K12_CHUNK;
+		lens[i] = K12_CHUNK;
+	}
+
+	/* CV_i = TurboSHAKE(S_i, 0x0B, 32 or 64) */
+	keccak_hash_many(200 - 2 * l->algo, 0x0b, 12, 2 * l->algo, bufs, lens,
+	                 n, l->cv + first * 2 * l->algo);
+}
+
+/**
+ * k12_leaves - Hash whole chunks as leaves and absorb their chaining values.
+ *
+ * @ctx:   Pointer to a KangarooTwelve context with no leaf in progress.
+ * @p:     Pointer to the first chunk.
+ * @count: Number of chunks. At most K12_SEGMENT.
+ *
+ * @return: None.
+ */
+static void k12_leaves(struct k12_ctx *ctx, const uint8_t *p, size_t count)
+{
+	uint8_t cv[K12_SEGMENT * 64];
+	struct leaves l = {
+		.algo = ctx->algo,
+		.p = p,
+		.count = count,
+		.cv = cv,
+	};
+
+	sha3_pool_run(ctx->pool, leaves_task, &l,
+	              (count + K12_TASK - 1) / K12_TASK);
+
+	sha3_update(&ctx->node, cv, count * 2 * ctx->algo);
+	ctx->leaves += count;
+}
+
+/**
+ * k12_leaf_final - Finish the leaf in progress and absorb its chaining value.
+ *
+ * @ctx: Pointer to a KangarooTwelve context with a leaf in progress.
+ *
+ * @return: None.
+ */
+static void k12_leaf_final(struct k12_ctx *ctx)
+{
+	uint8_t cv[64];
+
+	turboshake_final(&ctx->leaf, 0x0b);
+	shake_squeeze(&ctx->leaf, cv, 2 * ctx->algo);
+	sha3_update(&ctx->node, cv, 2 * ctx->algo);
+	ctx->leaves++;
+}
+
+void k12_init(struct k12_ctx *ctx, enum k12_algo algo, struct sha3_pool *pool)
+{
+	turboshake_init(&ctx->node, (enum shake_algo)algo);
+	ctx->pool = pool;
+	ctx->len = 0;
+	ctx->leaves = 0;
+	ctx->algo = algo;
+}
+
+void k12_update(struct k12_ctx *ctx, const void *buf, size_t len)
+{
+	const uint8_t *p = buf;
+
+	if (ctx->len < K12_CHUNK) {
+		size_t n = K12_CHUNK - ctx->len;
+		if (n > len)
+			n = len;
+
+		sha3_update(&ctx->node, p, n);
+		ctx->len += n;
+		p += n;
+		len -= n;
+
+		if (!len)
+			return;
+	}
+
+	/*
+	 * There's more than one chunk, so the first is followed by
+	 * 0x03 || 0x00^7 in the final node.
+	 */
+	if (ctx->len == K12_CHUNK && len) {
+		static const uint8_t marker[8] = { 0x03 };
+		sha3_update(&ctx->node, marker, sizeof(marker));
+	}
+
+	size_t off = (ctx->len - K12_CHUNK) % K12_CHUNK;
+	ctx->len += len;
+
+	if (off) {
+		size_t n = K12_CHUNK - off;
+		if (n > len)
+			n = len;
+
+		sha3_update(&ctx->leaf, p, n);
+		p += n;
+		len -= n;
+
+		if (off + n < K12_CHUNK)
+			return;
+
+		k12_leaf_final(ctx);
+	}
+
+	while (len >= K12_CHUNK) {
+		size_t count = len / K12_CHUNK;
+		if (count > K12_SEGMENT)
+			count = K12_SEGMENT;
+
+		k12_leaves(ctx, p, count);
+		p += count * K12_CHUNK;
+		len -= count * K12_CHUNK;
+	}
+
+	if (len) {
+		turboshake_init(&ctx->leaf, (enum shake_algo)ctx->algo);
+		sha3_update(&ctx->leaf, p, len);
+	}
+}
+
+void k12_final(struct k12_ctx *ctx, const void *custom, size_t len)
+{
+	uint8_t enc[9];
+
+	k12_update(ctx, custom, len);
+	k12_update(ctx, enc, length_encode(len, enc));
+
+	if (ctx->len <= K12_CHUNK) {
+		turboshake_final(&ctx->node, 0x07);
+		return;
+	}
+
+	if ((ctx->len - K12_CHUNK) % K12_CHUNK)
+		k12_leaf_final(ctx);
+
+	size_t n = length_encode(ctx->leaves, enc);
+	sha3_update(&ctx->node, enc, n);
+	sha3_update(&ctx->node, "\xff\xff", 2);
+	turboshake_final(&ctx->node, 0x06);
+}
+
+void k12_squeeze(struct k12_ctx *ctx, void *out, size_t len)
+{
+	shake_squeeze(&ctx->node, out, len);
+}
+
+void k12(enum k12_algo algo, const void *buf, size_t len, const void *custom,
+         size_t clen, void *out, size_t outlen, struct sha3_pool *pool)
+{
+	struct k12_ctx ctx;
+
+	k12_init(&ctx, algo, pool);
+	k12_update(&ctx, buf, len);
+	k12_final(&ctx, custom, clen);
+	k12_squeeze(&ctx, out, outlen);
+	memset(&ctx, 0, sizeof(ctx));
+}
@@ -0,0 +1,274 @@
+/* SPDX-License-Identifier: 0BSD
+ *
+ * Copyright © 2022 Alex Minghella <a@minghella.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Bit-interleaved KECCAK-p[1600] permutation for 32-bit targets.
+ *
+ * On a 32-bit core every 64-bit rotation costs four shifts and two ORs. With
+ * each lane held instead as two 32-bit words, one of its even-numbered bits and
+ * one of its odd-numbered bits, a 64-bit rotation by 2k is a 32-bit rotation of
+ * both words by k, and a rotation by 2k + 1 is the same with the words swapped
+ * and the new even word rotated once more. The other steps are bitwise and
+ * don't care how the bits are arranged.
+ *
+ * The state is converted to interleaved form on entry and back on exit, so the
+ * rest of the library sees ordinary lanes. keccak_absorb_32() keeps the state
+ * interleaved across all of the blocks it absorbs, converting the input lanes
+ * instead, so only single permutations pay for both conversions.
+ */
+
+#include "keccak.h"
+
+#include <stdint.h>
+
+/*
+ * The round constants, each split into its even bits and its odd bits.
+ */
+static const uint32_t rc32[24][2] = {
+	{ 0x00000001, 0x00000000 }, { 0x00000000, 0x00000089 },
+	{ 0x00000000, 0x8000008b }, { 0x00000000, 0x80008080 },
+	{ 0x00000001, 0x0000008b }, { 0x00000001, 0x00008000 },
+	{ 0x00000001, 0x80008088 }, { 0x00000001, 0x80000082 },
+	{ 0x00000000, 0x0000000b }, { 0x00000000, 0x0000000a },
+	{ 0x00000001, 0x00008082 }, { 0x00000000, 0x00008003 },
+	{ 0x00000001, 0x0000808b }, { 0x00000001, 0x8000000b },
+	{ 0x00000001, 0x8000008a }, { 0x00000001, 0x80000081 },
+	{ 0x00000000, 0x80000081 }, { 0x00000000, 0x80000008 },
+	{ 0x00000000, 0x00000083 }, { 0x00000000, 0x80008003 },
+	{ 0x00000001, 0x80008088 }, { 0x00000000, 0x80000088 },
+	{ 0x00000001, 0x00008000 }, { 0x00000000, 0x80008082 },
+};
+
+/*
+ * ρ offsets and π destinations, indexed by Index(x + 5y) as in sha3.h. Lane i
+ * is rotated by rho[i] and moved to pi[i].
+ */
+static const uint8_t rho[25] = {
+	 0,  1, 62, 28, 27,
+	36, 44,  6, 55, 20,
+	 3, 10, 43, 25, 39,
+	41, 45, 15, 21,  8,
+	18,  2, 61, 56, 14,
+};
+
+static const uint8_t pi[25] = {
+	 0, 10, 20,  5, 15,
+	16,  1, 11, 21,  6,
+	 7, 17,  2, 12, 22,
+	23,  8, 18,  3, 13,
+	14, 24,  9, 19,  4,
+};
+
+static inline uint32_t rotl32(uint32_t x, unsigned n)
+{
+	return (x << (n & 31)) | (x >> (-n & 31));
+}
+
+/**
+ * unzip32 - Gather the even bits of a word into its low half and the odd bits
+ *           into its high half.
+ *
+ * @x: 32-bit unsigned integer.
+ *
+ * @return: @x with its bits unshuffled.
+ *
+ * This is the "outer unshuffle" from Hacker's Delight, section 7-2.
+ */
+static inline uint32_t unzip32(uint32_t x)
+{
+	uint32_t t;
+
+	t = (x ^ (x >> 1)) & 0x22222222, x ^= t ^ (t << 1);
+	t = (x ^ (x >> 2)) & 0x0c0c0c0c, x ^= t ^ (t << 2);
+	t = (x ^ (x >> 4)) & 0x00f000f0, x ^= t ^ (t << 4);
+	t = (x ^ (x >> 8)) & 0x0000ff00, x ^= t ^ (t << 8);
+	return x;
+}
+
+/**
+ * zip32 - Inverse of unzip32().
+ *
+ * @x: 32-bit unsigned integer.
+ *
+ * @return: @x with its bits shuffled.
+ */
+static inline uint32_t zip32(uint32_t x)
+{
+	uint32_t t;
+
+	t = (x ^ (x >> 8)) & 0x0000ff00, x ^= t ^ (t << 8);
+	t = (x ^ (x >> 4)) & 0x00f000f0, x ^= t ^ (t << 4);
+	t = (x ^ (x >> 2)) & 0x0c0c0c0c, x ^= t ^ (t << 2);
+	t = (x ^ (x >> 1)) & 0x22222222, x ^= t ^ (t << 1);
+	return x;
+}
+
+/**
+ * interleave - Split a lane into its even and odd bits.
+ *
+ * @x: Lane.
+ * @w: Output words: the even bits of @x in @w[0] and the odd bits in @w[1].
+ *
+ * @return: None.
+ */
+static inline void interleave(uint64_t x, uint32_t w[2])
+{
+	uint32_t lo = unzip32(x);
+	uint32_t hi = unzip32(x >> 32);
+
+	w[0] = (lo & 0xffff) | hi << 16;
+	w[1] = lo >> 16 | (hi & 0xffff0000);
+}
+
+/**
+ * deinterleave - Inverse of interleave().
+ *
+ * @w: Even and odd words of a lane.
+ *
+ * @return: The lane.
+ */
+static inline uint64_t deinterleave(const uint32_t w[2])
+{
+	uint32_t lo = zip32((w[0] & 0xffff) | w[1] << 16);
+	uint32_t hi = zip32(w[0] >> 16 | (w[1] & 0xffff0000));
+
+	return (uint64_t)hi << 32 | lo;
+}
+
+/**
+ * permute - KECCAK-p[1600, nr] on a bit-interleaved state.
+ *
+ * @S:  Bit-interleaved state. Lane i is held in @S[2i] and @S[2i + 1].
+ * @nr: Number of rounds, as keccakp_1600().
+ *
+ * @return: None.
+ *
+ * The loops all have constant trip counts and index constant tables, so the
+ * compiler unrolls them and resolves the choice of rotation for each lane.
+ */
+static void permute(uint32_t S[50], size_t nr)
+{
+	for (size_t i_r = 24 - nr; i_r < 24; i_r++) {
+		uint32_t C[10], D[10], B[50];
+
+		/* θ(A) */
+		for (size_t x = 0; x < 5; x++) {
+			C[2 * x] = S[2 * x] ^ S[2 * x + 10] ^ S[2 * x + 20]
+			         ^ S[2 * x + 30] ^ S[2 * x + 40];
+			C[2 * x + 1] = S[2 * x + 1] ^ S[2 * x + 11]
+			             ^ S[2 * x + 21] ^ S[2 * x + 31]
+			             ^ S[2 * x + 41];
+		}
+
+		/* D[x] = C[x - 1] ^ rotl64(C[x + 1], 1) */
+		for (size_t x = 0; x < 5; x++) {
+			size_t l = (x + 4) % 5, r = (x + 1) % 5;
+			D[2 * x] = C[2 * l] ^ rotl32(C[2 * r + 1], 1);
+			D[2 * x + 1] = C[2 * l + 1] ^ C[2 * r];
+		}
+
+		/* ρ(A) and π(A) */
+		for (size_t i = 0; i < 25; i++) {
+			uint32_t e = S[2 * i] ^ D[2 * (i % 5)];
+			uint32_t o = S[2 * i + 1] ^ D[2 * (i % 5) + 1];
+			unsigned r = rho[i];
+			size_t d = pi[i];
+
+			if (r & 1) {
+				B[2 * d] = rotl32(o, r / 2 + 1);
+				B[2 * d + 1] = rotl32(e, r / 2);
+			} else {
+				B[2 * d] = rotl32(e, r / 2);
+				B[2 * d + 1] = rotl32(o, r / 2);
+			}
+		}
+
+		/* χ(A) */
+		for (size_t y = 0; y < 25; y += 5) {
+			for (size_t x = 0; x < 5; x++) {
+				size_t a = y + x;
+				size_t b = y + (x + 1) % 5;
+				size_t c = y + (x + 2) % 5;
+
+				S[2 * a] = B[2 * a] ^ (~B[2 * b] & B[2 * c]);
+				S[2 * a + 1] = B[2 * a + 1]
+				             ^ (~B[2 * b + 1] & B[2 * c + 1]);
+			}
+		}
+
+		/* ι(A, i_r) */
+		S[0] ^= rc32[i_r][0];
+		S[1] ^= rc32[i_r][1];
+	}
+}
+
+void keccakp_1600_32(uint64_t A[25], size_t nr)
+{
+	uint32_t S[50];
+
+	for (size_t i = 0; i < 25; i++)
+		interleave(A[i], &S[2 * i]);
+
+	permute(S, nr);
+
+	for (size_t i = 0; i < 25; i++)
+		A[i] = deinterleave(&S[2 * i]);
+}
+
+void keccakp_1600_xn_32(uint64_t *A, size_t n, size_t nr)
+{
+	for (size_t j = 0; j < n; j++) {
+		uint32_t S[50];
+
+		for (size_t i = 0; i < 25; i++)
+			interleave(A[n * i + j], &S[2 * i]);
+
+		permute(S, nr);
+
+		for (size_t i = 0; i < 25; i++)
+			A[n * i + j] = deinterleave(&S[2 * i]);
+	}
+}
+
+size_t keccak_absorb_32(uint64_t A[25], const void *buf, size_t len,
+                        size_t rate, size_t nr)
+{
+	const uint8_t *p = buf;
+	uint32_t S[50];
+	size_t n = 0;
+
+	if (len < rate)
+		return 0;
+
+	for (size_t i = 0; i < 25; i++)
+		interleave(A[i], &S[2 * i]);
+
+	for (; len - n >= rate; n += rate) {
+		for (size_t i = 0; i < rate / 8; i++, p += 8) {
+			uint32_t w[2];
+			interleave(load64le(p), w);
+			S[2 * i] ^= w[0];
+			S[2 * i + 1] ^= w[1];
+		}
+
+		permute(S, nr);
+	}
+
+	for (size_t i = 0; i < 25; i++)
+		A[i] = deinterleave(&S[2 * i]);
+
+	return n;
+}
@@ -0,0 +1,81 @@
+/* SPDX-License-Identifier: 0BSD
+ *
+ * Copyright © 2022 Alex Minghella <a@minghella.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * KECCAK-p[1600] permutations using the ARMv8.2-A SHA3 extension.
+ *
+ * The extension adds four Advanced SIMD instructions which map directly onto
+ * the step mappings:
+ *
+ *     EOR3  a ^ b ^ c                 θ parity
+ *     RAX1  a ^ rotl64(b, 1)          θ column effect
+ *     XAR   rotr64(a ^ b, n)          θ application, then ρ (and π for free)
+ *     BCAX  a ^ (b & ~c)              χ
+ *
+ * Each 128-bit register holds the same lane of two states. The single-state
+ * permutation simply computes the same state in both halves.
+ */
+
+#include "keccak.h"
+
+#if defined(KECCAK_HAVE_ARM64)
+
+#include <arm_neon.h>
+
+#if defined(__clang__)
+	#define ARM_SHA3 __attribute__((target("sha3")))
+#else
+	#define ARM_SHA3 __attribute__((target("arch=armv8.2-a+sha3")))
+#endif
+
+#define KECCAK_NAME         keccakp_1600_arm_sha3_lanes
+#define KECCAK_ATTR         ARM_SHA3
+#define KECCAK_LANE         uint64x2_t
+#define KECCAK_XOR(a, b)    veorq_u64(a, b)
+#define KECCAK_XOR5(a, b, c, d, e) veor3q_u64(veor3q_u64(a, b, c), d, e)
+#define KECCAK_RAX1(a, b)   vrax1q_u64(a, b)
+#define KECCAK_XAR(a, b, n) vxarq_u64(a, b, 64 - (n))
+#define KECCAK_CHI(a, b, c) vbcaxq_u64(a, c, b)
+#define KECCAK_RC(i)        vdupq_n_u64(keccak_rc[i])
+#include "keccak-unroll.h"
+
+ARM_SHA3 void keccakp_1600_arm_sha3(uint64_t A[25], size_t nr)
+{
+	uint64x2_t L[25];
+
+	for (size_t i = 0; i < 25; i++)
+		L[i] = vdupq_n_u64(A[i]);
+
+	keccakp_1600_arm_sha3_lanes(L, nr);
+
+	for (size_t i = 0; i < 25; i++)
+		A[i] = vgetq_lane_u64(L[i], 0);
+}
+
+ARM_SHA3 void keccakp_1600_x2_arm_sha3(uint64_t *A, size_t n, size_t nr)
+{
+	uint64x2_t L[25];
+
+	for (size_t i = 0; i < 25; i++)
+		L[i] = vld1q_u64(&A[n * i]);
+
+	keccakp_1600_arm_sha3_lanes(L, nr);
+
+	for (size_t i = 0; i < 25; i++)
+		vst1q_u64(&A[n * i], L[i]);
+}
+
+#endif /* KECCAK_HAVE_ARM64 */
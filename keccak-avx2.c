@@ -0,0 +1,79 @@
+/* SPDX-License-Identifier: 0BSD
+ *
+ * Copyright © 2022 Alex Minghella <a@minghella.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Four-way KECCAK-p[1600] permutation using AVX2.
+ *
+ * Each 256-bit register holds the same lane of four independent states, so a
+ * single pass through the unrolled rounds permutes all four at once. AVX2 has
+ * no 64-bit rotate, so rotations are built from a shift pair, except for the
+ * byte-aligned rotations by 8 and 56 which are a single byte shuffle.
+ */
+
+#include "keccak.h"
+
+#if defined(KECCAK_HAVE_X86)
+
+#include <immintrin.h>
+
+#define AVX2 __attribute__((target("avx2")))
+
+static inline AVX2 __m256i rotl64_avx2(__m256i x, int n)
+{
+	if (n == 8) {
+		const __m256i r8 = _mm256_setr_epi8(
+			7, 0, 1, 2, 3, 4, 5, 6, 15, 8, 9, 10, 11, 12, 13, 14,
+			7, 0, 1, 2, 3, 4, 5, 6, 15, 8, 9, 10, 11, 12, 13, 14);
+		return _mm256_shuffle_epi8(x, r8);
+	}
+
+	if (n == 56) {
+		const __m256i r56 = _mm256_setr_epi8(
+			1, 2, 3, 4, 5, 6, 7, 0, 9, 10, 11, 12, 13, 14, 15, 8,
+			1, 2, 3, 4, 5, 6, 7, 0, 9, 10, 11, 12, 13, 14, 15, 8);
+		return _mm256_shuffle_epi8(x, r56);
+	}
+
+	return _mm256_or_si256(_mm256_slli_epi64(x, n), _mm256_srli_epi64(x, 64 - n));
+}
+
+#define KECCAK_NAME         keccakp_1600_avx2_lanes
+#define KECCAK_ATTR         AVX2
+#define KECCAK_LANE         __m256i
+#define KECCAK_XOR(a, b)    _mm256_xor_si256(a, b)
+#define KECCAK_XOR5(a, b, c, d, e) \
+	_mm256_xor_si256(_mm256_xor_si256(_mm256_xor_si256(a, b), \
+	                                  _mm256_xor_si256(c, d)), e)
+#define KECCAK_RAX1(a, b)   _mm256_xor_si256(a, rotl64_avx2(b, 1))
+#define KECCAK_XAR(a, b, n) rotl64_avx2(_mm256_xor_si256(a, b), n)
+#define KECCAK_CHI(a, b, c) _mm256_xor_si256(a, _mm256_andnot_si256(b, c))
+#define KECCAK_RC(i)        _mm256_set1_epi64x(keccak_rc[i])
+#include "keccak-unroll.h"
+
+AVX2 void keccakp_1600_x4_avx2(uint64_t *A, size_t n, size_t nr)
+{
+	__m256i L[25];
+
+	for (size_t i = 0; i < 25; i++)
+		L[i] = _mm256_loadu_si256((const __m256i *)&A[n * i]);
+
+	keccakp_1600_avx2_lanes(L, nr);
+
+	for (size_t i = 0; i < 25; i++)
+		_mm256_storeu_si256((__m256i *)&A[n * i], L[i]);
+}
+
+#endif /* KECCAK_HAVE_X86 */
@@ -0,0 +1,201 @@
+/* SPDX-License-Identifier: 0BSD
+ *
+ * Copyright © 2022 Alex Minghella <a@minghella.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * KECCAK-p[1600] permutations using AVX-512.
+ *
+ * AVX-512F provides a native 64-bit rotate (vprolq/vprolvq) and a three-input
+ * logic instruction (vpternlogq) which computes χ for a lane, or a three-way
+ * XOR for θ, in a single instruction.
+ *
+ * The single-state permutation keeps each plane (row) of the state in the low
+ * five elements of a 512-bit register and moves lanes between planes with
+ * two-source permutes. The eight-way permutation instead has one lane of eight
+ * independent states in each register, like the AVX2 four-way version.
+ */
+
+#include "keccak.h"
+
+#if defined(KECCAK_HAVE_X86)
+
+#include <immintrin.h>
+
+#define AVX512 __attribute__((target("avx512f")))
+
+/*
+ * Truth tables for vpternlogq: a ^ b ^ c, and a ^ (~b & c).
+ */
+#define XOR3 0x96
+#define CHI  0xd2
+
+static inline AVX512 void keccakp_1600_planes(__m512i P[5], size_t nr)
+{
+	/*
+	 * The ρ offsets from Table 2 of FIPS 202, one plane per register. See
+	 * the loop-based keccakp_1600() for the unreduced values.
+	 */
+	const __m512i rho[5] = {
+		_mm512_setr_epi64( 0,  1, 62, 28, 27, 0, 0, 0),
+		_mm512_setr_epi64(36, 44,  6, 55, 20, 0, 0, 0),
+		_mm512_setr_epi64( 3, 10, 43, 25, 39, 0, 0, 0),
+		_mm512_setr_epi64(41, 45, 15, 21,  8, 0, 0, 0),
+		_mm512_setr_epi64(18,  2, 61, 56, 14, 0, 0, 0),
+	};
+
+	/* Element x of a plane becomes element x - 1, x + 1, or x + 2. */
+	const __m512i xm1 = _mm512_setr_epi64(4, 0, 1, 2, 3, 5, 6, 7);
+	const __m512i xp1 = _mm512_setr_epi64(1, 2, 3, 4, 0, 5, 6, 7);
+	const __m512i xp2 = _mm512_setr_epi64(2, 3, 4, 0, 1, 5, 6, 7);
+
+	/*
+	 * π moves Lane((x + 3y) mod 5, x) to Lane(x, y), so each output plane
+	 * takes one lane from every input plane. Two two-source permutes gather
+	 * elements 0-1 and 2-3 from planes 0-1 and 2-3 respectively, they're
+	 * merged, and element 4 is permuted in from plane 4. Indices 8-15 select
+	 * from the second source of a two-source permute.
+	 */
+	const __m512i pi01[5] = {
+		_mm512_setr_epi64(0, 9, 0, 0, 0, 0, 0, 0),
+		_mm512_setr_epi64(3, 12, 0, 0, 0, 0, 0, 0),
+		_mm512_setr_epi64(1, 10, 0, 0, 0, 0, 0, 0),
+		_mm512_setr_epi64(4, 8, 0, 0, 0, 0, 0, 0),
+		_mm512_setr_epi64(2, 11, 0, 0, 0, 0, 0, 0),
+	};
+	const __m512i pi23[5] = {
+		_mm512_setr_epi64(0, 0, 2, 11, 0, 0, 0, 0),
+		_mm512_setr_epi64(0, 0, 0, 9, 0, 0, 0, 0),
+		_mm512_setr_epi64(0, 0, 3, 12, 0, 0, 0, 0),
+		_mm512_setr_epi64(0, 0, 1, 10, 0, 0, 0, 0),
+		_mm512_setr_epi64(0, 0, 4, 8, 0, 0, 0, 0),
+	};
+	const __m512i pi4[5] = {
+		_mm512_setr_epi64(0, 0, 0, 0, 4, 0, 0, 0),
+		_mm512_setr_epi64(0, 0, 0, 0, 2, 0, 0, 0),
+		_mm512_setr_epi64(0, 0, 0, 0, 0, 0, 0, 0),
+		_mm512_setr_epi64(0, 0, 0, 0, 3, 0, 0, 0),
+		_mm512_setr_epi64(0, 0, 0, 0, 1, 0, 0, 0),
+	};
+
+	for (size_t i_r = 24 - nr; i_r < 24; i_r++) {
+		/* θ(A) */
+		__m512i parity = _mm512_ternarylogic_epi64(P[0], P[1], P[2], XOR3);
+		parity = _mm512_ternarylogic_epi64(parity, P[3], P[4], XOR3);
+
+		__m512i lo = _mm512_permutexvar_epi64(xm1, parity);
+		__m512i hi = _mm512_rol_epi64(_mm512_permutexvar_epi64(xp1, parity), 1);
+
+		/* ρ∘θ(A) */
+		for (size_t y = 0; y < 5; y++) {
+			P[y] = _mm512_ternarylogic_epi64(P[y], lo, hi, XOR3);
+			P[y] = _mm512_rolv_epi64(P[y], rho[y]);
+		}
+
+		/* π(A) */
+		__m512i B[5];
+		for (size_t y = 0; y < 5; y++) {
+			__m512i t01 = _mm512_permutex2var_epi64(P[0], pi01[y], P[1]);
+			__m512i t23 = _mm512_permutex2var_epi64(P[2], pi23[y], P[3]);
+			B[y] = _mm512_mask_blend_epi64(0x0c, t01, t23);
+			B[y] = _mm512_mask_permutexvar_epi64(B[y], 0x10, pi4[y], P[4]);
+		}
+
+		/* χ(A) */
+		for (size_t y = 0; y < 5; y++) {
+			P[y] = _mm512_ternarylogic_epi64(B[y],
+				_mm512_permutexvar_epi64(xp1, B[y]),
+				_mm512_permutexvar_epi64(xp2, B[y]), CHI);
+		}
+
+		/* ι(A, i_r) */
+		P[0] = _mm512_xor_si512(P[0], _mm512_maskz_set1_epi64(1, keccak_rc[i_r]));
+	}
+}
+
+AVX512 void keccakp_1600_avx512(uint64_t A[25], size_t nr)
+{
+	__m512i P[5];
+	for (size_t y = 0; y < 5; y++)
+		P[y] = _mm512_maskz_loadu_epi64(0x1f, &A[5 * y]);
+
+	keccakp_1600_planes(P, nr);
+
+	for (size_t y = 0; y < 5; y++)
+		_mm512_mask_storeu_epi64(&A[5 * y], 0x1f, P[y]);
+}
+
+AVX512 size_t keccak_absorb_avx512(uint64_t A[25], const void *buf, size_t len,
+                                   size_t rate, size_t nr)
+{
+	const uint8_t *p = buf;
+	size_t n = 0;
+
+	/*
+	 * A block covers the first rate / 8 lanes of the state, so build a
+	 * load mask for each plane. Masked-off elements are never read, so
+	 * this doesn't touch memory beyond the end of the block.
+	 */
+	__mmask8 m[5];
+	for (size_t y = 0; y < 5; y++) {
+		size_t lanes = rate / 8 > 5 * y ? rate / 8 - 5 * y : 0;
+		m[y] = lanes >= 5 ? 0x1f : (1U << lanes) - 1;
+	}
+
+	__m512i P[5];
+	for (size_t y = 0; y < 5; y++)
+		P[y] = _mm512_maskz_loadu_epi64(0x1f, &A[5 * y]);
+
+	for (; len - n >= rate; n += rate) {
+		for (size_t y = 0; y < 5; y++) {
+			__m512i B = _mm512_maskz_loadu_epi64(m[y], p + n + 40 * y);
+			P[y] = _mm512_xor_si512(P[y], B);
+		}
+
+		keccakp_1600_planes(P, nr);
+	}
+
+	for (size_t y = 0; y < 5; y++)
+		_mm512_mask_storeu_epi64(&A[5 * y], 0x1f, P[y]);
+
+	return n;
+}
+
+#define KECCAK_NAME         keccakp_1600_avx512_lanes
+#define KECCAK_ATTR         AVX512
+#define KECCAK_LANE         __m512i
+#define KECCAK_XOR(a, b)    _mm512_xor_si512(a, b)
+#define KECCAK_XOR5(a, b, c, d, e) \
+	_mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(a, b, c, XOR3), \
+	                          d, e, XOR3)
+#define KECCAK_RAX1(a, b)   _mm512_xor_si512(a, _mm512_rol_epi64(b, 1))
+#define KECCAK_XAR(a, b, n) _mm512_rol_epi64(_mm512_xor_si512(a, b), n)
+#define KECCAK_CHI(a, b, c) _mm512_ternarylogic_epi64(a, b, c, CHI)
+#define KECCAK_RC(i)        _mm512_set1_epi64(keccak_rc[i])
+#include "keccak-unroll.h"
+
+AVX512 void keccakp_1600_x8_avx512(uint64_t A[200], size_t nr)
+{
+	__m512i L[25];
+
+	for (size_t i = 0; i < 25; i++)
+		L[i] = _mm512_loadu_si512(&A[8 * i]);
+
+	keccakp_1600_avx512_lanes(L, nr);
+
+	for (size_t i = 0; i < 25; i++)
+		_mm512_storeu_si512(&A[8 * i], L[i]);
+}
+
+#endif /* KECCAK_HAVE_X86 */
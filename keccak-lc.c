@@ -0,0 +1,301 @@
+/* SPDX-License-Identifier: 0BSD
+ *
+ * Copyright © 2022 Alex Minghella <a@minghella.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Lane-complementing KECCAK-p[1600] permutation for scalar cores.
+ *
+ * χ computes a ^ (~b & c) for every lane, which is two instructions on cores
+ * with an and-not instruction but three everywhere else. The Keccak team's
+ * lane-complementing transform [1] keeps six lanes of the state inverted
+ * between rounds, which lets χ be rewritten so that each row needs only one
+ * NOT, with the other and-nots turned into ANDs and ORs of the complemented
+ * lanes. θ, ρ, and π are linear, so they work unchanged on the complemented
+ * lanes, and so does XORing in input.
+ *
+ * The state is also held in 25 local variables for the whole permutation,
+ * with each round computed from one set into another, rather than updated in
+ * place in an array. keccak_absorb_lc() keeps the state in those variables,
+ * complemented, across every block it absorbs, so the lanes are only
+ * complemented on entry and exit and only loaded and stored once.
+ *
+ * The χ expressions are those of KeccakP-1600-64.macros in the eXtended Keccak
+ * Code Package, with its lane names translated to Index(x + 5y).
+ */
+
+/*
+ * References
+ *
+ * [1] The Keccak team, Keccak implementation overview, version 3.2, section
+ *     2.2, https://keccak.team/files/Keccak-implementation-3.2.pdf
+ */
+
+#include "keccak.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * The lanes kept complemented between rounds: Lane(1, 0), Lane(2, 0),
+ * Lane(3, 1), Lane(2, 2), Lane(2, 3), and Lane(0, 4).
+ */
+static inline void lc_complement(uint64_t A[25])
+{
+	A[ 1] = ~A[ 1];
+	A[ 2] = ~A[ 2];
+	A[ 8] = ~A[ 8];
+	A[12] = ~A[12];
+	A[17] = ~A[17];
+	A[20] = ~A[20];
+}
+
+#define LC_LANES(X) \
+	X##0,  X##1,  X##2,  X##3,  X##4,  X##5,  X##6,  X##7,  X##8, \
+	X##9,  X##10, X##11, X##12, X##13, X##14, X##15, X##16, X##17, \
+	X##18, X##19, X##20, X##21, X##22, X##23, X##24
+
+#define LC_LOAD(X, A) \
+	do { \
+		X##0  = (A)[0];  X##1  = (A)[1];  X##2  = (A)[2]; \
+		X##3  = (A)[3];  X##4  = (A)[4];  X##5  = (A)[5]; \
+		X##6  = (A)[6];  X##7  = (A)[7];  X##8  = (A)[8]; \
+		X##9  = (A)[9];  X##10 = (A)[10]; X##11 = (A)[11]; \
+		X##12 = (A)[12]; X##13 = (A)[13]; X##14 = (A)[14]; \
+		X##15 = (A)[15]; X##16 = (A)[16]; X##17 = (A)[17]; \
+		X##18 = (A)[18]; X##19 = (A)[19]; X##20 = (A)[20]; \
+		X##21 = (A)[21]; X##22 = (A)[22]; X##23 = (A)[23]; \
+		X##24 = (A)[24]; \
+	} while (0)
+
+#define LC_STORE(A, X) \
+	do { \
+		(A)[0]  = X##0;  (A)[1]  = X##1;  (A)[2]  = X##2; \
+		(A)[3]  = X##3;  (A)[4]  = X##4;  (A)[5]  = X##5; \
+		(A)[6]  = X##6;  (A)[7]  = X##7;  (A)[8]  = X##8; \
+		(A)[9]  = X##9;  (A)[10] = X##10; (A)[11] = X##11; \
+		(A)[12] = X##12; (A)[13] = X##13; (A)[14] = X##14; \
+		(A)[15] = X##15; (A)[16] = X##16; (A)[17] = X##17; \
+		(A)[18] = X##18; (A)[19] = X##19; (A)[20] = X##20; \
+		(A)[21] = X##21; (A)[22] = X##22; (A)[23] = X##23; \
+		(A)[24] = X##24; \
+	} while (0)
+
+/*
+ * One round from the lanes A0 to A24 into the lanes E0 to E24, each set in
+ * complemented form.
+ */
+#define LC_ROUND(A, E, rc) \
+	do { \
+		uint64_t C0, C1, C2, C3, C4, D0, D1, D2, D3, D4; \
+		uint64_t B0, B1, B2, B3, B4; \
+		\
+		/* θ */ \
+		C0 = A##0 ^ A##5 ^ A##10 ^ A##15 ^ A##20; \
+		C1 = A##1 ^ A##6 ^ A##11 ^ A##16 ^ A##21; \
+		C2 = A##2 ^ A##7 ^ A##12 ^ A##17 ^ A##22; \
+		C3 = A##3 ^ A##8 ^ A##13 ^ A##18 ^ A##23; \
+		C4 = A##4 ^ A##9 ^ A##14 ^ A##19 ^ A##24; \
+		D0 = C4 ^ rotl64(C1, 1); \
+		D1 = C0 ^ rotl64(C2, 1); \
+		D2 = C1 ^ rotl64(C3, 1); \
+		D3 = C2 ^ rotl64(C4, 1); \
+		D4 = C3 ^ rotl64(C0, 1); \
+		\
+		/* ρ, π, χ, and ι for y = 0 */ \
+		B0 = A##0 ^ D0; \
+		B1 = rotl64(A##6 ^ D1, 44); \
+		B2 = rotl64(A##12 ^ D2, 43); \
+		B3 = rotl64(A##18 ^ D3, 21); \
+		B4 = rotl64(A##24 ^ D4, 14); \
+		E##0 = B0 ^ (B1 | B2) ^ (rc); \
+		E##1 = B1 ^ (~B2 | B3); \
+		E##2 = B2 ^ (B3 & B4); \
+		E##3 = B3 ^ (B4 | B0); \
+		E##4 = B4 ^ (B0 & B1); \
+		\
+		/* y = 1 */ \
+		B0 = rotl64(A##3 ^ D3, 28); \
+		B1 = rotl64(A##9 ^ D4, 20); \
+		B2 = rotl64(A##10 ^ D0, 3); \
+		B3 = rotl64(A##16 ^ D1, 45); \
+		B4 = rotl64(A##22 ^ D2, 61); \
+		E##5 = B0 ^ (B1 | B2); \
+		E##6 = B1 ^ (B2 & B3); \
+		E##7 = B2 ^ (B3 | ~B4); \
+		E##8 = B3 ^ (B4 | B0); \
+		E##9 = B4 ^ (B0 & B1); \
+		\
+		/* y = 2 */ \
+		B0 = rotl64(A##1 ^ D1, 1); \
+		B1 = rotl64(A##7 ^ D2, 6); \
+		B2 = rotl64(A##13 ^ D3, 25); \
+		B3 = rotl64(A##19 ^ D4, 8); \
+		B4 = rotl64(A##20 ^ D0, 18); \
+		E##10 = B0 ^ (B1 | B2); \
+		E##11 = B1 ^ (B2 & B3); \
+		E##12 = B2 ^ (~B3 & B4); \
+		E##13 = ~B3 ^ (B4 | B0); \
+		E##14 = B4 ^ (B0 & B1); \
+		\
+		/* y = 3 */ \
+		B0 = rotl64(A##4 ^ D4, 27); \
+		B1 = rotl64(A##5 ^ D0, 36); \
+		B2 = rotl64(A##11 ^ D1, 10); \
+		B3 = rotl64(A##17 ^ D2, 15); \
+		B4 = rotl64(A##23 ^ D3, 56); \
+		E##15 = B0 ^ (B1 & B2); \
+		E##16 = B1 ^ (B2 | B3); \
+		E##17 = B2 ^ (~B3 | B4); \
+		E##18 = ~B3 ^ (B4 & B0); \
+		E##19 = B4 ^ (B0 | B1); \
+		\
+		/* y = 4 */ \
+		B0 = rotl64(A##2 ^ D2, 62); \
+		B1 = rotl64(A##8 ^ D3, 55); \
+		B2 = rotl64(A##14 ^ D4, 39); \
+		B3 = rotl64(A##15 ^ D0, 41); \
+		B4 = rotl64(A##21 ^ D1, 2); \
+		E##20 = B0 ^ (~B1 & B2); \
+		E##21 = ~B1 ^ (B2 | B3); \
+		E##22 = B2 ^ (B3 & B4); \
+		E##23 = B3 ^ (B4 | B0); \
+		E##24 = B4 ^ (B0 & B1); \
+	} while (0)
+
+/**
+ * lc_rounds - Apply the last @nr rounds to a complemented state.
+ *
+ * @S:  Keccak internal state in complemented form.
+ * @nr: Number of rounds, as keccakp_1600().
+ *
+ * @return: None.
+ *
+ * Rounds are done in pairs, from the A lanes into the E lanes and back, so
+ * that no lanes need to be copied. An odd round count starts with a single
+ * round and one copy.
+ */
+static inline __attribute__((always_inline))
+void lc_rounds(uint64_t S[25], size_t nr)
+{
+	const uint64_t *RC = keccak_rc;
+	uint64_t LC_LANES(A), LC_LANES(E);
+	size_t i = 24 - nr;
+
+	LC_LOAD(A, S);
+
+	if (nr & 1) {
+		LC_ROUND(A, E, RC[i]);
+		A0  = E0;  A1  = E1;  A2  = E2;  A3  = E3;  A4  = E4;
+		A5  = E5;  A6  = E6;  A7  = E7;  A8  = E8;  A9  = E9;
+		A10 = E10; A11 = E11; A12 = E12; A13 = E13; A14 = E14;
+		A15 = E15; A16 = E16; A17 = E17; A18 = E18; A19 = E19;
+		A20 = E20; A21 = E21; A22 = E22; A23 = E23; A24 = E24;
+		i++;
+	}
+
+	for (; i < 24; i += 2) {
+		LC_ROUND(A, E, RC[i]);
+		LC_ROUND(E, A, RC[i + 1]);
+	}
+
+	LC_STORE(S, A);
+}
+
+void keccakp_1600_lc(uint64_t A[25], size_t nr)
+{
+	lc_complement(A);
+	lc_rounds(A, nr);
+	lc_complement(A);
+}
+
+void keccakp_1600_xn_lc(uint64_t *A, size_t n, size_t nr)
+{
+	for (size_t j = 0; j < n; j++) {
+		uint64_t S[25];
+
+		for (size_t i = 0; i < 25; i++)
+			S[i] = A[n * i + j];
+
+		keccakp_1600_lc(S, nr);
+
+		for (size_t i = 0; i < 25; i++)
+			A[n * i + j] = S[i];
+	}
+}
+
+/**
+ * lc_absorb_rate - Absorb whole blocks with a fixed rate.
+ *
+ * As keccak_absorb_rate() in sha3.c, but with the state complemented for the
+ * whole loop. Input is XORed into complemented lanes as it is into ordinary
+ * ones, since ~a ^ b = ~(a ^ b).
+ */
+static inline __attribute__((always_inline))
+size_t lc_absorb_rate(uint64_t A[25], const void *buf, size_t len,
+                      size_t rate, size_t nr)
+{
+	const uint8_t *p = buf;
+	uint64_t S[25];
+	size_t n = 0;
+
+	if (len < rate)
+		return 0;
+
+	memcpy(S, A, sizeof(S));
+	lc_complement(S);
+
+	for (; len - n >= rate; n += rate, p += rate) {
+		for (size_t i = 0; i < rate / 8; i++)
+			S[i] ^= load64le(p + 8 * i);
+
+		lc_rounds(S, nr);
+	}
+
+	lc_complement(S);
+	memcpy(A, S, sizeof(S));
+	return n;
+}
+
+#define LC_ABSORB_RATE(rate) \
+	static size_t lc_absorb_##rate(uint64_t A[25], const void *buf, \
+	                               size_t len, size_t nr) \
+	{ \
+		return lc_absorb_rate(A, buf, len, rate, nr); \
+	}
+
+LC_ABSORB_RATE(72)
+LC_ABSORB_RATE(104)
+LC_ABSORB_RATE(136)
+LC_ABSORB_RATE(144)
+LC_ABSORB_RATE(168)
+
+size_t keccak_absorb_lc(uint64_t A[25], const void *buf, size_t len,
+                        size_t rate, size_t nr)
+{
+	switch (rate) {
+	case 200 - 2 * SHA3_512:
+		return lc_absorb_72(A, buf, len, nr);
+	case 200 - 2 * SHA3_384:
+		return lc_absorb_104(A, buf, len, nr);
+	case 200 - 2 * SHA3_256:
+		return lc_absorb_136(A, buf, len, nr);
+	case 200 - 2 * SHA3_224:
+		return lc_absorb_144(A, buf, len, nr);
+	case 200 - 2 * SHAKE128:
+		return lc_absorb_168(A, buf, len, nr);
+	default:
+		return keccak_absorb(A, buf, len, rate, nr);
+	}
+}
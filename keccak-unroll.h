@@ -0,0 +1,162 @@
+/* SPDX-License-Identifier: 0BSD
+ *
+ * Copyright © 2022 Alex Minghella <a@minghella.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Unrolled KECCAK-f[1600] rounds over an arbitrary lane type.
+ *
+ * This is the same sequence of steps as the unrolled keccakp_1600() in sha3.c,
+ * written in terms of a handful of operations so that it can be instantiated
+ * for SIMD lane types. The including file must define:
+ *
+ *     KECCAK_NAME             Name of the generated function.
+ *     KECCAK_ATTR             Function attributes, possibly empty.
+ *     KECCAK_LANE             Lane type.
+ *     KECCAK_XOR(a, b)        a ^ b
+ *     KECCAK_XOR5(a, ..., e)  a ^ b ^ c ^ d ^ e
+ *     KECCAK_RAX1(a, b)       a ^ rotl64(b, 1)
+ *     KECCAK_XAR(a, b, n)     rotl64(a ^ b, n), for 1 <= n <= 63
+ *     KECCAK_CHI(a, b, c)     a ^ (~b & c)
+ *     KECCAK_RC(i)            Round constant i, in every element of a lane.
+ *
+ * The generated function has the signature
+ *
+ *     static inline void KECCAK_NAME(KECCAK_LANE A[25], size_t nr);
+ *
+ * and applies the last @nr rounds of KECCAK-f[1600], as keccakp_1600().
+ *
+ * The macros above are undefined again at the end of this file so that it
+ * may be included more than once.
+ */
+
+static inline KECCAK_ATTR void KECCAK_NAME(KECCAK_LANE A[25], size_t nr)
+{
+	for (size_t i_r = 24 - nr; i_r < 24; i_r++) {
+		KECCAK_LANE parity[5];
+		parity[0] = KECCAK_XOR5(A[0], A[5], A[10], A[15], A[20]);
+		parity[1] = KECCAK_XOR5(A[1], A[6], A[11], A[16], A[21]);
+		parity[2] = KECCAK_XOR5(A[2], A[7], A[12], A[17], A[22]);
+		parity[3] = KECCAK_XOR5(A[3], A[8], A[13], A[18], A[23]);
+		parity[4] = KECCAK_XOR5(A[4], A[9], A[14], A[19], A[24]);
+
+		KECCAK_LANE tmp[5];
+		tmp[0] = KECCAK_RAX1(parity[4], parity[1]);
+		tmp[1] = KECCAK_RAX1(parity[0], parity[2]);
+		tmp[2] = KECCAK_RAX1(parity[1], parity[3]);
+		tmp[3] = KECCAK_RAX1(parity[2], parity[4]);
+		tmp[4] = KECCAK_RAX1(parity[3], parity[0]);
+
+		/* π∘ρ∘θ(A) */
+		KECCAK_LANE start = A[1];
+		A[ 0] = KECCAK_XOR(A[0], tmp[0]);
+		A[ 1] = KECCAK_XAR(A[ 6], tmp[1], 44);
+		A[ 6] = KECCAK_XAR(A[ 9], tmp[4], 20);
+		A[ 9] = KECCAK_XAR(A[22], tmp[2], 61);
+		A[22] = KECCAK_XAR(A[14], tmp[4], 39);
+		A[14] = KECCAK_XAR(A[20], tmp[0], 18);
+		A[20] = KECCAK_XAR(A[ 2], tmp[2], 62);
+		A[ 2] = KECCAK_XAR(A[12], tmp[2], 43);
+		A[12] = KECCAK_XAR(A[13], tmp[3], 25);
+		A[13] = KECCAK_XAR(A[19], tmp[4],  8);
+		A[19] = KECCAK_XAR(A[23], tmp[3], 56);
+		A[23] = KECCAK_XAR(A[15], tmp[0], 41);
+		A[15] = KECCAK_XAR(A[ 4], tmp[4], 27);
+		A[ 4] = KECCAK_XAR(A[24], tmp[4], 14);
+		A[24] = KECCAK_XAR(A[21], tmp[1],  2);
+		A[21] = KECCAK_XAR(A[ 8], tmp[3], 55);
+		A[ 8] = KECCAK_XAR(A[16], tmp[1], 45);
+		A[16] = KECCAK_XAR(A[ 5], tmp[0], 36);
+		A[ 5] = KECCAK_XAR(A[ 3], tmp[3], 28);
+		A[ 3] = KECCAK_XAR(A[18], tmp[3], 21);
+		A[18] = KECCAK_XAR(A[17], tmp[2], 15);
+		A[17] = KECCAK_XAR(A[11], tmp[1], 10);
+		A[11] = KECCAK_XAR(A[ 7], tmp[2],  6);
+		A[ 7] = KECCAK_XAR(A[10], tmp[0],  3);
+		A[10] = KECCAK_XAR(start, tmp[1],  1);
+
+		/* χ_0(A) */
+		tmp[0] = A[0];
+		tmp[1] = A[1];
+		tmp[2] = A[2];
+		tmp[3] = A[3];
+		tmp[4] = A[4];
+		A[ 0] = KECCAK_CHI(tmp[0], tmp[1], tmp[2]);
+		A[ 1] = KECCAK_CHI(tmp[1], tmp[2], tmp[3]);
+		A[ 2] = KECCAK_CHI(tmp[2], tmp[3], tmp[4]);
+		A[ 3] = KECCAK_CHI(tmp[3], tmp[4], tmp[0]);
+		A[ 4] = KECCAK_CHI(tmp[4], tmp[0], tmp[1]);
+
+		/* χ_1(A) */
+		tmp[0] = A[5];
+		tmp[1] = A[6];
+		tmp[2] = A[7];
+		tmp[3] = A[8];
+		tmp[4] = A[9];
+		A[ 5] = KECCAK_CHI(tmp[0], tmp[1], tmp[2]);
+		A[ 6] = KECCAK_CHI(tmp[1], tmp[2], tmp[3]);
+		A[ 7] = KECCAK_CHI(tmp[2], tmp[3], tmp[4]);
+		A[ 8] = KECCAK_CHI(tmp[3], tmp[4], tmp[0]);
+		A[ 9] = KECCAK_CHI(tmp[4], tmp[0], tmp[1]);
+
+		/* χ_2(A) */
+		tmp[0] = A[10];
+		tmp[1] = A[11];
+		tmp[2] = A[12];
+		tmp[3] = A[13];
+		tmp[4] = A[14];
+		A[10] = KECCAK_CHI(tmp[0], tmp[1], tmp[2]);
+		A[11] = KECCAK_CHI(tmp[1], tmp[2], tmp[3]);
+		A[12] = KECCAK_CHI(tmp[2], tmp[3], tmp[4]);
+		A[13] = KECCAK_CHI(tmp[3], tmp[4], tmp[0]);
+		A[14] = KECCAK_CHI(tmp[4], tmp[0], tmp[1]);
+
+		/* χ_3(A) */
+		tmp[0] = A[15];
+		tmp[1] = A[16];
+		tmp[2] = A[17];
+		tmp[3] = A[18];
+		tmp[4] = A[19];
+		A[15] = KECCAK_CHI(tmp[0], tmp[1], tmp[2]);
+		A[16] = KECCAK_CHI(tmp[1], tmp[2], tmp[3]);
+		A[17] = KECCAK_CHI(tmp[2], tmp[3], tmp[4]);
+		A[18] = KECCAK_CHI(tmp[3], tmp[4], tmp[0]);
+		A[19] = KECCAK_CHI(tmp[4], tmp[0], tmp[1]);
+
+		/* χ_4(A) */
+		tmp[0] = A[20];
+		tmp[1] = A[21];
+		tmp[2] = A[22];
+		tmp[3] = A[23];
+		tmp[4] = A[24];
+		A[20] = KECCAK_CHI(tmp[0], tmp[1], tmp[2]);
+		A[21] = KECCAK_CHI(tmp[1], tmp[2], tmp[3]);
+		A[22] = KECCAK_CHI(tmp[2], tmp[3], tmp[4]);
+		A[23] = KECCAK_CHI(tmp[3], tmp[4], tmp[0]);
+		A[24] = KECCAK_CHI(tmp[4], tmp[0], tmp[1]);
+
+		/* ι(A, i_r) */
+		A[0] = KECCAK_XOR(A[0], KECCAK_RC(i_r));
+	}
+}
+
+#undef KECCAK_NAME
+#undef KECCAK_ATTR
+#undef KECCAK_LANE
+#undef KECCAK_XOR
+#undef KECCAK_XOR5
+#undef KECCAK_RAX1
+#undef KECCAK_XAR
+#undef KECCAK_CHI
+#undef KECCAK_RC
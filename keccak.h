@@ -0,0 +1,543 @@
+/* SPDX-License-Identifier: 0BSD
+ *
+ * Copyright © 2022 Alex Minghella <a@minghella.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Internal interfaces shared between the translation units of the library.
+ * Nothing in here is part of the public API.
+ */
+
+#ifndef KECCAK_H
+#define KECCAK_H 1
+
+#include "sha3.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__GNUC__)
+	#define KECCAK_HIDDEN __attribute__((visibility("hidden")))
+#else
+	#define KECCAK_HIDDEN
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define KECCAK_HAVE_X86 1
+#endif
+
+#if defined(__GNUC__) && defined(__aarch64__)
+	#define KECCAK_HAVE_ARM64 1
+#endif
+
+/*
+ * KECCAK_TLS - Storage class for the library's thread-local variables.
+ *
+ * The initial-exec model makes each access a single thread-pointer-relative
+ * load, and unlike local-exec it can be used in the shared library.
+ */
+#if defined(__GNUC__)
+	#define KECCAK_TLS _Thread_local __attribute__((tls_model("initial-exec")))
+#else
+	#define KECCAK_TLS _Thread_local
+#endif
+
+/*
+ * keccak_stats - The calling thread's counters, see sha3_stats_get().
+ *
+ * KECCAK_STAT() adds to one of them when the library is built with SHA3_STATS
+ * and compiles to nothing otherwise.
+ */
+#if defined(SHA3_STATS)
+KECCAK_HIDDEN extern KECCAK_TLS struct sha3_stats keccak_stats;
+
+	#define KECCAK_STAT(field, n) ((void)(keccak_stats.field += (n)))
+#else
+	#define KECCAK_STAT(field, n) ((void)0)
+#endif
+
+/*
+ * USDT probes, for tracing with bpftrace, perf, or SystemTap. Each is a single
+ * no-op instruction until a tracer attaches to it, so they're built in
+ * wherever <sys/sdt.h> is available unless SHA3_NO_PROBES is defined.
+ *
+ *     sha3:update(ctx, len)      Entry to sha3_update().
+ *     sha3:updatev(ctx, iovcnt)  Entry to sha3_updatev().
+ *     sha3:final(ctx, rate)      Entry to sha3_final() and shake_final().
+ */
+#if !defined(SHA3_NO_PROBES) && defined(__has_include)
+	#if __has_include(<sys/sdt.h>)
+		#include <sys/sdt.h>
+		#define KECCAK_PROBE2(name, a, b) STAP_PROBE2(sha3, name, a, b)
+	#endif
+#endif
+
+#if !defined(KECCAK_PROBE2)
+	#define KECCAK_PROBE2(name, a, b) ((void)0)
+#endif
+
+/**
+ * rotl64 - Rotate bits in a 64-bit integer left.
+ *
+ * @x: 64-bit unsigned integer.
+ * @n: Number of steps to rotate bits.
+ *
+ * @return: @x with bits rotated @n steps left.
+ */
+static inline uint64_t rotl64(uint64_t x, size_t n)
+{
+	return (x << n) | (x >> (64 - n));
+}
+
+/*
+ * GCC, Clang, and ICC manage to transform these into byteswap instructions on
+ * instruction sets that have them, and the builtin is used where available so
+ * that it doesn't depend on the optimiser. Combined with the memcpy() in
+ * load64le() and store64le(), it becomes a single byte-reversed load or store
+ * on targets that have one, such as LRVG and STRVG on s390x and LDBRX and
+ * STDBRX on POWER.
+ */
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+static inline uint32_t bswap32(uint32_t x)
+{
+	return x >> 24 | ((x >> 8) & 0xff00) | ((x << 8) & 0xff0000) | x << 24;
+}
+
+static inline uint64_t bswap64(uint64_t x)
+{
+#if defined(__GNUC__)
+	return __builtin_bswap64(x);
+#else
+	return (bswap32(x) + 0ULL) << 32 | bswap32(x >> 32);
+#endif
+}
+
+static inline uint64_t read64le(const uint64_t *p)
+{
+	return bswap64(*p);
+}
+#elif __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+static inline uint64_t read64le(const uint64_t *p)
+{
+	return *p;
+}
+#else
+	#error Unknown endianness.
+#endif
+
+/**
+ * keccak_u8 - Find a byte of the state in the byte-wise view.
+ *
+ * @i: Byte index in the state, counting from the least-significant byte of
+ *     lane 0 as the specification does.
+ *
+ * @return: Index of the byte in @u8 of struct sha3_ctx.
+ *
+ * On a big-endian host the bytes of each lane are stored in reverse order.
+ */
+static inline size_t keccak_u8(size_t i)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	return i ^ 7;
+#else
+	return i;
+#endif
+}
+
+/**
+ * load64le - Read a little-endian 64-bit integer from any address.
+ *
+ * @p: Pointer to 8 bytes of input. Need not be aligned.
+ *
+ * @return: The 64-bit integer at @p.
+ */
+static inline uint64_t load64le(const void *p)
+{
+	uint64_t x;
+	memcpy(&x, p, 8);
+	return read64le(&x);
+}
+
+/**
+ * store64le - Write a 64-bit integer in little-endian order to any address.
+ *
+ * @p: Pointer to 8 bytes of output. Need not be aligned.
+ * @x: 64-bit integer.
+ *
+ * @return: None.
+ */
+static inline void store64le(void *p, uint64_t x)
+{
+	x = read64le(&x);
+	memcpy(p, &x, 8);
+}
+
+/**
+ * keccak_last_block - Load the final, partial block of input with its padding.
+ *
+ * @A:      Lane 0 of the Keccak internal state.
+ * @stride: Distance between lanes in @A, 1 for a single state or n for one of
+ *          n interleaved states.
+ * @buf:    Pointer to the rest of the input. There are no alignment
+ *          requirements.
+ * @len:    Length, in bytes, of the rest of the input. Less than @rate.
+ * @rate:   Padding rate in bytes.
+ * @ds:     Domain separation byte, as keccak_pad().
+ * @store:  Whether to store the block into the state rather than XORing it
+ *          in. Storing also clears the rest of the state, so the state needs
+ *          no initialisation.
+ *
+ * @return: None.
+ *
+ * The block is assembled a lane at a time in registers, rather than copied
+ * into a zeroed buffer and padded there. With constant @rate and @store, this
+ * inlines to straight-line code apart from the loops over @len.
+ */
+static inline void keccak_last_block(uint64_t *A, size_t stride,
+                                     const void *buf, size_t len, size_t rate,
+                                     uint8_t ds, bool store)
+{
+	const uint8_t *p = buf;
+	size_t i = 0;
+	uint64_t x;
+
+	for (; i < len / 8; i++) {
+		x = load64le(p + 8 * i);
+		A[stride * i] = store ? x : A[stride * i] ^ x;
+	}
+
+	/* See keccak_pad() for a description of the padding. */
+	x = (uint64_t)ds << 8 * (len % 8);
+	for (size_t k = len % 8; k--; )
+		x |= (uint64_t)p[8 * i + k] << 8 * k;
+
+	A[stride * i] = store ? x : A[stride * i] ^ x;
+
+	if (store) {
+		for (i++; i < 25; i++)
+			A[stride * i] = 0;
+	}
+
+	A[stride * (rate / 8 - 1)] ^= 0x8000000000000000ULL;
+	KECCAK_STAT(finals, 1);
+}
+
+/*
+ * keccak_rc - KECCAK-f[1600] round constants.
+ */
+KECCAK_HIDDEN extern const uint64_t keccak_rc[24];
+
+/**
+ * keccakp_1600 - KECCAK-p[1600, nr] permutation function.
+ *
+ * @A:  Keccak internal state.
+ * @nr: Number of rounds, at most 24. These are the last @nr rounds of
+ *      KECCAK-f[1600], which is KECCAK-p[1600, 24].
+ *
+ * @return: None.
+ */
+KECCAK_HIDDEN void keccakp_1600(uint64_t A[25], size_t nr);
+
+/**
+ * keccakp_1600_xn - Apply KECCAK-p[1600, nr] to @n interleaved states, one at
+ *                   a time.
+ *
+ * @A:  Interleaved Keccak internal states. Lane i of state j is at A[n*i + j].
+ * @n:  Number of interleaved states.
+ * @nr: Number of rounds, as keccakp_1600().
+ *
+ * @return: None.
+ *
+ * This is the portable fallback for the multi-buffer functions.
+ */
+KECCAK_HIDDEN void keccakp_1600_xn(uint64_t *A, size_t n, size_t nr);
+
+/**
+ * keccak_absorb - Absorb whole blocks of input into a Keccak state.
+ *
+ * @A:    Keccak internal state.
+ * @buf:  Pointer to input data. There are no alignment requirements.
+ * @len:  Length, in bytes, of the input data.
+ * @rate: Padding rate in bytes.
+ * @nr:   Number of rounds, as keccakp_1600().
+ *
+ * @return: Number of bytes absorbed, the largest multiple of @rate not
+ *          greater than @len.
+ *
+ * The state is permuted with the selected kernel after every block.
+ */
+KECCAK_HIDDEN size_t keccak_absorb(uint64_t A[25], const void *buf, size_t len,
+                                   size_t rate, size_t nr);
+
+/**
+ * keccak_absorb_generic - Absorb whole blocks with the generic permutation.
+ *
+ * As keccak_absorb(), but the state is always permuted with keccakp_1600(),
+ * inlined into a loop specialised for each of the standard rates.
+ */
+KECCAK_HIDDEN size_t keccak_absorb_generic(uint64_t A[25], const void *buf,
+                                           size_t len, size_t rate, size_t nr);
+
+/**
+ * keccak_pad - Pad the final block of input and apply the permutation.
+ *
+ * @ctx: Pointer to an initialised SHA-3 context structure.
+ * @ds:  Domain separation suffix bits, followed by the first bit of padding.
+ *
+ * @return: None.
+ *
+ * On return, @ctx->index is zero and the first block of output is available
+ * in the state.
+ */
+KECCAK_HIDDEN void keccak_pad(struct sha3_ctx *ctx, uint8_t ds);
+
+/**
+ * keccak_hash_many - Hash many independent messages with the same sponge
+ *                    parameters.
+ *
+ * @rate: Padding rate in bytes.
+ * @ds:   Domain separation byte, as keccak_pad().
+ * @nr:   Number of rounds, as keccakp_1600().
+ * @size: Output size in bytes. At most @rate.
+ * @bufs: Array of @n pointers to input data.
+ * @lens: Array of @n input lengths in bytes.
+ * @n:    Number of messages.
+ * @out:  Output buffer of at least @n * @size bytes.
+ *
+ * @return: None.
+ *
+ * This is sha3_hash_many() for any sponge function with a single block of
+ * output.
+ */
+KECCAK_HIDDEN void keccak_hash_many(size_t rate, uint8_t ds, size_t nr,
+                                    size_t size, const void *const *bufs,
+                                    const size_t *lens, size_t n, void *out);
+
+/**
+ * keccak_hash_many_from - Hash many messages that share a prefix and suffix.
+ *
+ * @mid:  Pointer to a context that the prefix has been absorbed into. Its
+ *        rate, domain separation byte, and number of rounds are used for
+ *        every message.
+ * @sfx:  Pointer to a suffix absorbed after every message, or NULL if @slen
+ *        is zero.
+ * @slen: Length, in bytes, of the suffix. At most @mid->rate.
+ * @size: Output size in bytes. At most @mid->rate.
+ * @bufs: Array of @n pointers to input data.
+ * @lens: Array of @n input lengths in bytes.
+ * @n:    Number of messages.
+ * @out:  Output buffer of at least @n * @size bytes.
+ *
+ * @return: None.
+ *
+ * As keccak_hash_many(), but each message is hashed as if absorbed into a
+ * copy of @mid followed by the suffix.
+ */
+KECCAK_HIDDEN void keccak_hash_many_from(const struct sha3_ctx *mid,
+                                         const void *sfx, size_t slen,
+                                         size_t size, const void *const *bufs,
+                                         const size_t *lens, size_t n,
+                                         void *out);
+
+/**
+ * struct keccak_impl - A set of KECCAK-p[1600, nr] kernels.
+ *
+ * @name:     Name of the kernel set, as accepted by the SHA3_KERNEL
+ *            environment variable.
+ * @width:    Number of states the hardware permutes at once. Callers with
+ *            independent states to permute use this to decide whether the
+ *            multi-buffer permutations are worth interleaving for.
+ * @p1600:    Single-state permutation.
+ * @p1600_x4: Four-way permutation of interleaved states.
+ * @p1600_x8: Eight-way permutation of interleaved states.
+ * @absorb:   Block absorb loop, as keccak_absorb().
+ *
+ * Every function takes the number of rounds as its last argument.
+ */
+struct keccak_impl {
+	const char *name;
+	size_t width;
+	void (*p1600)(uint64_t A[25], size_t nr);
+	void (*p1600_x4)(uint64_t A[100], size_t nr);
+	void (*p1600_x8)(uint64_t A[200], size_t nr);
+	size_t (*absorb)(uint64_t A[25], const void *buf, size_t len,
+	                 size_t rate, size_t nr);
+};
+
+/*
+ * keccak_impl - The kernel set selected for the running CPU.
+ *
+ * This initially points to the best kernels for the target baseline and is
+ * updated from a constructor once the CPU has been inspected, see dispatch.c.
+ */
+KECCAK_HIDDEN extern const struct keccak_impl *keccak_impl;
+
+/*
+ * keccak_kernels - The selected kernel set itself.
+ *
+ * This is the set that keccak_impl points to, except with SHA3_STATS, where
+ * keccak_impl points to a copy that counts permutations and this to the kernels
+ * it wraps. Kernels that permute between blocks, such as keccak_absorb(), use
+ * this so that their permutations are only counted once, by their caller.
+ */
+KECCAK_HIDDEN extern const struct keccak_impl *keccak_kernels;
+
+/**
+ * keccak_select - Switch to a named kernel set.
+ *
+ * @name: Kernel set name, as accepted by the SHA3_KERNEL environment
+ *        variable.
+ *
+ * @return: True if the kernel set exists and the CPU supports it, in which
+ *          case it's now selected, or false otherwise.
+ *
+ * This is for the benchmark, which compares every kernel set in one process.
+ * It must not be called while any other thread is hashing.
+ */
+KECCAK_HIDDEN bool keccak_select(const char *name);
+
+/**
+ * keccakp_1600_lc - KECCAK-p[1600, nr] permutation using lane complementing.
+ *
+ * As keccakp_1600(), but with six lanes complemented while the state is
+ * permuted, which removes most of the NOTs from χ.
+ */
+KECCAK_HIDDEN void keccakp_1600_lc(uint64_t A[25], size_t nr);
+
+/**
+ * keccakp_1600_xn_lc - Apply keccakp_1600_lc() to @n interleaved states.
+ *
+ * As keccakp_1600_xn().
+ */
+KECCAK_HIDDEN void keccakp_1600_xn_lc(uint64_t *A, size_t n, size_t nr);
+
+/**
+ * keccak_absorb_lc - Absorb whole blocks using lane complementing.
+ *
+ * As keccak_absorb(), but the state is kept in complemented form between
+ * blocks.
+ */
+KECCAK_HIDDEN size_t keccak_absorb_lc(uint64_t A[25], const void *buf,
+                                      size_t len, size_t rate, size_t nr);
+
+/**
+ * keccakp_1600_32 - KECCAK-p[1600, nr] permutation using 32-bit operations.
+ *
+ * As keccakp_1600(), but the state is permuted in bit-interleaved form, which
+ * suits cores without 64-bit registers.
+ */
+KECCAK_HIDDEN void keccakp_1600_32(uint64_t A[25], size_t nr);
+
+/**
+ * keccakp_1600_xn_32 - Apply keccakp_1600_32() to @n interleaved states.
+ *
+ * As keccakp_1600_xn().
+ */
+KECCAK_HIDDEN void keccakp_1600_xn_32(uint64_t *A, size_t n, size_t nr);
+
+/**
+ * keccak_absorb_32 - Absorb whole blocks using 32-bit operations.
+ *
+ * As keccak_absorb(), but the state is kept in bit-interleaved form between
+ * blocks, with the input converted a lane at a time.
+ */
+KECCAK_HIDDEN size_t keccak_absorb_32(uint64_t A[25], const void *buf,
+                                      size_t len, size_t rate, size_t nr);
+
+#if defined(KECCAK_HAVE_X86)
+/**
+ * keccakp_1600_x4_avx2 - Four-way KECCAK-p[1600, nr] permutation using AVX2.
+ *
+ * @A:  The first of at least four interleaved Keccak internal states.
+ * @n:  Total number of interleaved states, as keccakp_1600_xn(). Only the
+ *      states at @A[0] to @A[3] are permuted.
+ * @nr: Number of rounds, as keccakp_1600().
+ *
+ * @return: None.
+ *
+ * Callers must ensure the CPU supports AVX2.
+ */
+KECCAK_HIDDEN void keccakp_1600_x4_avx2(uint64_t *A, size_t n, size_t nr);
+
+/**
+ * keccakp_1600_avx512 - KECCAK-p[1600, nr] permutation using AVX-512F.
+ *
+ * @A:  Keccak internal state.
+ * @nr: Number of rounds, as keccakp_1600().
+ *
+ * @return: None.
+ *
+ * Callers must ensure the CPU supports AVX-512F.
+ */
+KECCAK_HIDDEN void keccakp_1600_avx512(uint64_t A[25], size_t nr);
+
+/**
+ * keccak_absorb_avx512 - Absorb whole blocks of input using AVX-512F.
+ *
+ * As keccak_absorb(), but the state is kept in registers between blocks.
+ *
+ * Callers must ensure the CPU supports AVX-512F.
+ */
+KECCAK_HIDDEN size_t keccak_absorb_avx512(uint64_t A[25], const void *buf,
+                                          size_t len, size_t rate, size_t nr);
+
+/**
+ * keccakp_1600_x8_avx512 - Eight-way KECCAK-p[1600, nr] permutation using
+ *                          AVX-512F.
+ *
+ * @A:  Eight interleaved Keccak internal states, as keccakp_1600_xn() with
+ *      n = 8.
+ * @nr: Number of rounds, as keccakp_1600().
+ *
+ * @return: None.
+ *
+ * Callers must ensure the CPU supports AVX-512F.
+ */
+KECCAK_HIDDEN void keccakp_1600_x8_avx512(uint64_t A[200], size_t nr);
+#endif
+
+#if defined(KECCAK_HAVE_ARM64)
+/**
+ * keccakp_1600_arm_sha3 - KECCAK-p[1600, nr] permutation using the ARMv8.2-A
+ *                         SHA3 extension.
+ *
+ * @A:  Keccak internal state.
+ * @nr: Number of rounds, as keccakp_1600().
+ *
+ * @return: None.
+ *
+ * Callers must ensure the CPU supports the SHA3 extension.
+ */
+KECCAK_HIDDEN void keccakp_1600_arm_sha3(uint64_t A[25], size_t nr);
+
+/**
+ * keccakp_1600_x2_arm_sha3 - Two-way KECCAK-p[1600, nr] permutation using the
+ *                            ARMv8.2-A SHA3 extension.
+ *
+ * @A:  The first of at least two interleaved Keccak internal states.
+ * @n:  Total number of interleaved states, as keccakp_1600_xn(). Only the
+ *      states at @A[0] and @A[1] are permuted, so wider contexts are handled
+ *      by calling this once per pair.
+ * @nr: Number of rounds, as keccakp_1600().
+ *
+ * @return: None.
+ *
+ * Callers must ensure the CPU supports the SHA3 extension.
+ */
+KECCAK_HIDDEN void keccakp_1600_x2_arm_sha3(uint64_t *A, size_t n, size_t nr);
+#endif
+
+#endif /* KECCAK_H */
@@ -0,0 +1,256 @@
+/* SPDX-License-Identifier: 0BSD
+ *
+ * Copyright © 2022 Alex Minghella <a@minghella.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Merkle trees over fixed-size chunks.
+ *
+ * The leaves are the SHA3-256 digests of the chunks and each node is the
+ * SHA3-256 digest of its two children, with a prefix byte to separate the
+ * two, as in RFC 6962: 0x00 before a chunk and 0x01 before a pair of child
+ * digests. A node without a sibling, at the end of a level with an odd number
+ * of nodes, is carried up to the next level unchanged.
+ *
+ * Every node digest is kept, so after a chunk changes only its leaf and the
+ * leaf's ancestors need to be hashed again. Both the chunks and the 64-byte
+ * pairs of children are hashed a level at a time with sha3_hash_many_from(),
+ * starting from a midstate that has already absorbed the prefix byte, so
+ * neither is ever copied.
+ */
+
+#include "sha3.h"
+#include "keccak.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Nodes are hashed in batches of MERKLE_BATCH, and spread over the worker pool
+ * in tasks of MERKLE_TASK.
+ */
+#define MERKLE_BATCH 64
+#define MERKLE_TASK  256
+
+/**
+ * struct level_job - A set of nodes on one level to hash.
+ *
+ * @t:   Pointer to the tree.
+ * @lvl: Level of the nodes. Level 0 holds the leaves.
+ * @idx: Array of @n node indices within the level, or NULL for nodes 0 to
+ *       @n - 1.
+ * @n:   Number of nodes.
+ */
+struct level_job {
+	struct merkle_tree *t;
+	size_t lvl;
+	const size_t *idx;
+	size_t n;
+};
+
+static inline size_t level_size(const struct merkle_tree *t, size_t lvl)
+{
+	return t->level[lvl + 1] - t->level[lvl];
+}
+
+static inline uint8_t *node(const struct merkle_tree *t, size_t lvl, size_t i)
+{
+	return t->nodes + (t->level[lvl] + i) * SHA3_256_SIZE;
+}
+
+/**
+ * hash_group - Hash up to MERKLE_BATCH nodes of a job.
+ *
+ * @j:     Pointer to the job.
+ * @first: Position in the job of the first node.
+ * @n:     Number of nodes.
+ *
+ * @return: None.
+ */
+static void hash_group(const struct level_job *j, size_t first, size_t n)
+{
+	const struct merkle_tree *t = j->t;
+	const void *bufs[MERKLE_BATCH];
+	size_t lens[MERKLE_BATCH];
+	size_t dst[MERKLE_BATCH];
+	uint8_t out[MERKLE_BATCH * SHA3_256_SIZE];
+	size_t m = 0;
+
+	for (size_t k = first; k < first + n; k++) {
+		size_t i = j->idx ? j->idx[k] : k;
+
+		if (!j->lvl) {
+			size_t off = i * t->chunk;
+			bufs[m] = t->data + off;
+			lens[m] = t->len - off < t->chunk ? t->len - off
+			                                  : t->chunk;
+		} else if (2 * i + 1 == level_size(t, j->lvl - 1)) {
+			memcpy(node(t, j->lvl, i), node(t, j->lvl - 1, 2 * i),
+			       SHA3_256_SIZE);
+			continue;
+		} else {
+			bufs[m] = node(t, j->lvl - 1, 2 * i);
+			lens[m] = 2 * SHA3_256_SIZE;
+		}
+
+		dst[m++] = i;
+	}
+
+	if (m)
+		sha3_hash_many_from(j->lvl ? &t->node : &t->leaf, bufs, lens, m,
+		                    out);
+
+	for (size_t k = 0; k < m; k++)
+		memcpy(node(t, j->lvl, dst[k]), out + k * SHA3_256_SIZE,
+		       SHA3_256_SIZE);
+}
+
+static void hash_task(void *arg, size_t i)
+{
+	const struct level_job *j = arg;
+	size_t end = (i + 1) * MERKLE_TASK < j->n ? (i + 1) * MERKLE_TASK
+	                                          : j->n;
+
+	for (size_t k = i * MERKLE_TASK; k < end; k += MERKLE_BATCH)
+		hash_group(j, k, end - k < MERKLE_BATCH ? end - k
+		                                        : MERKLE_BATCH);
+}
+
+static void hash_level(struct merkle_tree *t, size_t lvl, const size_t *idx,
+                       size_t n)
+{
+	struct level_job j = { t, lvl, idx, n };
+
+	if (n > MERKLE_TASK && t->pool)
+		sha3_pool_run(t->pool, hash_task, &j,
+		              (n + MERKLE_TASK - 1) / MERKLE_TASK);
+	else
+		for (size_t k = 0; k < n; k += MERKLE_BATCH)
+			hash_group(&j, k, n - k < MERKLE_BATCH ? n - k
+			                                       : MERKLE_BATCH);
+}
+
+int merkle_init(struct merkle_tree *t, const void *data, size_t len,
+                size_t chunk, struct sha3_pool *pool)
+{
+	size_t nodes = 0;
+
+	memset(t, 0, sizeof(*t));
+	t->data = data;
+	t->len = len;
+	t->chunk = chunk;
+	t->pool = pool;
+	t->leaves = len ? (len - 1) / chunk + 1 : 1;
+
+	t->levels = 1;
+	for (size_t n = t->leaves; n > 1; n = (n + 1) / 2)
+		t->levels++;
+
+	t->level = malloc((t->levels + 1) * sizeof(*t->level));
+	t->dirty = malloc(t->leaves * sizeof(*t->dirty));
+	t->mark = calloc(t->leaves, 1);
+	if (!t->level || !t->dirty || !t->mark)
+		goto fail;
+
+	for (size_t l = 0, n = t->leaves; l < t->levels; l++, n = (n + 1) / 2) {
+		t->level[l] = nodes;
+		nodes += n;
+	}
+	t->level[t->levels] = nodes;
+
+	t->nodes = malloc(nodes * SHA3_256_SIZE);
+	if (!t->nodes)
+		goto fail;
+
+	sha3_init(&t->leaf, SHA3_256);
+	sha3_update(&t->leaf, "\x00", 1);
+	sha3_init(&t->node, SHA3_256);
+	sha3_update(&t->node, "\x01", 1);
+
+	for (size_t l = 0; l < t->levels; l++)
+		hash_level(t, l, NULL, level_size(t, l));
+
+	return 0;
+
+fail:
+	merkle_free(t);
+	errno = ENOMEM;
+	return -1;
+}
+
+void merkle_dirty(struct merkle_tree *t, size_t off, size_t len)
+{
+	if (!len || off >= t->len)
+		return;
+
+	size_t end = len < t->len - off ? off + len : t->len;
+
+	for (size_t i = off / t->chunk; i <= (end - 1) / t->chunk; i++) {
+		if (!t->mark[i]) {
+			t->mark[i] = 1;
+			t->dirty[t->ndirty++] = i;
+		}
+	}
+}
+
+static int cmp_index(const void *a, const void *b)
+{
+	size_t x = *(const size_t *)a, y = *(const size_t *)b;
+	return (x > y) - (x < y);
+}
+
+void merkle_root(struct merkle_tree *t, void *md)
+{
+	size_t *idx = t->dirty, n = t->ndirty;
+
+	if (n) {
+		qsort(idx, n, sizeof(*idx), cmp_index);
+
+		for (size_t k = 0; k < n; k++)
+			t->mark[idx[k]] = 0;
+
+		hash_level(t, 0, idx, n);
+
+		/*
+		 * The parents of a sorted list of nodes are sorted too, with
+		 * siblings sharing a parent next to each other, so each level's
+		 * list can be built in place from the one below.
+		 */
+		for (size_t l = 1; l < t->levels; l++) {
+			size_t m = 0;
+
+			for (size_t k = 0; k < n; k++) {
+				if (!m || idx[m - 1] != idx[k] / 2)
+					idx[m++] = idx[k] / 2;
+			}
+
+			n = m;
+			hash_level(t, l, idx, n);
+		}
+
+		t->ndirty = 0;
+	}
+
+	memcpy(md, node(t, t->levels - 1, 0), SHA3_256_SIZE);
+}
+
+void merkle_free(struct merkle_tree *t)
+{
+	free(t->level);
+	free(t->nodes);
+	free(t->dirty);
+	free(t->mark);
+	memset(t, 0, sizeof(*t));
+}
@@ -0,0 +1,174 @@
+/* SPDX-License-Identifier: 0BSD
+ *
+ * Copyright © 2022 Alex Minghella <a@minghella.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Worker pool.
+ *
+ * A pool runs one job at a time. A job is a number of independent tasks, and
+ * every thread, including the one that submitted the job, repeatedly claims
+ * the next unclaimed task until there are none left. Threads that finish their
+ * tasks early simply take more of them, so uneven tasks balance out without
+ * any per-thread queues.
+ */
+
+#include "sha3.h"
+#include "keccak.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+struct sha3_pool {
+	pthread_mutex_t run;
+	pthread_mutex_t lock;
+	pthread_cond_t work;
+	pthread_cond_t done;
+
+	size_t nthreads;
+	pthread_t *threads;
+
+	void (*fn)(void *arg, size_t i);
+	void *arg;
+	size_t count;
+	atomic_size_t next;
+
+	size_t active;
+	unsigned long generation;
+	bool stop;
+};
+
+static void pool_work(struct sha3_pool *pool)
+{
+	size_t i;
+	while ((i = atomic_fetch_add(&pool->next, 1)) < pool->count)
+		pool->fn(pool->arg, i);
+}
+
+static void *pool_thread(void *arg)
+{
+	struct sha3_pool *pool = arg;
+	unsigned long seen = 0;
+
+	pthread_mutex_lock(&pool->lock);
+	for (;;) {
+		while (pool->generation == seen && !pool->stop)
+			pthread_cond_wait(&pool->work, &pool->lock);
+
+		if (pool->stop)
+			break;
+
+		seen = pool->generation;
+		pthread_mutex_unlock(&pool->lock);
+
+		pool_work(pool);
+
+		pthread_mutex_lock(&pool->lock);
+		if (!--pool->active)
+			pthread_cond_signal(&pool->done);
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	return NULL;
+}
+
+struct sha3_pool *sha3_pool_create(size_t nthreads)
+{
+	if (!nthreads) {
+		long n = sysconf(_SC_NPROCESSORS_ONLN);
+		nthreads = n > 0 ? n : 1;
+	}
+
+	struct sha3_pool *pool = calloc(1, sizeof(*pool));
+	if (!pool)
+		return NULL;
+
+	pool->threads = calloc(nthreads, sizeof(*pool->threads));
+	if (!pool->threads) {
+		free(pool);
+		return NULL;
+	}
+
+	pthread_mutex_init(&pool->run, NULL);
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->work, NULL);
+	pthread_cond_init(&pool->done, NULL);
+	atomic_init(&pool->next, 0);
+
+	/* The calling thread counts as one of the threads. */
+	for (; pool->nthreads < nthreads - 1; pool->nthreads++) {
+		if (pthread_create(&pool->threads[pool->nthreads], NULL,
+		                   pool_thread, pool)) {
+			sha3_pool_destroy(pool);
+			return NULL;
+		}
+	}
+
+	return pool;
+}
+
+void sha3_pool_destroy(struct sha3_pool *pool)
+{
+	if (!pool)
+		return;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = true;
+	pthread_cond_broadcast(&pool->work);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (size_t i = 0; i < pool->nthreads; i++)
+		pthread_join(pool->threads[i], NULL);
+
+	pthread_cond_destroy(&pool->done);
+	pthread_cond_destroy(&pool->work);
+	pthread_mutex_destroy(&pool->lock);
+	pthread_mutex_destroy(&pool->run);
+	free(pool->threads);
+	free(pool);
+}
+
+void sha3_pool_run(struct sha3_pool *pool, void (*fn)(void *arg, size_t i),
+                   void *arg, size_t count)
+{
+	if (!pool || !pool->nthreads || count < 2) {
+		for (size_t i = 0; i < count; i++)
+			fn(arg, i);
+		return;
+	}
+
+	pthread_mutex_lock(&pool->run);
+
+	pthread_mutex_lock(&pool->lock);
+	pool->fn = fn;
+	pool->arg = arg;
+	pool->count = count;
+	atomic_store(&pool->next, 0);
+	pool->active = pool->nthreads;
+	pool->generation++;
+	pthread_cond_broadcast(&pool->work);
+	pthread_mutex_unlock(&pool->lock);
+
+	pool_work(pool);
+
+	pthread_mutex_lock(&pool->lock);
+	while (pool->active)
+		pthread_cond_wait(&pool->done, &pool->lock);
+	pthread_mutex_unlock(&pool->lock);
+
+	pthread_mutex_unlock(&pool->run);
+}
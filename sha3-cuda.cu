@@ -0,0 +1,476 @@
+/* SPDX-License-Identifier: 0BSD
+ *
+ * Copyright © 2022 Alex Minghella <a@minghella.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Batch SHA-3 on CUDA devices.
+ *
+ * Each GPU thread hashes one message, with the whole state held in registers.
+ * The kernel is instantiated once per rate so that every lane index is a
+ * compile-time constant; otherwise the state would be indexed dynamically and
+ * spill to local memory.
+ *
+ * Messages are packed into a pinned staging buffer, each starting on an 8-byte
+ * boundary and zero-padded to a whole number of lanes, so that the kernel only
+ * ever makes aligned 64-bit loads and never has to mask off trailing bytes.
+ * There are two sets of staging buffers, each with its own stream. While one
+ * batch is being copied in, hashed, and copied back, the calling thread packs
+ * the next batch into the other set, so packing, transfers, and kernels all
+ * overlap.
+ *
+ * The GPU is assumed to have the same (little-endian) byte order as the host,
+ * which holds for every platform CUDA runs on.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cuda_runtime.h>
+
+#include "sha3-cuda.h"
+
+/* Threads per block. */
+#define CUDA_BLOCK 128
+
+/* Maximum number of messages in a batch. */
+#define SLOT_MSGS ((size_t)1 << 19)
+
+/* Size of each input staging buffer. */
+#define SLOT_BYTES ((size_t)32 << 20)
+
+/* Longest message that is hashed on the GPU. */
+#define CUDA_LONG ((size_t)64 << 10)
+
+__constant__ uint64_t cuda_rc[24] = {
+	0x0000000000000001, 0x0000000000008082, 0x800000000000808a,
+	0x8000000080008000, 0x000000000000808b, 0x0000000080000001,
+	0x8000000080008081, 0x8000000000008009, 0x000000000000008a,
+	0x0000000000000088, 0x0000000080008009, 0x000000008000000a,
+	0x000000008000808b, 0x800000000000008b, 0x8000000000008089,
+	0x8000000000008003, 0x8000000000008002, 0x8000000000000080,
+	0x000000000000800a, 0x800000008000000a, 0x8000000080008081,
+	0x8000000000008080, 0x0000000080000001, 0x8000000080008008
+};
+
+/*
+ * There is no 64-bit funnel shift, but nvcc turns this into a pair of 32-bit
+ * ones.
+ */
+static __device__ __forceinline__ uint64_t rotl64(uint64_t x, unsigned n)
+{
+	return (x << n) | (x >> (64 - n));
+}
+
+#define KECCAK_NAME         keccakp_1600_cuda
+#define KECCAK_ATTR         __device__
+#define KECCAK_LANE         uint64_t
+#define KECCAK_XOR(a, b)    ((a) ^ (b))
+#define KECCAK_XOR5(a, b, c, d, e) \
+	((a) ^ (b) ^ (c) ^ (d) ^ (e))
+#define KECCAK_RAX1(a, b)   ((a) ^ rotl64(b, 1))
+#define KECCAK_XAR(a, b, n) rotl64((a) ^ (b), n)
+#define KECCAK_CHI(a, b, c) ((a) ^ (~(b) & (c)))
+#define KECCAK_RC(i)        cuda_rc[i]
+#include "keccak-unroll.h"
+
+/**
+ * sha3_kernel - Hash one message per thread.
+ *
+ * @in:   Packed input. Each message starts on an 8-byte boundary and is padded
+ *        with zeros to a multiple of 8 bytes.
+ * @offs: Byte offset of each message in @in, or NULL for fixed-size records.
+ * @lens: Length of each message, or NULL for fixed-size records.
+ * @step: Byte distance between fixed-size records. Ignored if @offs is set.
+ * @rlen: Length of each fixed-size record. Ignored if @offs is set.
+ * @n:    Number of messages.
+ * @out:  Output, with the digest of message i at 32-bit word i * (@RATE's
+ *        digest size) / 4.
+ */
+template <unsigned RATE>
+static __global__ void __launch_bounds__(CUDA_BLOCK)
+sha3_kernel(const uint64_t *__restrict__ in, const uint32_t *__restrict__ offs,
+            const uint32_t *__restrict__ lens, uint32_t step, uint32_t rlen,
+            uint32_t n, uint32_t *__restrict__ out)
+{
+	constexpr unsigned W = RATE / 8;
+	constexpr unsigned MD = (200 - RATE) / 2 / 4;
+
+	uint32_t i = blockIdx.x * blockDim.x + threadIdx.x;
+	if (i >= n)
+		return;
+
+	const uint64_t *p;
+	uint32_t len;
+	if (offs) {
+		p = in + offs[i] / 8;
+		len = lens[i];
+	} else {
+		p = in + (size_t)i * step / 8;
+		len = rlen;
+	}
+
+	uint64_t A[25];
+#pragma unroll
+	for (unsigned j = 0; j < 25; j++)
+		A[j] = 0;
+
+	for (; len >= RATE; len -= RATE, p += W) {
+#pragma unroll
+		for (unsigned j = 0; j < W; j++)
+			A[j] ^= p[j];
+		keccakp_1600_cuda(A, 24);
+	}
+
+	/*
+	 * The tail is zero-padded to whole lanes, so the lanes holding it can
+	 * be absorbed as they are. The comparisons here keep every index into A
+	 * constant.
+	 */
+#pragma unroll
+	for (unsigned j = 0; j < W; j++) {
+		if (8 * j < len)
+			A[j] ^= p[j];
+		if (j == len / 8)
+			A[j] ^= (uint64_t)0x06 << 8 * (len % 8);
+	}
+	A[W - 1] ^= (uint64_t)0x80 << 56;
+	keccakp_1600_cuda(A, 24);
+
+	out += (size_t)i * MD;
+#pragma unroll
+	for (unsigned j = 0; j < MD; j++)
+		out[j] = (uint32_t)(A[j / 2] >> 32 * (j % 2));
+}
+
+/**
+ * struct slot - One set of staging buffers.
+ *
+ * @stream: Stream that the batch's copies and kernel are queued on.
+ * @h_in:   Pinned input buffer of SLOT_BYTES bytes.
+ * @h_meta: Pinned offsets followed by lengths, SLOT_MSGS of each.
+ * @h_out:  Pinned output buffer with room for SLOT_MSGS SHA3-512 digests.
+ * @d_in:   Device copy of @h_in.
+ * @d_meta: Device copy of @h_meta.
+ * @d_out:  Device copy of @h_out.
+ * @dst:    Where the digests of the batch in flight go, or NULL if the slot
+ *          is idle.
+ * @size:   Size, in bytes, of the digests of the batch in flight.
+ */
+struct slot {
+	cudaStream_t stream;
+	uint8_t *h_in;
+	uint32_t *h_meta;
+	uint8_t *h_out;
+	uint64_t *d_in;
+	uint32_t *d_meta;
+	uint32_t *d_out;
+	uint8_t *dst;
+	size_t size;
+};
+
+struct sha3_cuda {
+	int device;
+	unsigned next;
+	struct slot slot[2];
+};
+
+/* Map a CUDA runtime error to -1 with errno set. */
+static int check(cudaError_t err)
+{
+	if (err == cudaSuccess)
+		return 0;
+	errno = err == cudaErrorMemoryAllocation ? ENOMEM : EIO;
+	return -1;
+}
+
+/**
+ * slot_wait - Wait for a slot's batch, if any, and copy its digests out.
+ *
+ * @s: Pointer to a slot.
+ *
+ * @return: Zero on success, or -1 on error with errno set. The slot is idle
+ *          afterwards either way.
+ */
+static int slot_wait(struct slot *s)
+{
+	if (!s->dst)
+		return 0;
+	int ret = check(cudaStreamSynchronize(s->stream));
+	if (!ret)
+		memcpy(s->dst, s->h_out, s->size);
+	s->dst = NULL;
+	return ret;
+}
+
+/**
+ * slot_submit - Queue a packed batch on a slot.
+ *
+ * @s:    Pointer to a slot holding a packed batch.
+ * @algo: Size of the digests in bytes.
+ * @used: Number of bytes of @s->h_in in use.
+ * @n:    Number of messages in the batch.
+ * @step: Byte distance between records, or zero if @s->h_meta has been filled
+ *        in with offsets and lengths.
+ * @rlen: Length of each record, if @step is non-zero.
+ * @dst:  Where the digests should be copied once the batch is done.
+ *
+ * @return: Zero on success, or -1 on error with errno set.
+ */
+static int slot_submit(struct slot *s, enum sha3_algo algo, size_t used,
+                       size_t n, size_t step, size_t rlen, uint8_t *dst)
+{
+	const uint32_t *offs = NULL, *lens = NULL;
+	if (!step) {
+		offs = s->d_meta;
+		lens = s->d_meta + SLOT_MSGS;
+
+		if (check(cudaMemcpyAsync(s->d_meta, s->h_meta,
+		                          n * sizeof(uint32_t),
+		                          cudaMemcpyHostToDevice, s->stream)) ||
+		    check(cudaMemcpyAsync(s->d_meta + SLOT_MSGS,
+		                          s->h_meta + SLOT_MSGS,
+		                          n * sizeof(uint32_t),
+		                          cudaMemcpyHostToDevice, s->stream)))
+			return -1;
+	}
+
+	if (check(cudaMemcpyAsync(s->d_in, s->h_in, used,
+	                          cudaMemcpyHostToDevice, s->stream)))
+		return -1;
+
+	unsigned grid = (n + CUDA_BLOCK - 1) / CUDA_BLOCK;
+#define LAUNCH(rate) \
+	sha3_kernel<rate><<<grid, CUDA_BLOCK, 0, s->stream>>>( \
+		s->d_in, offs, lens, step, rlen, n, s->d_out)
+	switch (algo) {
+	case SHA3_224: LAUNCH(144); break;
+	case SHA3_256: LAUNCH(136); break;
+	case SHA3_384: LAUNCH(104); break;
+	case SHA3_512: LAUNCH(72);  break;
+	}
+#undef LAUNCH
+
+	if (check(cudaGetLastError()) ||
+	    check(cudaMemcpyAsync(s->h_out, s->d_out, n * algo,
+	                          cudaMemcpyDeviceToHost, s->stream)))
+		return -1;
+
+	s->dst = dst;
+	s->size = n * algo;
+	return 0;
+}
+
+/**
+ * next_slot - Get the next slot to pack a batch into.
+ *
+ * @gpu: Pointer to a GPU handle.
+ *
+ * @return: Pointer to an idle slot, or NULL on error with errno set.
+ *
+ * The slots are used alternately, so this waits for the batch submitted two
+ * batches ago.
+ */
+static struct slot *next_slot(struct sha3_cuda *gpu)
+{
+	struct slot *s = &gpu->slot[gpu->next++ & 1];
+	return slot_wait(s) ? NULL : s;
+}
+
+/**
+ * drain - Wait for both slots.
+ *
+ * @gpu: Pointer to a GPU handle.
+ * @ret: Result so far.
+ *
+ * @return: @ret, or -1 if it was zero and a batch failed.
+ */
+static int drain(struct sha3_cuda *gpu, int ret)
+{
+	int saved = errno;
+	for (unsigned i = 0; i < 2; i++) {
+		struct slot *s = &gpu->slot[gpu->next++ & 1];
+		if (slot_wait(s) && !ret) {
+			ret = -1;
+			saved = errno;
+		}
+	}
+	errno = saved;
+	return ret;
+}
+
+/* Hash a long message on the calling thread. */
+static void hash_cpu(enum sha3_algo algo, const void *buf, size_t len,
+                     void *md)
+{
+	struct sha3_ctx ctx;
+	sha3_init(&ctx, algo);
+	sha3_update(&ctx, buf, len);
+	sha3_final(&ctx, md);
+}
+
+int sha3_cuda_hash_many(struct sha3_cuda *gpu, enum sha3_algo algo,
+                        const void *const *bufs, const size_t *lens, size_t n,
+                        void *out)
+{
+	uint8_t *md = (uint8_t *)out;
+
+	if (check(cudaSetDevice(gpu->device)))
+		return -1;
+
+	size_t i = 0;
+	while (i < n) {
+		if (lens[i] > CUDA_LONG) {
+			hash_cpu(algo, bufs[i], lens[i], md + i * algo);
+			i++;
+			continue;
+		}
+
+		struct slot *s = next_slot(gpu);
+		if (!s)
+			return drain(gpu, -1);
+
+		/*
+		 * A batch ends at the next long message, so that each batch's
+		 * digests are contiguous in the output.
+		 */
+		size_t first = i, used = 0;
+		uint32_t *offs = s->h_meta, *sizes = s->h_meta + SLOT_MSGS;
+		for (; i < n && i - first < SLOT_MSGS; i++) {
+			size_t len = lens[i], pad = -len & 7;
+			if (len > CUDA_LONG || used + len + pad > SLOT_BYTES)
+				break;
+
+			offs[i - first] = used;
+			sizes[i - first] = len;
+			memcpy(s->h_in + used, bufs[i], len);
+			memset(s->h_in + used + len, 0, pad);
+			used += len + pad;
+		}
+
+		if (slot_submit(s, algo, used, i - first, 0, 0,
+		                md + first * algo))
+			return drain(gpu, -1);
+	}
+
+	return drain(gpu, 0);
+}
+
+int sha3_cuda_hash_records(struct sha3_cuda *gpu, enum sha3_algo algo,
+                           const void *buf, size_t len, size_t n, void *out)
+{
+	const uint8_t *in = (const uint8_t *)buf;
+	uint8_t *md = (uint8_t *)out;
+
+	if (len > CUDA_LONG) {
+		for (size_t i = 0; i < n; i++)
+			hash_cpu(algo, in + i * len, len, md + i * algo);
+		return 0;
+	}
+
+	if (check(cudaSetDevice(gpu->device)))
+		return -1;
+
+	/*
+	 * Records are repacked with an 8-byte step, unless they're already a
+	 * multiple of 8 bytes long. Zero-length records still need a non-zero
+	 * step, as a zero step tells the kernel to use the per-message table.
+	 */
+	size_t step = len ? (len + 7) & ~(size_t)7 : 8;
+	size_t per = SLOT_BYTES / step < SLOT_MSGS ? SLOT_BYTES / step : SLOT_MSGS;
+
+	for (size_t i = 0; i < n;) {
+		struct slot *s = next_slot(gpu);
+		if (!s)
+			return drain(gpu, -1);
+
+		size_t m = n - i < per ? n - i : per;
+		if (step == len) {
+			memcpy(s->h_in, in + i * len, m * len);
+		} else {
+			for (size_t j = 0; j < m; j++) {
+				memcpy(s->h_in + j * step, in + (i + j) * len,
+				       len);
+				memset(s->h_in + j * step + len, 0, step - len);
+			}
+		}
+
+		if (slot_submit(s, algo, m * step, m, step, len, md + i * algo))
+			return drain(gpu, -1);
+		i += m;
+	}
+
+	return drain(gpu, 0);
+}
+
+struct sha3_cuda *sha3_cuda_create(int device)
+{
+	struct sha3_cuda *gpu = (struct sha3_cuda *)calloc(1, sizeof(*gpu));
+	if (!gpu)
+		return NULL;
+	gpu->device = device;
+
+	if (check(cudaSetDevice(device)))
+		goto fail;
+
+	for (unsigned i = 0; i < 2; i++) {
+		struct slot *s = &gpu->slot[i];
+		size_t meta = 2 * SLOT_MSGS * sizeof(uint32_t);
+		size_t out = SLOT_MSGS * SHA3_512_SIZE;
+
+		if (check(cudaStreamCreateWithFlags(&s->stream,
+		                                    cudaStreamNonBlocking)) ||
+		    check(cudaHostAlloc((void **)&s->h_in, SLOT_BYTES,
+		                        cudaHostAllocDefault)) ||
+		    check(cudaHostAlloc((void **)&s->h_meta, meta,
+		                        cudaHostAllocDefault)) ||
+		    check(cudaHostAlloc((void **)&s->h_out, out,
+		                        cudaHostAllocDefault)) ||
+		    check(cudaMalloc((void **)&s->d_in, SLOT_BYTES)) ||
+		    check(cudaMalloc((void **)&s->d_meta, meta)) ||
+		    check(cudaMalloc((void **)&s->d_out, out)))
+			goto fail;
+	}
+
+	return gpu;
+
+fail:
+	sha3_cuda_destroy(gpu);
+	return NULL;
+}
+
+void sha3_cuda_destroy(struct sha3_cuda *gpu)
+{
+	if (!gpu)
+		return;
+
+	int saved = errno;
+	cudaSetDevice(gpu->device);
+	for (unsigned i = 0; i < 2; i++) {
+		struct slot *s = &gpu->slot[i];
+		if (s->stream)
+			cudaStreamSynchronize(s->stream);
+		cudaFreeHost(s->h_in);
+		cudaFreeHost(s->h_meta);
+		cudaFreeHost(s->h_out);
+		cudaFree(s->d_in);
+		cudaFree(s->d_meta);
+		cudaFree(s->d_out);
+		if (s->stream)
+			cudaStreamDestroy(s->stream);
+	}
+	free(gpu);
+	errno = saved;
+}
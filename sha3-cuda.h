@@ -0,0 +1,110 @@
+/* SPDX-License-Identifier: 0BSD
+ *
+ * Copyright © 2022 Alex Minghella <a@minghella.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SHA3_CUDA_H
+#define SHA3_CUDA_H 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sha3.h"
+
+/*
+ * Optional CUDA backend for hashing very large batches of short messages.
+ *
+ * This is built separately with `make cuda`, into libsha3-cuda.a, and is linked
+ * alongside libsha3.a and the CUDA runtime. Nothing in libsha3 itself depends
+ * on it.
+ */
+
+/**
+ * struct sha3_cuda - Opaque handle to a GPU and its staging buffers.
+ */
+struct sha3_cuda;
+
+/**
+ * sha3_cuda_create - Set up a GPU for batch hashing.
+ *
+ * @device: CUDA device ordinal.
+ *
+ * @return: Pointer to the new handle, or NULL on error with errno set.
+ *
+ * This allocates two sets of staging buffers, about 136 MiB of pinned host
+ * memory and as much device memory, which are reused by every call. A handle
+ * must not be used by more than one thread at a time.
+ */
+struct sha3_cuda *sha3_cuda_create(int device);
+
+/**
+ * sha3_cuda_destroy - Release a GPU handle.
+ *
+ * @gpu: Pointer to a handle returned by sha3_cuda_create(), or NULL.
+ *
+ * @return: None.
+ */
+void sha3_cuda_destroy(struct sha3_cuda *gpu);
+
+/**
+ * sha3_cuda_hash_many - Compute the SHA-3 digests of many messages on a GPU.
+ *
+ * @gpu:  Pointer to a GPU handle.
+ * @algo: Size of the final digests in bytes.
+ * @bufs: Array of @n pointers to input data, as sha3_hash_many().
+ * @lens: Array of @n input lengths in bytes.
+ * @n:    Number of messages.
+ * @out:  Pointer to the output buffer, as sha3_hash_many().
+ *
+ * @return: Zero on success, or -1 on error with errno set. The contents of
+ *          @out are unspecified after an error.
+ *
+ * The output is the same as that of sha3_hash_many(). Messages are copied into
+ * pinned buffers and hashed one per GPU thread, while the next batch is being
+ * copied. Messages longer than 64 KiB are hashed on the calling thread instead,
+ * since a whole warp would otherwise wait on the one thread absorbing them.
+ */
+int sha3_cuda_hash_many(struct sha3_cuda *gpu, enum sha3_algo algo,
+                        const void *const *bufs, const size_t *lens, size_t n,
+                        void *out);
+
+/**
+ * sha3_cuda_hash_records - Compute the SHA-3 digests of fixed-size records on a
+ *                          GPU.
+ *
+ * @gpu:  Pointer to a GPU handle.
+ * @algo: Size of the final digests in bytes.
+ * @buf:  Pointer to @n records of @len bytes each, one after another.
+ * @len:  Length, in bytes, of each record.
+ * @n:    Number of records.
+ * @out:  Pointer to the output buffer, as sha3_hash_many().
+ *
+ * @return: Zero on success, or -1 on error with errno set.
+ *
+ * As sha3_cuda_hash_many() with bufs[i] = @buf + i * @len, but without the
+ * per-message offsets and lengths. When @len is a multiple of 8, each batch is
+ * copied to the GPU with a single memcpy().
+ */
+int sha3_cuda_hash_records(struct sha3_cuda *gpu, enum sha3_algo algo,
+                           const void *buf, size_t len, size_t n, void *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SHA3_CUDA_H */
@@ -0,0 +1,730 @@
+/* SPDX-License-Identifier: 0BSD
+ *
+ * Copyright © 2022 Alex Minghella <a@minghella.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Hashing from file descriptors.
+ *
+ * Large regular files are hashed through a pipeline that keeps several
+ * page-aligned buffers in flight, so the device is reading the next ones while
+ * the calling thread hashes the current one. On Linux the reads are queued
+ * with io_uring, at explicit offsets, so they also run concurrently with each
+ * other. Where io_uring isn't available, because the kernel is too old or it's
+ * been disabled, large regular files are mapped a window at a time and hashed
+ * straight out of the page cache, with the kernel asked to read the next
+ * window ahead.
+ *
+ * Pipes, sockets, and anything else that can't be read at an offset go through
+ * the same ring of buffers, filled in order by a reader thread. Small regular
+ * files are simply read into one buffer, since the pipeline costs more to set
+ * up than it saves.
+ *
+ * The windows and buffers are all whole numbers of blocks, so sha3_update()
+ * absorbs every one of them with the block absorb loop rather than a byte at a
+ * time.
+ */
+
+#if defined(__linux__)
+	#define _DEFAULT_SOURCE 1
+#endif
+
+#include "sha3.h"
+#include "keccak.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(__GNUC__) && defined(__has_include)
+	#if __has_include(<linux/io_uring.h>)
+		#include <linux/io_uring.h>
+		#include <sys/syscall.h>
+		#include <sys/uio.h>
+	#endif
+
+	#if defined(IORING_OFF_SQES) && defined(__NR_io_uring_setup)
+		#define FD_HAVE_IO_URING 1
+	#endif
+#endif
+
+/*
+ * Regular files smaller than this are read into a single buffer. Setting up
+ * the pipeline or a mapping costs more than copying a few hundred kilobytes.
+ */
+#define FD_PIPE_MIN (1 << 20)
+
+/*
+ * Mapping windows are 2^16 blocks, between 4.5 MiB and 10.5 MiB, and read
+ * buffers are 2^10 blocks. Since the rate is a multiple of 8, a window is also
+ * a whole number of pages for any page size up to 512 KiB.
+ */
+#define FD_WINDOW_SHIFT 16
+#define FD_BUFFER_SHIFT 10
+
+/*
+ * The pipeline has FD_PIPE_DEPTH buffers of 2^12 blocks, between 288 KiB and
+ * 672 KiB each. That's enough reads in flight to keep an NVMe drive busy
+ * without tying up more than a few megabytes.
+ */
+#define FD_PIPE_DEPTH 4
+#define FD_PIPE_SHIFT 12
+
+/**
+ * alloc_buffers - Allocate page-aligned buffers.
+ *
+ * @size: Total size in bytes.
+ *
+ * @return: Pointer to the buffers, to be freed with free(), or NULL on error
+ *          with errno set.
+ */
+static void *alloc_buffers(size_t size)
+{
+	long page = sysconf(_SC_PAGESIZE);
+	void *buf;
+	int err;
+
+	err = posix_memalign(&buf, page > 0 ? (size_t)page : 4096, size);
+	if (err) {
+		errno = err;
+		return NULL;
+	}
+
+	return buf;
+}
+
+/**
+ * fill - Read until a buffer is full or the end of file is reached.
+ *
+ * @fd:   File descriptor open for reading.
+ * @buf:  Pointer to the buffer.
+ * @size: Size of the buffer in bytes.
+ *
+ * @return: Number of bytes read, which is less than @size only at end of file,
+ *          or -1 on error with errno set.
+ *
+ * Passing on a short read from a pipe or socket as it is would leave the
+ * context part of the way through a block, and the next buffer would then be
+ * absorbed a byte at a time until the block was finished.
+ */
+static ssize_t fill(int fd, void *buf, size_t size)
+{
+	size_t n = 0;
+
+	while (n < size) {
+		ssize_t r = read(fd, (uint8_t *)buf + n, size - n);
+		if (r > 0)
+			n += r;
+		else if (!r)
+			break;
+		else if (errno != EINTR)
+			return -1;
+	}
+
+	return n;
+}
+
+/**
+ * update_read - Absorb the rest of a file descriptor with read().
+ *
+ * @ctx: Pointer to an initialised SHA-3 context structure.
+ * @fd:  File descriptor open for reading.
+ *
+ * @return: Zero on success, or -1 on error with errno set.
+ */
+static int update_read(struct sha3_ctx *ctx, int fd)
+{
+	size_t size = (size_t)ctx->rate << FD_BUFFER_SHIFT;
+	void *buf = alloc_buffers(size);
+	ssize_t n;
+	int err;
+
+	if (!buf)
+		return -1;
+
+	do {
+		n = fill(fd, buf, size);
+		if (n > 0)
+			sha3_update(ctx, buf, n);
+	} while (n == (ssize_t)size);
+
+	err = errno;
+	free(buf);
+	errno = err;
+	return n < 0 ? -1 : 0;
+}
+
+/**
+ * struct reader - Ring of buffers filled in order by a reader thread.
+ *
+ * @lock:   Protects everything below.
+ * @filled: Signalled when the reader has filled a buffer.
+ * @freed:  Signalled when the hashing thread has emptied a buffer.
+ * @fd:     File descriptor being read.
+ * @buf:    FD_PIPE_DEPTH buffers of @size bytes each.
+ * @size:   Size of each buffer in bytes.
+ * @len:    Number of bytes in each filled buffer.
+ * @head:   Number of buffers filled so far. Buffer i is filled for the
+ *          (i mod FD_PIPE_DEPTH)th time.
+ * @tail:   Number of buffers emptied so far.
+ * @done:   Set once the reader has filled its last buffer, which is the first
+ *          one with fewer than @size bytes.
+ * @err:    Error number of the read that stopped the reader, or zero.
+ */
+struct reader {
+	pthread_mutex_t lock;
+	pthread_cond_t filled;
+	pthread_cond_t freed;
+
+	int fd;
+	uint8_t *buf;
+	size_t size;
+	size_t len[FD_PIPE_DEPTH];
+	size_t head;
+	size_t tail;
+	bool done;
+	int err;
+};
+
+static void *reader_main(void *arg)
+{
+	struct reader *r = arg;
+
+	pthread_mutex_lock(&r->lock);
+	while (!r->done) {
+		size_t k = r->head % FD_PIPE_DEPTH;
+		ssize_t n;
+
+		while (r->head - r->tail == FD_PIPE_DEPTH)
+			pthread_cond_wait(&r->freed, &r->lock);
+
+		pthread_mutex_unlock(&r->lock);
+		n = fill(r->fd, r->buf + k * r->size, r->size);
+		pthread_mutex_lock(&r->lock);
+
+		if (n < 0) {
+			r->err = errno;
+			n = 0;
+		}
+
+		r->len[k] = n;
+		r->head++;
+		r->done = (size_t)n < r->size;
+		pthread_cond_signal(&r->filled);
+	}
+	pthread_mutex_unlock(&r->lock);
+
+	return NULL;
+}
+
+/**
+ * update_reader - Absorb the rest of a file descriptor through a reader
+ *                 thread.
+ *
+ * @ctx: Pointer to an initialised SHA-3 context structure.
+ * @fd:  File descriptor open for reading.
+ *
+ * @return: Zero on success, -1 on error with errno set, or 1 if the reader
+ *          thread couldn't be started, in which case nothing has been read.
+ */
+static int update_reader(struct sha3_ctx *ctx, int fd)
+{
+	struct reader r = {
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+		.filled = PTHREAD_COND_INITIALIZER,
+		.freed = PTHREAD_COND_INITIALIZER,
+		.fd = fd,
+		.size = (size_t)ctx->rate << FD_PIPE_SHIFT,
+	};
+	pthread_t thread;
+	bool last = false;
+
+	r.buf = alloc_buffers(FD_PIPE_DEPTH * r.size);
+	if (!r.buf)
+		return 1;
+
+	if (pthread_create(&thread, NULL, reader_main, &r)) {
+		free(r.buf);
+		return 1;
+	}
+
+	pthread_mutex_lock(&r.lock);
+	while (!last) {
+		size_t k = r.tail % FD_PIPE_DEPTH;
+
+		while (r.head == r.tail)
+			pthread_cond_wait(&r.filled, &r.lock);
+
+		last = r.done && r.head - r.tail == 1;
+		pthread_mutex_unlock(&r.lock);
+		sha3_update(ctx, r.buf + k * r.size, r.len[k]);
+		pthread_mutex_lock(&r.lock);
+
+		r.tail++;
+		pthread_cond_signal(&r.freed);
+	}
+	pthread_mutex_unlock(&r.lock);
+
+	pthread_join(thread, NULL);
+	pthread_mutex_destroy(&r.lock);
+	pthread_cond_destroy(&r.filled);
+	pthread_cond_destroy(&r.freed);
+	free(r.buf);
+
+	if (r.err) {
+		errno = r.err;
+		return -1;
+	}
+
+	return 0;
+}
+
+#if defined(FD_HAVE_IO_URING)
+/**
+ * struct uring - An io_uring instance, driven with raw system calls.
+ *
+ * @fd:      io_uring file descriptor.
+ * @sq:      Mapping of the submission queue ring.
+ * @cq:      Mapping of the completion queue ring, which may be @sq.
+ * @sqes:    Mapping of the submission queue entries.
+ * @sq_len:  Length of the @sq mapping.
+ * @cq_len:  Length of the @cq mapping.
+ * @p:       Parameters filled in by io_uring_setup(), giving the offsets of
+ *           the ring fields in the mappings.
+ * @pending: Number of queued entries not yet submitted.
+ */
+struct uring {
+	int fd;
+	uint8_t *sq;
+	uint8_t *cq;
+	struct io_uring_sqe *sqes;
+	size_t sq_len;
+	size_t cq_len;
+	struct io_uring_params p;
+	unsigned pending;
+};
+
+static int uring_setup(struct uring *u, unsigned entries)
+{
+	memset(u, 0, sizeof(*u));
+
+	u->fd = syscall(__NR_io_uring_setup, entries, &u->p);
+	if (u->fd < 0)
+		return -1;
+
+	u->sq_len = u->p.sq_off.array + u->p.sq_entries * sizeof(unsigned);
+	u->cq_len = u->p.cq_off.cqes
+	          + u->p.cq_entries * sizeof(struct io_uring_cqe);
+
+	if (u->p.features & IORING_FEAT_SINGLE_MMAP) {
+		if (u->cq_len > u->sq_len)
+			u->sq_len = u->cq_len;
+		u->cq_len = u->sq_len;
+	}
+
+	u->sq = mmap(NULL, u->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED,
+	             u->fd, IORING_OFF_SQ_RING);
+	if (u->sq == MAP_FAILED)
+		goto fail_sq;
+
+	u->cq = u->sq;
+	if (!(u->p.features & IORING_FEAT_SINGLE_MMAP)) {
+		u->cq = mmap(NULL, u->cq_len, PROT_READ | PROT_WRITE,
+		             MAP_SHARED, u->fd, IORING_OFF_CQ_RING);
+		if (u->cq == MAP_FAILED)
+			goto fail_cq;
+	}
+
+	u->sqes = mmap(NULL, u->p.sq_entries * sizeof(struct io_uring_sqe),
+	               PROT_READ | PROT_WRITE, MAP_SHARED, u->fd,
+	               IORING_OFF_SQES);
+	if (u->sqes == MAP_FAILED)
+		goto fail_sqes;
+
+	return 0;
+
+fail_sqes:
+	if (u->cq != u->sq)
+		munmap(u->cq, u->cq_len);
+fail_cq:
+	munmap(u->sq, u->sq_len);
+fail_sq:
+	close(u->fd);
+	return -1;
+}
+
+static void uring_destroy(struct uring *u)
+{
+	munmap(u->sqes, u->p.sq_entries * sizeof(struct io_uring_sqe));
+	if (u->cq != u->sq)
+		munmap(u->cq, u->cq_len);
+	munmap(u->sq, u->sq_len);
+	close(u->fd);
+}
+
+/**
+ * uring_readv - Queue a positional read.
+ *
+ * @u:    Pointer to an io_uring instance with a free submission queue entry.
+ * @fd:   File descriptor to read.
+ * @iov:  Buffer to read into. Must stay valid until the read completes.
+ * @off:  File offset to read from.
+ * @data: Value returned with the completion.
+ *
+ * @return: None.
+ *
+ * IORING_OP_READV rather than IORING_OP_READ keeps this working on the first
+ * kernels to have io_uring.
+ */
+static void uring_readv(struct uring *u, int fd, const struct iovec *iov,
+                        off_t off, uint64_t data)
+{
+	unsigned *tail = (unsigned *)(u->sq + u->p.sq_off.tail);
+	unsigned mask = *(unsigned *)(u->sq + u->p.sq_off.ring_mask);
+	unsigned *array = (unsigned *)(u->sq + u->p.sq_off.array);
+	unsigned t = *tail, i = t & mask;
+	struct io_uring_sqe *sqe = &u->sqes[i];
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_READV;
+	sqe->fd = fd;
+	sqe->addr = (uintptr_t)iov;
+	sqe->len = 1;
+	sqe->off = off;
+	sqe->user_data = data;
+
+	array[i] = i;
+	__atomic_store_n(tail, t + 1, __ATOMIC_RELEASE);
+	u->pending++;
+}
+
+/**
+ * uring_wait - Submit queued entries and wait for a completion.
+ *
+ * @u:    Pointer to an io_uring instance.
+ * @data: Where to store the user data of the completion.
+ * @res:  Where to store the result of the completion.
+ *
+ * @return: Zero on success, or -1 on error with errno set.
+ */
+static int uring_wait(struct uring *u, uint64_t *data, int *res)
+{
+	unsigned *head = (unsigned *)(u->cq + u->p.cq_off.head);
+	unsigned *tail = (unsigned *)(u->cq + u->p.cq_off.tail);
+	unsigned mask = *(unsigned *)(u->cq + u->p.cq_off.ring_mask);
+	struct io_uring_cqe *cqes = (void *)(u->cq + u->p.cq_off.cqes);
+	unsigned h = *head;
+
+	while (u->pending || h == __atomic_load_n(tail, __ATOMIC_ACQUIRE)) {
+		long r = syscall(__NR_io_uring_enter, u->fd, u->pending, 1,
+		                 IORING_ENTER_GETEVENTS, NULL, 0);
+		if (r >= 0)
+			u->pending -= r;
+		else if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+			return -1;
+	}
+
+	*data = cqes[h & mask].user_data;
+	*res = cqes[h & mask].res;
+	__atomic_store_n(head, h + 1, __ATOMIC_RELEASE);
+	return 0;
+}
+
+/**
+ * struct uring_pipe - Ring of buffers filled through io_uring.
+ *
+ * @u:        io_uring instance.
+ * @fd:       File descriptor being read.
+ * @buf:      FD_PIPE_DEPTH buffers of @size bytes each.
+ * @size:     Size of each buffer in bytes.
+ * @next:     File offset of the first byte not yet assigned to a buffer.
+ * @end:      File offset to stop reading at.
+ * @inflight: Number of reads queued or in progress.
+ * @err:      Error number of the first failed read, or zero.
+ * @pos:      File offset of the data in each buffer.
+ * @len:      Number of bytes wanted in each buffer, or zero if it's unused.
+ * @got:      Number of bytes read into each buffer so far.
+ * @busy:     Whether each buffer has a read in flight.
+ * @iov:      Destination of each buffer's read in flight.
+ */
+struct uring_pipe {
+	struct uring u;
+	int fd;
+	uint8_t *buf;
+	size_t size;
+	off_t next;
+	off_t end;
+	size_t inflight;
+	int err;
+
+	off_t pos[FD_PIPE_DEPTH];
+	size_t len[FD_PIPE_DEPTH];
+	size_t got[FD_PIPE_DEPTH];
+	bool busy[FD_PIPE_DEPTH];
+	struct iovec iov[FD_PIPE_DEPTH];
+};
+
+static void pipe_submit(struct uring_pipe *p, size_t k)
+{
+	p->iov[k].iov_base = p->buf + k * p->size + p->got[k];
+	p->iov[k].iov_len = p->len[k] - p->got[k];
+	uring_readv(&p->u, p->fd, &p->iov[k], p->pos[k] + p->got[k], k);
+	p->busy[k] = true;
+	p->inflight++;
+}
+
+static void pipe_start(struct uring_pipe *p, size_t k)
+{
+	off_t left = p->end - p->next;
+
+	p->len[k] = left < (off_t)p->size ? (size_t)left : p->size;
+	p->got[k] = 0;
+	if (!p->len[k])
+		return;
+
+	p->pos[k] = p->next;
+	p->next += p->len[k];
+	pipe_submit(p, k);
+}
+
+/**
+ * pipe_reap - Wait for a read to complete and account for it.
+ *
+ * @p: Pointer to a pipeline with at least one read in flight.
+ *
+ * @return: None.
+ *
+ * Short reads are resubmitted for the rest of the buffer. A read at end of
+ * file means the file has been truncated since it was measured, so the buffer
+ * is cut short. Nothing is resubmitted once a read has failed.
+ */
+static void pipe_reap(struct uring_pipe *p)
+{
+	uint64_t k;
+	int res;
+
+	if (uring_wait(&p->u, &k, &res)) {
+		/*
+		 * This only happens if the ring itself is broken, so no more
+		 * completions can be expected.
+		 */
+		p->err = errno;
+		p->inflight = 0;
+		return;
+	}
+
+	p->inflight--;
+	p->busy[k] = false;
+
+	if (res == -EINTR || res == -EAGAIN) {
+		if (!p->err)
+			pipe_submit(p, k);
+	} else if (res < 0) {
+		if (!p->err)
+			p->err = -res;
+	} else if (!res) {
+		p->len[k] = p->got[k];
+	} else {
+		p->got[k] += res;
+		if (p->got[k] < p->len[k] && !p->err)
+			pipe_submit(p, k);
+	}
+}
+
+/**
+ * update_uring - Absorb the rest of a regular file through io_uring.
+ *
+ * @ctx: Pointer to an initialised SHA-3 context structure.
+ * @fd:  File descriptor of a regular file open for reading.
+ * @off: Current file offset.
+ * @end: Size of the file.
+ *
+ * @return: Zero on success, -1 on error with errno set, or 1 if io_uring
+ *          isn't available, in which case nothing has been absorbed.
+ *
+ * Each buffer is queued again as soon as it's been hashed, so up to
+ * FD_PIPE_DEPTH reads are in flight at once. They complete in any order, but
+ * the buffers are hashed in file order. On success the file offset is left
+ * after the last byte hashed.
+ */
+static int update_uring(struct sha3_ctx *ctx, int fd, off_t off, off_t end)
+{
+	struct uring_pipe p = {
+		.fd = fd,
+		.size = (size_t)ctx->rate << FD_PIPE_SHIFT,
+		.next = off,
+		.end = end,
+	};
+
+	p.buf = alloc_buffers(FD_PIPE_DEPTH * p.size);
+	if (!p.buf)
+		return 1;
+
+	if (uring_setup(&p.u, FD_PIPE_DEPTH)) {
+		free(p.buf);
+		return 1;
+	}
+
+	for (size_t k = 0; k < FD_PIPE_DEPTH; k++)
+		pipe_start(&p, k);
+
+	for (size_t k = 0; p.len[k] && !p.err; k = (k + 1) % FD_PIPE_DEPTH) {
+		size_t want = p.len[k];
+
+		while (p.busy[k] && !p.err)
+			pipe_reap(&p);
+
+		if (p.err)
+			break;
+
+		sha3_update(ctx, p.buf + k * p.size, p.got[k]);
+		off = p.pos[k] + p.got[k];
+
+		/* Stop at a truncated buffer, leaving the rest to drain. */
+		if (p.got[k] < want)
+			break;
+
+		pipe_start(&p, k);
+	}
+
+	while (p.inflight)
+		pipe_reap(&p);
+
+	uring_destroy(&p.u);
+	free(p.buf);
+
+	if (p.err) {
+		errno = p.err;
+		return -1;
+	}
+
+	return lseek(fd, off, SEEK_SET) < 0 ? -1 : 0;
+}
+#endif
+
+/**
+ * update_mmap - Absorb the rest of a regular file by mapping it.
+ *
+ * @ctx: Pointer to an initialised SHA-3 context structure.
+ * @fd:  File descriptor of a regular file open for reading.
+ * @off: Current file offset.
+ * @end: Size of the file.
+ *
+ * @return: Zero on success, -1 on error with errno set, or 1 if the file
+ *          couldn't be mapped at all, in which case nothing has been absorbed.
+ *          If a later window can't be mapped, the rest of the file is read
+ *          instead.
+ *
+ * On success the file offset is left at @end, as if the file had been read.
+ */
+static int update_mmap(struct sha3_ctx *ctx, int fd, off_t off, off_t end)
+{
+	size_t window = (size_t)ctx->rate << FD_WINDOW_SHIFT;
+	off_t base = off - off % sysconf(_SC_PAGESIZE);
+	off_t start = off;
+
+	for (; base < end; base += window) {
+		size_t len = end - base < (off_t)window ? (size_t)(end - base)
+		                                        : window;
+		size_t skip = off - base;
+		void *p;
+
+		p = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, base);
+		if (p == MAP_FAILED && off == start)
+			return 1;
+		if (p == MAP_FAILED)
+			return lseek(fd, off, SEEK_SET) < 0 ? -1
+			                                    : update_read(ctx, fd);
+
+		posix_madvise(p, len, POSIX_MADV_SEQUENTIAL);
+#if defined(POSIX_FADV_WILLNEED)
+		if (base + (off_t)len < end)
+			posix_fadvise(fd, base + len, window, POSIX_FADV_WILLNEED);
+#endif
+
+		sha3_update(ctx, (uint8_t *)p + skip, len - skip);
+		munmap(p, len);
+		off = base + len;
+	}
+
+	return lseek(fd, end, SEEK_SET) < 0 ? -1 : 0;
+}
+
+int sha3_update_fd(struct sha3_ctx *ctx, int fd)
+{
+	struct stat st;
+	off_t off;
+	int ret;
+
+	if (fstat(fd, &st))
+		return -1;
+
+	if (S_ISREG(st.st_mode)) {
+		off = lseek(fd, 0, SEEK_CUR);
+		if (off < 0 || st.st_size - off < FD_PIPE_MIN)
+			return update_read(ctx, fd);
+
+#if defined(FD_HAVE_IO_URING)
+		ret = update_uring(ctx, fd, off, st.st_size);
+		if (ret <= 0)
+			return ret;
+#endif
+
+		ret = update_mmap(ctx, fd, off, st.st_size);
+		if (ret <= 0)
+			return ret;
+	}
+
+	ret = update_reader(ctx, fd);
+	if (ret <= 0)
+		return ret;
+
+	return update_read(ctx, fd);
+}
+
+int sha3_hash_fd(int fd, enum sha3_algo algo, void *md)
+{
+	struct sha3_ctx ctx;
+
+	sha3_init(&ctx, algo);
+	if (sha3_update_fd(&ctx, fd))
+		return -1;
+
+	sha3_final(&ctx, md);
+	return 0;
+}
+
+int sha3_hash_path(const char *path, enum sha3_algo algo, void *md)
+{
+	int fd, ret, err;
+
+	do
+		fd = open(path, O_RDONLY | O_CLOEXEC);
+	while (fd < 0 && errno == EINTR);
+
+	if (fd < 0)
+		return -1;
+
+	ret = sha3_hash_fd(fd, algo, md);
+	err = errno;
+	close(fd);
+	errno = err;
+	return ret;
+}
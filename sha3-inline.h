@@ -0,0 +1,301 @@
+/* SPDX-License-Identifier: 0BSD
+ *
+ * Copyright © 2022 Alex Minghella <a@minghella.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Header-only definitions of the core SHA-3 and SHAKE functions.
+ *
+ * sha3.h includes this when SHA3_IMPLEMENTATION is defined, and it shouldn't
+ * be included any other way. The functions declared SHA3_INLINE in sha3.h are
+ * defined here as static inline functions, so the compiler can inline them at
+ * each call site and fold the algorithm, and with it the rate, the digest size,
+ * and the padding, into constants. Everything else in sha3.h still comes from
+ * the library.
+ *
+ * A call through the kernel table can't be inlined, so these always use the
+ * generic permutation, generated from keccak-unroll.h. The context is the same
+ * as the library's, so a context initialised here may be passed to library
+ * functions such as sha3_updatev() or kmac_final(), and the other way around.
+ * Hashing done here isn't counted by sha3_stats_get() and has no probes.
+ *
+ * This also compiles as C++, for sha3.hpp.
+ */
+
+#ifndef SHA3_INLINE_H
+#define SHA3_INLINE_H 1
+
+#if !defined(SHA3_H) || !defined(SHA3_IMPLEMENTATION)
+	#error Include sha3.h with SHA3_IMPLEMENTATION defined instead.
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+static const uint64_t sha3_inline_rc[24] = {
+	0x0000000000000001, 0x0000000000008082, 0x800000000000808a,
+	0x8000000080008000, 0x000000000000808b, 0x0000000080000001,
+	0x8000000080008081, 0x8000000000008009, 0x000000000000008a,
+	0x0000000000000088, 0x0000000080008009, 0x000000008000000a,
+	0x000000008000808b, 0x800000000000008b, 0x8000000000008089,
+	0x8000000000008003, 0x8000000000008002, 0x8000000000000080,
+	0x000000000000800a, 0x800000008000000a, 0x8000000080008081,
+	0x8000000000008080, 0x0000000080000001, 0x8000000080008008
+};
+
+static inline uint64_t sha3_inline_rotl64(uint64_t x, unsigned n)
+{
+	return (x << n) | (x >> (64 - n));
+}
+
+/*
+ * The byte order is spelled out rather than tested for, since compilers turn
+ * these into a plain or byte-reversed 64-bit load or store anyway.
+ */
+static inline uint64_t sha3_inline_load64le(const uint8_t *p)
+{
+	return (uint64_t)p[0]       | (uint64_t)p[1] << 8
+	       | (uint64_t)p[2] << 16 | (uint64_t)p[3] << 24
+	       | (uint64_t)p[4] << 32 | (uint64_t)p[5] << 40
+	       | (uint64_t)p[6] << 48 | (uint64_t)p[7] << 56;
+}
+
+static inline void sha3_inline_store64le(uint8_t *p, uint64_t x)
+{
+	for (size_t i = 0; i < 8; i++)
+		p[i] = (uint8_t)(x >> 8 * i);
+}
+
+#define KECCAK_NAME         sha3_inline_p1600
+#define KECCAK_ATTR
+#define KECCAK_LANE         uint64_t
+#define KECCAK_XOR(a, b)    ((a) ^ (b))
+#define KECCAK_XOR5(a, b, c, d, e) \
+	((a) ^ (b) ^ (c) ^ (d) ^ (e))
+#define KECCAK_RAX1(a, b)   ((a) ^ sha3_inline_rotl64(b, 1))
+#define KECCAK_XAR(a, b, n) sha3_inline_rotl64((a) ^ (b), n)
+#define KECCAK_CHI(a, b, c) ((a) ^ (~(b) & (c)))
+#define KECCAK_RC(i)        sha3_inline_rc[i]
+#include "keccak-unroll.h"
+
+/**
+ * sha3_inline_xor - XOR bytes into the state.
+ *
+ * @A:   Keccak internal state.
+ * @off: Byte index in the state of the first byte to modify.
+ * @p:   Input data.
+ * @len: Number of bytes to XOR in.
+ *
+ * @return: None.
+ *
+ * The state is only ever accessed a lane at a time, so that it needs no
+ * byte-order handling on big-endian hosts, unlike @u8 of struct sha3_ctx.
+ */
+static inline void sha3_inline_xor(uint64_t A[25], size_t off,
+                                   const uint8_t *p, size_t len)
+{
+	for (; len && off % 8; len--, off++)
+		A[off / 8] ^= (uint64_t)*p++ << 8 * (off % 8);
+
+	for (; len >= 8; len -= 8, off += 8, p += 8)
+		A[off / 8] ^= sha3_inline_load64le(p);
+
+	for (; len; len--, off++)
+		A[off / 8] ^= (uint64_t)*p++ << 8 * (off % 8);
+}
+
+/**
+ * sha3_inline_extract - Copy bytes out of the state.
+ *
+ * As extract() in sha3.c.
+ */
+static inline void sha3_inline_extract(const uint64_t A[25], size_t off,
+                                       uint8_t *q, size_t len)
+{
+	for (; len && off % 8; len--, off++)
+		*q++ = (uint8_t)(A[off / 8] >> 8 * (off % 8));
+
+	for (; len >= 8; len -= 8, off += 8, q += 8)
+		sha3_inline_store64le(q, A[off / 8]);
+
+	for (; len; len--, off++)
+		*q++ = (uint8_t)(A[off / 8] >> 8 * (off % 8));
+}
+
+/**
+ * sha3_inline_pad - Pad the final block and apply the permutation.
+ *
+ * As keccak_pad() in sha3.c.
+ */
+static inline void sha3_inline_pad(struct sha3_ctx *ctx, uint8_t ds)
+{
+	ctx->u64[ctx->index / 8] ^= (uint64_t)ds << 8 * (ctx->index % 8);
+	ctx->u64[ctx->rate / 8 - 1] ^= 0x8000000000000000ULL;
+
+	sha3_inline_p1600(ctx->u64, ctx->rounds);
+	ctx->index = 0;
+}
+
+/**
+ * sha3_inline_oneshot - Compute a SHA-3 digest with the algorithm known in
+ *                       advance.
+ *
+ * As sha3_oneshot() in sha3.c. Short input skips straight to the final block,
+ * so this also serves for the sha3_*_short() functions.
+ */
+static inline void sha3_inline_oneshot(const void *buf, size_t len, void *md,
+                                       size_t size)
+{
+	const size_t rate = 200 - 2 * size;
+	const uint8_t *p = (const uint8_t *)buf;
+	uint64_t A[25] = { 0 };
+
+	for (; len >= rate; len -= rate, p += rate) {
+		sha3_inline_xor(A, 0, p, rate);
+		sha3_inline_p1600(A, 24);
+	}
+
+	sha3_inline_xor(A, 0, p, len);
+	A[len / 8] ^= (uint64_t)0x06 << 8 * (len % 8);
+	A[rate / 8 - 1] ^= 0x8000000000000000ULL;
+	sha3_inline_p1600(A, 24);
+
+	sha3_inline_extract(A, 0, (uint8_t *)md, size);
+}
+
+SHA3_INLINE void sha3_init(struct sha3_ctx *ctx, enum sha3_algo algo)
+{
+	ctx->index = 0;
+	ctx->rate = (uint8_t)(200 - 2 * algo);
+	ctx->size = (uint8_t)algo;
+	ctx->rounds = 24;
+	ctx->ds = 0x06;
+	memset(ctx->u8, 0, 200);
+}
+
+SHA3_INLINE void sha3_update(struct sha3_ctx *ctx, const void *buf,
+                             size_t len)
+{
+	const uint8_t *p = (const uint8_t *)buf;
+
+	while (len) {
+		size_t n = ctx->rate - ctx->index;
+		if (n > len)
+			n = len;
+
+		sha3_inline_xor(ctx->u64, ctx->index, p, n);
+		ctx->index = (uint8_t)(ctx->index + n);
+		p += n;
+		len -= n;
+
+		if (ctx->index == ctx->rate) {
+			ctx->index = 0;
+			sha3_inline_p1600(ctx->u64, ctx->rounds);
+		}
+	}
+}
+
+SHA3_INLINE void sha3_final(struct sha3_ctx *ctx, void *md)
+{
+	sha3_inline_pad(ctx, ctx->ds);
+
+	sha3_inline_extract(ctx->u64, 0, (uint8_t *)md, ctx->size);
+	memset(ctx->u8, 0, 200);
+}
+
+SHA3_INLINE void sha3_ctx_clone(struct sha3_ctx *dst,
+                                const struct sha3_ctx *src)
+{
+	memcpy(dst, src, sizeof(*dst));
+}
+
+SHA3_INLINE void sha3_224(const void *buf, size_t len, void *md)
+{
+	sha3_inline_oneshot(buf, len, md, SHA3_224);
+}
+
+SHA3_INLINE void sha3_256(const void *buf, size_t len, void *md)
+{
+	sha3_inline_oneshot(buf, len, md, SHA3_256);
+}
+
+SHA3_INLINE void sha3_384(const void *buf, size_t len, void *md)
+{
+	sha3_inline_oneshot(buf, len, md, SHA3_384);
+}
+
+SHA3_INLINE void sha3_512(const void *buf, size_t len, void *md)
+{
+	sha3_inline_oneshot(buf, len, md, SHA3_512);
+}
+
+SHA3_INLINE void sha3_224_short(const void *buf, size_t len, void *md)
+{
+	sha3_inline_oneshot(buf, len, md, SHA3_224);
+}
+
+SHA3_INLINE void sha3_256_short(const void *buf, size_t len, void *md)
+{
+	sha3_inline_oneshot(buf, len, md, SHA3_256);
+}
+
+SHA3_INLINE void sha3_384_short(const void *buf, size_t len, void *md)
+{
+	sha3_inline_oneshot(buf, len, md, SHA3_384);
+}
+
+SHA3_INLINE void sha3_512_short(const void *buf, size_t len, void *md)
+{
+	sha3_inline_oneshot(buf, len, md, SHA3_512);
+}
+
+SHA3_INLINE void shake_init(struct sha3_ctx *ctx, enum shake_algo algo)
+{
+	ctx->index = 0;
+	ctx->rate = (uint8_t)(200 - 2 * algo);
+	ctx->size = 0;
+	ctx->rounds = 24;
+	ctx->ds = 0x1f;
+	memset(ctx->u8, 0, 200);
+}
+
+SHA3_INLINE void shake_final(struct sha3_ctx *ctx)
+{
+	sha3_inline_pad(ctx, ctx->ds);
+}
+
+SHA3_INLINE void shake_squeeze(struct sha3_ctx *ctx, void *out, size_t len)
+{
+	uint8_t *q = (uint8_t *)out;
+
+	while (len) {
+		if (ctx->index == ctx->rate) {
+			sha3_inline_p1600(ctx->u64, ctx->rounds);
+			ctx->index = 0;
+		}
+
+		size_t n = ctx->rate - ctx->index;
+		if (n > len)
+			n = len;
+
+		sha3_inline_extract(ctx->u64, ctx->index, q, n);
+
+		ctx->index = (uint8_t)(ctx->index + n);
+		q += n;
+		len -= n;
+	}
+}
+
+#endif /* SHA3_INLINE_H */
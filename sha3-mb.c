@@ -0,0 +1,521 @@
+/* SPDX-License-Identifier: 0BSD
+ *
+ * Copyright © 2022 Alex Minghella <a@minghella.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Multi-buffer SHA-3.
+ *
+ * The multi-buffer contexts hold several independent SHA-3 states interleaved
+ * lane by lane, so that lane i of every state is contiguous in memory and can
+ * be loaded into a single SIMD register. All states in a context are always
+ * at the same position in their input, which keeps the absorb loop identical
+ * to that of sha3_update() with an extra inner loop over the states.
+ */
+
+#include "sha3.h"
+#include "keccak.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * mb_absorb_byte - XOR one byte of input into each of @n interleaved states.
+ *
+ * @A:     Interleaved Keccak internal states.
+ * @n:     Number of interleaved states.
+ * @index: Byte index in each state.
+ * @p:     Array of @n input pointers, each of which is advanced by one byte.
+ *
+ * @return: None.
+ *
+ * Bytes are shifted into place rather than addressed through a byte-wise view
+ * of the state so that this works regardless of host endianness.
+ */
+static inline void mb_absorb_byte(uint64_t *A, size_t n, uint8_t index,
+                                  const uint8_t **p)
+{
+	for (size_t j = 0; j < n; j++)
+		A[n * (index / 8) + j] ^= (uint64_t)*p[j]++ << 8 * (index % 8);
+}
+
+/**
+ * mb_squeeze - Copy bytes out of one of @n interleaved states.
+ *
+ * @A:   Interleaved Keccak internal states.
+ * @n:   Number of interleaved states.
+ * @j:   Index of the state to read.
+ * @md:  Output buffer.
+ * @len: Number of bytes to copy from the start of the state.
+ *
+ * @return: None.
+ */
+static inline void mb_squeeze(const uint64_t *A, size_t n, size_t j, void *md,
+                              size_t len)
+{
+	uint8_t *q = md;
+	size_t i = 0;
+
+	for (; i + 8 <= len; i += 8)
+		store64le(q + i, A[n * (i / 8) + j]);
+
+	for (; i < len; i++)
+		q[i] = A[n * (i / 8) + j] >> 8 * (i % 8);
+}
+
+static void mb_update(uint8_t *index, uint8_t rate, uint64_t *A, size_t n,
+                      void (*f)(uint64_t *, size_t), const void *const *buf,
+                      size_t len)
+{
+	const uint8_t *p[8];
+	for (size_t j = 0; j < n; j++)
+		p[j] = buf[j];
+
+	while (len && (*index & 7)) {
+		mb_absorb_byte(A, n, (*index)++, p);
+		len--;
+
+		if (*index == rate) {
+			*index = 0;
+			f(A, 24);
+			KECCAK_STAT(permutations, n);
+		}
+	}
+
+	while (len > 7) {
+		uint64_t *lane = &A[n * (*index / 8)];
+		for (size_t j = 0; j < n; j++) {
+			lane[j] ^= load64le(p[j]);
+			p[j] += 8;
+		}
+
+		*index += 8;
+		len -= 8;
+
+		if (*index == rate) {
+			*index = 0;
+			f(A, 24);
+			KECCAK_STAT(permutations, n);
+		}
+	}
+
+	while (len--)
+		mb_absorb_byte(A, n, (*index)++, p);
+}
+
+static void mb_final(uint8_t index, uint8_t rate, uint8_t size, uint64_t *A,
+                     size_t n, void (*f)(uint64_t *, size_t), void *const *md)
+{
+	/* See sha3_final() for a description of the padding. */
+	for (size_t j = 0; j < n; j++) {
+		A[n * (index / 8) + j] ^= 0x06ULL << 8 * (index % 8);
+		A[n * ((rate - 1) / 8) + j] ^= 0x80ULL << 8 * ((rate - 1) % 8);
+	}
+
+	f(A, 24);
+	KECCAK_STAT(permutations, n);
+	KECCAK_STAT(finals, n);
+
+	for (size_t j = 0; j < n; j++)
+		mb_squeeze(A, n, j, md[j], size);
+
+	memset(A, 0, 200 * n);
+}
+
+void keccakp_1600_xn(uint64_t *A, size_t n, size_t nr)
+{
+	for (size_t j = 0; j < n; j++) {
+		uint64_t S[25];
+
+		for (size_t i = 0; i < 25; i++)
+			S[i] = A[n * i + j];
+
+		keccakp_1600(S, nr);
+
+		for (size_t i = 0; i < 25; i++)
+			A[n * i + j] = S[i];
+	}
+}
+
+void sha3_init_x4(struct sha3_ctx_x4 *ctx, enum sha3_algo algo)
+{
+	ctx->index = 0;
+	ctx->rate = 200 - 2 * algo;
+	ctx->size = algo;
+	memset(ctx->u64, 0, sizeof(ctx->u64));
+}
+
+/**
+ * mb_broadcast - Copy one SHA-3 state into each of @n interleaved states.
+ *
+ * @A:   Interleaved Keccak internal states.
+ * @n:   Number of interleaved states.
+ * @mid: State to copy.
+ *
+ * @return: None.
+ */
+static void mb_broadcast(uint64_t *A, size_t n, const struct sha3_ctx *mid)
+{
+	for (size_t i = 0; i < 25; i++) {
+		for (size_t j = 0; j < n; j++)
+			A[n * i + j] = mid->u64[i];
+	}
+}
+
+/**
+ * mid_is_sha3 - Check that a midstate can continue in a multi-buffer context.
+ *
+ * @mid: Pointer to a SHA-3 context.
+ *
+ * @return: Whether @mid was started by sha3_init(), which is all that
+ *          mb_final() can finish, since it always pads with the SHA-3 suffix
+ *          and applies all 24 rounds.
+ */
+static bool mid_is_sha3(const struct sha3_ctx *mid)
+{
+	return mid->size && mid->ds == 0x06 && mid->rounds == 24;
+}
+
+int sha3_init_x4_from(struct sha3_ctx_x4 *ctx, const struct sha3_ctx *mid)
+{
+	if (!mid_is_sha3(mid))
+		return -1;
+
+	ctx->index = mid->index;
+	ctx->rate = mid->rate;
+	ctx->size = mid->size;
+	mb_broadcast(ctx->u64, 4, mid);
+	return 0;
+}
+
+void sha3_update_x4(struct sha3_ctx_x4 *ctx, const void *const buf[4],
+                    size_t len)
+{
+	mb_update(&ctx->index, ctx->rate, ctx->u64, 4, keccak_impl->p1600_x4,
+	          buf, len);
+}
+
+void sha3_final_x4(struct sha3_ctx_x4 *ctx, void *const md[4])
+{
+	mb_final(ctx->index, ctx->rate, ctx->size, ctx->u64, 4,
+	         keccak_impl->p1600_x4, md);
+}
+
+void sha3_init_x8(struct sha3_ctx_x8 *ctx, enum sha3_algo algo)
+{
+	ctx->index = 0;
+	ctx->rate = 200 - 2 * algo;
+	ctx->size = algo;
+	memset(ctx->u64, 0, sizeof(ctx->u64));
+}
+
+int sha3_init_x8_from(struct sha3_ctx_x8 *ctx, const struct sha3_ctx *mid)
+{
+	if (!mid_is_sha3(mid))
+		return -1;
+
+	ctx->index = mid->index;
+	ctx->rate = mid->rate;
+	ctx->size = mid->size;
+	mb_broadcast(ctx->u64, 8, mid);
+	return 0;
+}
+
+void sha3_update_x8(struct sha3_ctx_x8 *ctx, const void *const buf[8],
+                    size_t len)
+{
+	mb_update(&ctx->index, ctx->rate, ctx->u64, 8, keccak_impl->p1600_x8,
+	          buf, len);
+}
+
+void sha3_final_x8(struct sha3_ctx_x8 *ctx, void *const md[8])
+{
+	mb_final(ctx->index, ctx->rate, ctx->size, ctx->u64, 8,
+	         keccak_impl->p1600_x8, md);
+}
+
+/*
+ * Number of messages keccak_hash_many() sorts by length at a time. Sorting
+ * brings messages with the same number of blocks together so that they can
+ * share a multi-buffer state without wasted permutations.
+ */
+#define BATCH_WINDOW 64
+
+struct batch {
+	const uint8_t *p;
+	size_t len;
+	size_t blocks;
+	uint8_t *md;
+};
+
+/*
+ * Sponge parameters shared by every message in a call to hash_many().
+ *
+ * @mid:  Midstate that every message continues from, or NULL to start from
+ *        the zero state.
+ * @sfx:  Suffix appended to every message, or NULL if @slen is zero.
+ * @slen: Length, in bytes, of the suffix. At most the rate.
+ * @rate: Padding rate in bytes.
+ * @ds:   Domain separation byte, as keccak_pad().
+ * @nr:   Number of rounds, as keccakp_1600().
+ * @size: Output size in bytes.
+ */
+struct sponge {
+	const struct sha3_ctx *mid;
+	const uint8_t *sfx;
+	size_t slen;
+	size_t rate;
+	uint8_t ds;
+	size_t nr;
+	size_t size;
+};
+
+/**
+ * batch_absorb - Absorb one block of a message, padding it if it's the last.
+ *
+ * @A: Interleaved Keccak internal states.
+ * @n: Number of interleaved states.
+ * @j: Index of the state the message is assigned to.
+ * @m: Message.
+ * @b: Index of the block to absorb. Must be less than @m->blocks.
+ * @s: Sponge parameters.
+ *
+ * @return: None.
+ *
+ * The first block is stored rather than XORed so that the state never needs
+ * to be cleared beforehand. With a midstate, the first block is only the
+ * bytes from @s->mid->index to the end of the block, and every later block is
+ * shifted back by @s->mid->index bytes. Any block that isn't wholly inside
+ * the message is gathered into a buffer along with the suffix and padding.
+ */
+static void batch_absorb(uint64_t *A, size_t n, size_t j,
+                         const struct batch *m, size_t b,
+                         const struct sponge *s)
+{
+	size_t rate = s->rate;
+	size_t off = s->mid ? s->mid->index : 0;
+
+	/*
+	 * Block b covers bytes [lo, end) of the state, which are bytes
+	 * [start, start + end - lo) of the message followed by the suffix.
+	 */
+	size_t lo = b ? 0 : off;
+	size_t start = b * rate + lo - off;
+	size_t rem = m->len + s->slen + off - b * rate;
+	size_t end = rem < rate ? rem : rate;
+	const uint8_t *p = m->p + (start < m->len ? start : m->len);
+	uint8_t pad[200];
+
+	/*
+	 * Without an offset or a suffix, the final block is just the end of
+	 * the message, so it's loaded and padded in place. Without a midstate
+	 * the first block can be stored even then.
+	 */
+	if (!off && !s->slen && rem < rate && (b || !s->mid)) {
+		keccak_last_block(A + j, n, p, rem, rate, s->ds, !b);
+		return;
+	}
+
+	/* See sha3_final() for a description of the padding. */
+	if (lo || end < rate || start + rate > m->len) {
+		size_t cnt = end - lo;
+		size_t k = start < m->len ? m->len - start : 0;
+		if (k > cnt)
+			k = cnt;
+
+		memset(pad, 0, rate);
+		memcpy(pad + lo, p, k);
+		if (cnt > k)
+			memcpy(pad + lo + k, s->sfx + (start + k - m->len), cnt - k);
+
+		if (rem < rate) {
+			pad[rem] ^= s->ds;
+			pad[rate - 1] ^= 0x80;
+		}
+		p = pad;
+	}
+
+	if (!b) {
+		for (size_t i = 0; i < rate / 8; i++) {
+			A[n * i + j] = load64le(p + 8 * i);
+			if (s->mid)
+				A[n * i + j] ^= s->mid->u64[i];
+		}
+		for (size_t i = rate / 8; i < 25; i++)
+			A[n * i + j] = s->mid ? s->mid->u64[i] : 0;
+	} else {
+		for (size_t i = 0; i < rate / 8; i++)
+			A[n * i + j] ^= load64le(p + 8 * i);
+	}
+}
+
+/**
+ * batch_hash - Hash up to @n messages in lockstep in one multi-buffer state.
+ *
+ * @m:     Array of @count messages.
+ * @count: Number of messages. At most @n.
+ * @n:     Number of interleaved states.
+ * @f:     Permutation function for @n interleaved states.
+ * @s:     Sponge parameters.
+ *
+ * @return: None.
+ *
+ * Messages need not have the same number of blocks. A state whose message is
+ * finished is still permuted along with the others, but is otherwise ignored.
+ */
+static void batch_hash(const struct batch *m, size_t count, size_t n,
+                       void (*f)(uint64_t *, size_t), const struct sponge *s)
+{
+	uint64_t A[200];
+
+	size_t blocks = 0;
+	for (size_t j = 0; j < count; j++) {
+		if (m[j].blocks > blocks)
+			blocks = m[j].blocks;
+	}
+
+	for (size_t i = 0; i < 25; i++) {
+		for (size_t j = count; j < n; j++)
+			A[n * i + j] = 0;
+	}
+
+	for (size_t b = 0; b < blocks; b++) {
+		size_t live = 0;
+		for (size_t j = 0; j < count; j++) {
+			if (b < m[j].blocks) {
+				batch_absorb(A, n, j, &m[j], b, s);
+				live++;
+			}
+		}
+
+		/*
+		 * Only the states still absorbing a message are counted. A
+		 * single state goes through keccak_impl->p1600, which counts
+		 * itself.
+		 */
+		f(A, s->nr);
+		if (n > 1)
+			KECCAK_STAT(permutations, live);
+
+		for (size_t j = 0; j < count; j++) {
+			if (b + 1 == m[j].blocks)
+				mb_squeeze(A, n, j, m[j].md, s->size);
+		}
+	}
+
+	memset(A, 0, sizeof(A));
+}
+
+/**
+ * hash_many - Hash many messages with the same sponge parameters.
+ *
+ * @s:    Sponge parameters.
+ * @bufs: Array of @n pointers to input data.
+ * @lens: Array of @n input lengths in bytes.
+ * @n:    Number of messages.
+ * @out:  Output buffer of at least @n * @s->size bytes.
+ *
+ * @return: None.
+ */
+static void hash_many(const struct sponge *s, const void *const *bufs,
+                      const size_t *lens, size_t n, void *out)
+{
+	uint8_t *md = out;
+	size_t off = s->mid ? s->mid->index : 0;
+
+	size_t width;
+	void (*f)(uint64_t *, size_t);
+	if (keccak_impl->width >= 8) {
+		width = 8;
+		f = keccak_impl->p1600_x8;
+	} else if (keccak_impl->width >= 2) {
+		width = 4;
+		f = keccak_impl->p1600_x4;
+	} else {
+		width = 1;
+		f = keccak_impl->p1600;
+	}
+
+	for (size_t w = 0; w < n; w += BATCH_WINDOW) {
+		struct batch m[BATCH_WINDOW];
+		size_t count = n - w < BATCH_WINDOW ? n - w : BATCH_WINDOW;
+
+		/*
+		 * Insertion sort by block count. The window is small and in
+		 * practice it's often sorted already.
+		 */
+		for (size_t i = 0; i < count; i++) {
+			size_t len = lens[w + i];
+			struct batch x = {
+				.p = bufs[w + i],
+				.len = len,
+				.blocks = (len + s->slen + off) / s->rate + 1,
+				.md = md + (w + i) * s->size,
+			};
+
+			size_t k = i;
+			for (; width > 1 && k && m[k - 1].blocks > x.blocks; k--)
+				m[k] = m[k - 1];
+			m[k] = x;
+		}
+
+		for (size_t i = 0; i < count; i += width) {
+			size_t c = count - i < width ? count - i : width;
+			batch_hash(&m[i], c, width, f, s);
+		}
+	}
+}
+
+void keccak_hash_many(size_t rate, uint8_t ds, size_t nr, size_t size,
+                      const void *const *bufs, const size_t *lens, size_t n,
+                      void *out)
+{
+	struct sponge s = {
+		.rate = rate,
+		.ds = ds,
+		.nr = nr,
+		.size = size,
+	};
+
+	hash_many(&s, bufs, lens, n, out);
+}
+
+void keccak_hash_many_from(const struct sha3_ctx *mid, const void *sfx,
+                           size_t slen, size_t size, const void *const *bufs,
+                           const size_t *lens, size_t n, void *out)
+{
+	struct sponge s = {
+		.mid = mid,
+		.sfx = sfx,
+		.slen = slen,
+		.rate = mid->rate,
+		.ds = mid->ds,
+		.nr = mid->rounds,
+		.size = size,
+	};
+
+	hash_many(&s, bufs, lens, n, out);
+}
+
+void sha3_hash_many(enum sha3_algo algo, const void *const *bufs,
+                    const size_t *lens, size_t n, void *out)
+{
+	keccak_hash_many(200 - 2 * algo, 0x06, 24, algo, bufs, lens, n, out);
+}
+
+void sha3_hash_many_from(const struct sha3_ctx *mid, const void *const *bufs,
+                         const size_t *lens, size_t n, void *out)
+{
+	keccak_hash_many_from(mid, NULL, 0, mid->size, bufs, lens, n, out);
+}
@@ -0,0 +1,253 @@
+/* SPDX-License-Identifier: 0BSD
+ *
+ * Copyright © 2022 Alex Minghella <a@minghella.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Deterministic random bit generators built on the SHAKE squeeze.
+ *
+ * A generator is just a SHAKE context that has been finalised, so its output
+ * is the SHAKE output for its seed. Whole blocks are written straight out of
+ * the state into the caller's buffer, a lane at a time, and the whole rate of
+ * every permutation is used for output.
+ *
+ * The eight-way generator keeps eight streams interleaved, as the eight-way
+ * SHA-3 contexts do, so that each permutation of all of them is a single call
+ * to the multi-buffer kernels. Its output order is fixed in terms of whole
+ * blocks of each stream, so it's the same whichever kernels are in use.
+ */
+
+#include "sha3.h"
+#include "keccak.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+void sha3_rng_seed(struct sha3_rng *rng, enum shake_algo algo,
+                   const void *seed, size_t len)
+{
+	shake_init(&rng->ctx, algo);
+	sha3_update(&rng->ctx, seed, len);
+	shake_final(&rng->ctx);
+}
+
+void sha3_rng_reseed(struct sha3_rng *rng, const void *seed, size_t len)
+{
+	struct sha3_ctx *ctx = &rng->ctx;
+
+	keccak_impl->p1600(ctx->u64, ctx->rounds);
+	ctx->index = 0;
+	sha3_update(ctx, seed, len);
+	keccak_pad(ctx, ctx->ds);
+}
+
+void sha3_rng_fill(struct sha3_rng *rng, void *buf, size_t len)
+{
+	struct sha3_ctx *ctx = &rng->ctx;
+	uint8_t *q = buf;
+
+	/* Finish off the current block. */
+	if (ctx->index != ctx->rate) {
+		size_t n = ctx->rate - ctx->index;
+		if (n > len)
+			n = len;
+
+		shake_squeeze(ctx, q, n);
+		q += n;
+		len -= n;
+	}
+
+	/*
+	 * The current block is now used up, so each whole block can be written
+	 * directly after permuting the state. The SHAKE rates are whole numbers
+	 * of lanes.
+	 */
+	while (len >= ctx->rate) {
+		keccak_impl->p1600(ctx->u64, ctx->rounds);
+
+		for (size_t i = 0; i < ctx->rate / 8; i++)
+			store64le(q + 8 * i, ctx->u64[i]);
+
+		q += ctx->rate;
+		len -= ctx->rate;
+	}
+
+	if (len)
+		shake_squeeze(ctx, q, len);
+}
+
+/**
+ * read_entropy - Fill a buffer from the system's entropy source.
+ *
+ * @buf: Pointer to the buffer.
+ * @len: Number of bytes to read.
+ *
+ * @return: Zero on success, or -1 on error with errno set.
+ */
+static int read_entropy(void *buf, size_t len)
+{
+	uint8_t *p = buf;
+
+	int fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -1;
+
+	while (len) {
+		ssize_t n = read(fd, p, len);
+		if (n < 0 && errno == EINTR)
+			continue;
+
+		if (n <= 0) {
+			int err = n ? errno : EIO;
+			close(fd);
+			errno = err;
+			return -1;
+		}
+
+		p += n;
+		len -= n;
+	}
+
+	close(fd);
+	return 0;
+}
+
+static KECCAK_TLS struct sha3_rng local_rng;
+static KECCAK_TLS bool local_seeded;
+static pthread_once_t local_once = PTHREAD_ONCE_INIT;
+
+/*
+ * A forked child starts with a copy of the parent's generator, so it has to
+ * be seeded again or the two would produce the same output. Only the thread
+ * that called fork() exists in the child, so it's the only one to reset.
+ */
+static void local_atfork_child(void)
+{
+	local_seeded = false;
+}
+
+static void local_register(void)
+{
+	pthread_atfork(NULL, NULL, local_atfork_child);
+}
+
+struct sha3_rng *sha3_rng_local(void)
+{
+	if (local_seeded)
+		return &local_rng;
+
+	pthread_once(&local_once, local_register);
+
+	uint8_t seed[32];
+	if (read_entropy(seed, sizeof(seed)))
+		return NULL;
+
+	sha3_rng_seed(&local_rng, SHAKE128, seed, sizeof(seed));
+	local_seeded = true;
+
+	/* Keep the compiler from dropping the clear of a dead buffer. */
+	memset(seed, 0, sizeof(seed));
+	__asm__ volatile("" : : "r"(seed) : "memory");
+	return &local_rng;
+}
+
+void sha3_rng_seed_x8(struct sha3_rng_x8 *rng, enum shake_algo algo,
+                      const void *seed, size_t len)
+{
+	struct sha3_ctx ctx;
+
+	for (uint8_t j = 0; j < 8; j++) {
+		shake_init(&ctx, algo);
+		sha3_update(&ctx, seed, len);
+		sha3_update(&ctx, &j, 1);
+		shake_final(&ctx);
+
+		for (size_t i = 0; i < 25; i++)
+			rng->u64[8 * i + j] = ctx.u64[i];
+	}
+
+	rng->index = 0;
+	rng->rate = ctx.rate;
+}
+
+void sha3_rng_reseed_x8(struct sha3_rng_x8 *rng, const void *seed,
+                        size_t len)
+{
+	struct sha3_ctx ctx = {
+		.rate = rng->rate,
+		.rounds = 24,
+		.ds = 0x1f,
+	};
+
+	keccak_impl->p1600_x8(rng->u64, 24);
+	KECCAK_STAT(permutations, 8);
+
+	for (uint8_t j = 0; j < 8; j++) {
+		for (size_t i = 0; i < 25; i++)
+			ctx.u64[i] = rng->u64[8 * i + j];
+
+		ctx.index = 0;
+		sha3_update(&ctx, seed, len);
+		sha3_update(&ctx, &j, 1);
+		keccak_pad(&ctx, ctx.ds);
+
+		for (size_t i = 0; i < 25; i++)
+			rng->u64[8 * i + j] = ctx.u64[i];
+	}
+
+	rng->index = 0;
+}
+
+void sha3_rng_fill_x8(struct sha3_rng_x8 *rng, void *buf, size_t len)
+{
+	const size_t rate = rng->rate, group = 8 * rate;
+	uint8_t *q = buf;
+
+	while (len) {
+		if (rng->index == group) {
+			keccak_impl->p1600_x8(rng->u64, 24);
+			KECCAK_STAT(permutations, 8);
+			rng->index = 0;
+		}
+
+		/* Whole groups of blocks go straight out of the lanes. */
+		if (!rng->index && len >= group) {
+			for (size_t j = 0; j < 8; j++) {
+				for (size_t i = 0; i < rate / 8; i++)
+					store64le(q + 8 * i, rng->u64[8 * i + j]);
+				q += rate;
+			}
+
+			len -= group;
+			rng->index = group;
+			continue;
+		}
+
+		/* Otherwise, up to the end of the current stream's block. */
+		size_t j = rng->index / rate, off = rng->index % rate;
+		size_t n = rate - off;
+		if (n > len)
+			n = len;
+
+		for (size_t k = off; k < off + n; k++)
+			*q++ = rng->u64[8 * (k / 8) + j] >> 8 * (k % 8);
+
+		rng->index += n;
+		len -= n;
+	}
+}
@@ -0,0 +1,91 @@
+/* SPDX-License-Identifier: 0BSD
+ *
+ * Copyright © 2022 Alex Minghella <a@minghella.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * The permutation and a general sponge, for building other Keccak-based
+ * constructions on the same kernels as the rest of the library.
+ *
+ * A sponge is a struct sha3_ctx with caller-chosen parameters, so absorbing
+ * goes through sha3_update() and its block absorb kernels, and padding and
+ * squeezing through keccak_pad() and shake_squeeze(). All that's added is a
+ * flag recording which phase the sponge is in.
+ */
+
+#include "sha3.h"
+#include "keccak.h"
+
+#include <errno.h>
+#include <string.h>
+
+void keccak_p1600(uint64_t state[25], unsigned nrounds)
+{
+	keccak_impl->p1600(state, nrounds);
+}
+
+int keccak_sponge_init(struct keccak_sponge *s, size_t rate, uint8_t ds,
+                       unsigned nrounds)
+{
+	if (!rate || rate > 192 || rate % 8 || !ds || ds > 0x7f || !nrounds
+	    || nrounds > 24) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	s->ctx.index = 0;
+	s->ctx.rate = rate;
+	s->ctx.size = 0;
+	s->ctx.rounds = nrounds;
+	s->ctx.ds = ds;
+	memset(s->ctx.u8, 0, 200);
+	s->squeezing = 0;
+	return 0;
+}
+
+void keccak_sponge_absorb(struct keccak_sponge *s, const void *buf,
+                          size_t len)
+{
+	if (s->squeezing) {
+		keccak_impl->p1600(s->ctx.u64, s->ctx.rounds);
+		s->ctx.index = 0;
+		s->squeezing = 0;
+	}
+
+	sha3_update(&s->ctx, buf, len);
+}
+
+void keccak_sponge_squeeze(struct keccak_sponge *s, void *out, size_t len)
+{
+	if (!s->squeezing) {
+		keccak_pad(&s->ctx, s->ctx.ds);
+		s->squeezing = 1;
+	}
+
+	shake_squeeze(&s->ctx, out, len);
+}
+
+void keccak_duplex(struct keccak_sponge *s, const void *in, size_t inlen,
+                   void *out, size_t outlen)
+{
+	/*
+	 * The input is shorter than the rate, so sha3_update() never permutes,
+	 * and shake_squeeze() only permutes once a whole block has been read,
+	 * which @outlen never reaches.
+	 */
+	sha3_update(&s->ctx, in, inlen);
+	keccak_pad(&s->ctx, s->ctx.ds);
+	shake_squeeze(&s->ctx, out, outlen);
+	s->ctx.index = 0;
+}
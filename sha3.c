@@ -24,56 +24,38 @@
  */
 
 #include "sha3.h"
+#include "keccak.h"
 
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
-
-/**
- * rotl64 - Rotate bits in a 64-bit integer left.
- *
- * @x: 64-bit unsigned integer.
- * @n: Number of steps to rotate bits.
- *
- * @return: @x with bits rotated @n steps left.
- */
-static inline uint64_t rotl64(uint64_t x, size_t n)
-{
-	return (x << n) | (x >> (64 - n));
-}
+#include <sys/uio.h>
 
 /*
- * GCC, Clang, and ICC manage to transform these into byteswap instructions on
- * instruction sets that have them.
+ * The round constants can be pre-calculated following Algorithms 5 and 6 from
+ * FIPS 202. [1]
  */
-#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
-static inline uint32_t bswap32(uint32_t x)
-{
-	return x >> 24 | ((x >> 8) & 0xff00) | ((x << 8) & 0xff0000) | x << 24;
-}
-
-static inline uint64_t bswap64(uint64_t x)
-{
-	return (bswap32(x) + 0ULL) << 32 | bswap32(x >> 32);
-}
-
-static inline uint64_t read64le(const uint64_t *p)
-{
-	return bswap64(*p);
-}
-#elif __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
-static inline uint64_t read64le(const uint64_t *p)
-{
-	return *p;
-}
-#else
-	#error Unknown endianness.
-#endif
+const uint64_t keccak_rc[24] = {
+	0x0000000000000001ULL, 0x0000000000008082ULL,
+	0x800000000000808aULL, 0x8000000080008000ULL,
+	0x000000000000808bULL, 0x0000000080000001ULL,
+	0x8000000080008081ULL, 0x8000000000008009ULL,
+	0x000000000000008aULL, 0x0000000000000088ULL,
+	0x0000000080008009ULL, 0x000000008000000aULL,
+	0x000000008000808bULL, 0x800000000000008bULL,
+	0x8000000000008089ULL, 0x8000000000008003ULL,
+	0x8000000000008002ULL, 0x8000000000000080ULL,
+	0x000000000000800aULL, 0x800000008000000aULL,
+	0x8000000080008081ULL, 0x8000000000008080ULL,
+	0x0000000080000001ULL, 0x8000000080008008ULL
+};
 
 /**
- * keccakf_1600 - KECCAK-f[1600] permutation function.
+ * keccakp_1600 - KECCAK-p[1600, nr] permutation function.
  *
- * @A: Keccak internal state.
+ * @A:  Keccak internal state.
+ * @nr: Number of rounds, at most 24. KECCAK-p[1600, nr] is the last @nr rounds
+ *      of KECCAK-f[1600], so KECCAK-f[1600] is KECCAK-p[1600, 24].
  *
  * @return: None.
  *
@@ -81,28 +63,20 @@ static inline uint64_t read64le(const uint64_t *p)
  * that it will always perform worse the unrolled version. It's kept here
  * because it might be easier to follow when comparing to the specification as
  * the steps are actually distinct.
+ *
+ * The body is always inlined so that the fixed-rate absorb loops below can
+ * keep the state in registers across blocks. keccakp_1600() is the
+ * out-of-line copy used everywhere else.
  */
-static void keccakf_1600(uint64_t A[25])
+static inline __attribute__((always_inline))
+void keccakp_1600_inline(uint64_t A[25], size_t nr)
 #if defined(SHA3_KECCAKF_LOOP)
 {
 	/*
-	 * The round constants can be pre-calculated following Algorithms 5 and
-	 * 6 from FIPS 202. [1]
+	 * The round constants are shared with the other implementations,
+	 * see keccak_rc.
 	 */
-	static const uint64_t RC[24] = {
-		0x0000000000000001ULL, 0x0000000000008082ULL,
-		0x800000000000808aULL, 0x8000000080008000ULL,
-		0x000000000000808bULL, 0x0000000080000001ULL,
-		0x8000000080008081ULL, 0x8000000000008009ULL,
-		0x000000000000008aULL, 0x0000000000000088ULL,
-		0x0000000080008009ULL, 0x000000008000000aULL,
-		0x000000008000808bULL, 0x800000000000008bULL,
-		0x8000000000008089ULL, 0x8000000000008003ULL,
-		0x8000000000008002ULL, 0x8000000000000080ULL,
-		0x000000000000800aULL, 0x800000008000000aULL,
-		0x8000000080008081ULL, 0x8000000000008080ULL,
-		0x0000000080000001ULL, 0x8000000080008008ULL
-	};
+	const uint64_t *RC = keccak_rc;
 
 	/*
 	 * The ρ offsets come from Table 2 of FIPS 202 [1]. Each offset is
@@ -155,7 +129,7 @@ static void keccakf_1600(uint64_t A[25])
 		3, 18, 17, 11,  7, 10
 	};
 
-	for (uint8_t i_r = 0; i_r < 24; i_r++) {
+	for (uint8_t i_r = 24 - nr; i_r < 24; i_r++) {
 		/*
 		 * θ(A)
 		 */
@@ -215,22 +189,9 @@ static void keccakf_1600(uint64_t A[25])
 }
 #else
 {
-	static const uint64_t RC[24] = {
-		0x0000000000000001ULL, 0x0000000000008082ULL,
-		0x800000000000808aULL, 0x8000000080008000ULL,
-		0x000000000000808bULL, 0x0000000080000001ULL,
-		0x8000000080008081ULL, 0x8000000000008009ULL,
-		0x000000000000008aULL, 0x0000000000000088ULL,
-		0x0000000080008009ULL, 0x000000008000000aULL,
-		0x000000008000808bULL, 0x800000000000008bULL,
-		0x8000000000008089ULL, 0x8000000000008003ULL,
-		0x8000000000008002ULL, 0x8000000000000080ULL,
-		0x000000000000800aULL, 0x800000008000000aULL,
-		0x8000000080008081ULL, 0x8000000000008080ULL,
-		0x0000000080000001ULL, 0x8000000080008008ULL
-	};
+	const uint64_t *RC = keccak_rc;
 
-	for (size_t i_r = 0; i_r < 24; i_r++) {
+	for (size_t i_r = 24 - nr; i_r < 24; i_r++) {
 		uint64_t parity[5];
 		parity[0] = A[0] ^ A[5] ^ A[10] ^ A[15] ^ A[20];
 		parity[1] = A[1] ^ A[6] ^ A[11] ^ A[16] ^ A[21];
@@ -339,87 +300,286 @@ static void keccakf_1600(uint64_t A[25])
 }
 #endif
 
+void keccakp_1600(uint64_t A[25], size_t nr)
+{
+	keccakp_1600_inline(A, nr);
+}
+
+/**
+ * next64le - Read a little-endian lane of input and advance past it.
+ *
+ * @p: Pointer to a pointer to 8 bytes of input. Need not be aligned.
+ *
+ * @return: The 64-bit integer at *@p.
+ *
+ * The load goes through memcpy() in load64le(), which compiles to a single
+ * unaligned load wherever the target has one.
+ */
+static inline uint64_t next64le(const uint8_t **p)
+{
+	uint64_t x = load64le(*p);
+	*p += 8;
+	return x;
+}
+
+/**
+ * keccak_absorb_rate - Absorb whole blocks with a fixed rate.
+ *
+ * @A:    Keccak internal state.
+ * @buf:  Pointer to input data. There are no alignment requirements.
+ * @len:  Length, in bytes, of the input data.
+ * @rate: Padding rate in bytes. Must be a compile-time constant.
+ * @nr:   Number of rounds, as keccakp_1600().
+ *
+ * @return: As keccak_absorb().
+ *
+ * With a constant @rate the XOR of each block is fully unrolled, and since the
+ * state is copied to a local array the compiler is free to keep it in
+ * registers from one block to the next rather than reloading it from @A.
+ */
+static inline __attribute__((always_inline))
+size_t keccak_absorb_rate(uint64_t A[25], const void *buf, size_t len,
+                          size_t rate, size_t nr)
+{
+	const uint8_t *p = buf;
+	uint64_t S[25];
+	size_t n = 0;
+
+	if (len < rate)
+		return 0;
+
+	memcpy(S, A, sizeof(S));
+
+	for (; len - n >= rate; n += rate) {
+		for (size_t i = 0; i < rate / 8; i++)
+			S[i] ^= next64le(&p);
+
+		keccakp_1600_inline(S, nr);
+	}
+
+	memcpy(A, S, sizeof(S));
+	return n;
+}
+
+#define KECCAK_ABSORB_RATE(rate) \
+	static size_t keccak_absorb_##rate(uint64_t A[25], const void *buf, \
+	                                   size_t len, size_t nr) \
+	{ \
+		return keccak_absorb_rate(A, buf, len, rate, nr); \
+	}
+
+KECCAK_ABSORB_RATE(72)
+KECCAK_ABSORB_RATE(104)
+KECCAK_ABSORB_RATE(136)
+KECCAK_ABSORB_RATE(144)
+KECCAK_ABSORB_RATE(168)
+
+size_t keccak_absorb_generic(uint64_t A[25], const void *buf, size_t len,
+                             size_t rate, size_t nr)
+{
+	switch (rate) {
+	case 200 - 2 * SHA3_512:
+		return keccak_absorb_72(A, buf, len, nr);
+	case 200 - 2 * SHA3_384:
+		return keccak_absorb_104(A, buf, len, nr);
+	case 200 - 2 * SHA3_256:
+		return keccak_absorb_136(A, buf, len, nr);
+	case 200 - 2 * SHA3_224:
+		return keccak_absorb_144(A, buf, len, nr);
+	case 200 - 2 * SHAKE128:
+		return keccak_absorb_168(A, buf, len, nr);
+	default:
+		return keccak_absorb(A, buf, len, rate, nr);
+	}
+}
+
+size_t keccak_absorb(uint64_t A[25], const void *buf, size_t len, size_t rate,
+                     size_t nr)
+{
+	const uint8_t *p = buf;
+	size_t n = 0;
+
+	for (; len - n >= rate; n += rate) {
+		uint8_t i = 0;
+		switch (rate) {
+		case 200 - 2 * SHA3_224:
+			A[i++] ^= next64le(&p);
+			/* Fallthrough */
+		case 200 - 2 * SHA3_256:
+			A[i++] ^= next64le(&p);
+			A[i++] ^= next64le(&p);
+			A[i++] ^= next64le(&p);
+			A[i++] ^= next64le(&p);
+			/* Fallthrough */
+		case 200 - 2 * SHA3_384:
+			A[i++] ^= next64le(&p);
+			A[i++] ^= next64le(&p);
+			A[i++] ^= next64le(&p);
+			A[i++] ^= next64le(&p);
+			/* Fallthrough */
+		case 200 - 2 * SHA3_512:
+			A[i++] ^= next64le(&p);
+			A[i++] ^= next64le(&p);
+			A[i++] ^= next64le(&p);
+			A[i++] ^= next64le(&p);
+			A[i++] ^= next64le(&p);
+			A[i++] ^= next64le(&p);
+			A[i++] ^= next64le(&p);
+			A[i++] ^= next64le(&p);
+			A[i++] ^= next64le(&p);
+			break;
+		default:
+			while (i < rate / 8)
+				A[i++] ^= next64le(&p);
+		}
+
+		keccak_kernels->p1600(A, nr);
+	}
+
+	return n;
+}
+
 void sha3_init(struct sha3_ctx *ctx, enum sha3_algo algo)
 {
 	ctx->index = 0;
 	ctx->rate = 200 - 2 * algo;
 	ctx->size = algo;
+	ctx->rounds = 24;
+	ctx->ds = 0x06;
 	memset(ctx->u8, 0, 200);
 }
 
+/**
+ * absorb_byte - XOR one byte of input into the state at the current index.
+ *
+ * @ctx: Pointer to an initialised SHA-3 context structure.
+ * @b:   Input byte.
+ *
+ * @return: None.
+ */
+static inline void absorb_byte(struct sha3_ctx *ctx, uint8_t b)
+{
+	ctx->u8[keccak_u8(ctx->index++)] ^= b;
+
+	if (ctx->index == ctx->rate) {
+		ctx->index = 0;
+		keccak_impl->p1600(ctx->u64, ctx->rounds);
+	}
+}
+
 void sha3_update(struct sha3_ctx *ctx, const void *buf, size_t len)
 {
-	if (!((uintptr_t)buf & 7) && !(ctx->index & 7)) {
-		const uint64_t *p = buf;
-
-		if (!ctx->index) {
-			uint8_t i = 0;
-			while (len >= ctx->rate) {
-				switch (ctx->size) {
-				case SHA3_224:
-					ctx->u64[i++] ^= read64le(p++);
-					/* Fallthrough */
-				case SHA3_256:
-					ctx->u64[i++] ^= read64le(p++);
-					ctx->u64[i++] ^= read64le(p++);
-					ctx->u64[i++] ^= read64le(p++);
-					ctx->u64[i++] ^= read64le(p++);
-					/* Fallthrough */
-				case SHA3_384:
-					ctx->u64[i++] ^= read64le(p++);
-					ctx->u64[i++] ^= read64le(p++);
-					ctx->u64[i++] ^= read64le(p++);
-					ctx->u64[i++] ^= read64le(p++);
-					/* Fallthrough */
-				case SHA3_512:
-					ctx->u64[i++] ^= read64le(p++);
-					ctx->u64[i++] ^= read64le(p++);
-					ctx->u64[i++] ^= read64le(p++);
-					ctx->u64[i++] ^= read64le(p++);
-					ctx->u64[i++] ^= read64le(p++);
-					ctx->u64[i++] ^= read64le(p++);
-					ctx->u64[i++] ^= read64le(p++);
-					ctx->u64[i++] ^= read64le(p++);
-					ctx->u64[i++] ^= read64le(p++);
-				}
-
-				len -= ctx->rate;
-				i = 0;
-				keccakf_1600(ctx->u64);
+	const uint8_t *p = buf;
+
+	KECCAK_PROBE2(update, ctx, len);
+
+	/*
+	 * Input is absorbed a lane at a time wherever it happens to be in
+	 * memory, so only the bytes needed to reach the next lane boundary in
+	 * the state, and those left over at the end, are done one at a time.
+	 */
+	while (len && (ctx->index & 7)) {
+		absorb_byte(ctx, *p++);
+		len--;
+		KECCAK_STAT(byte_bytes, 1);
+	}
+
+	if (!ctx->index) {
+		size_t n = keccak_impl->absorb(ctx->u64, p, len, ctx->rate,
+		                               ctx->rounds);
+		p += n;
+		len -= n;
+		KECCAK_STAT(block_bytes, n);
+	}
+
+	KECCAK_STAT(lane_bytes, len & ~(size_t)7);
+	KECCAK_STAT(byte_bytes, len & 7);
+
+	while (len > 7) {
+		ctx->u64[ctx->index / 8] ^= next64le(&p);
+		ctx->index += 8;
+		len -= 8;
+
+		if (ctx->index == ctx->rate) {
+			ctx->index = 0;
+			keccak_impl->p1600(ctx->u64, ctx->rounds);
+		}
+	}
+
+	while (len--)
+		absorb_byte(ctx, *p++);
+}
+
+void sha3_updatev(struct sha3_ctx *ctx, const struct iovec *iov, int iovcnt)
+{
+	size_t index = ctx->index;
+	uint64_t lane = 0;
+
+	KECCAK_PROBE2(updatev, ctx, iovcnt);
+
+	/*
+	 * Bytes that don't make up a whole lane of a buffer are collected in
+	 * @lane, at the position they take in the state lane at @index, and
+	 * XORed in once the lane is complete. A lane can gather bytes from any
+	 * number of buffers.
+	 */
+	for (int i = 0; i < iovcnt; i++) {
+		const uint8_t *p = iov[i].iov_base;
+		size_t len = iov[i].iov_len;
+
+		while (len && (index & 7)) {
+			lane |= (uint64_t)*p++ << 8 * (index++ & 7);
+			len--;
+			KECCAK_STAT(byte_bytes, 1);
+
+			if (index & 7)
+				continue;
+
+			ctx->u64[index / 8 - 1] ^= lane;
+			lane = 0;
+
+			if (index == ctx->rate) {
+				index = 0;
+				keccak_impl->p1600(ctx->u64, ctx->rounds);
 			}
 		}
 
+		if (!len)
+			continue;
+
+		if (!index) {
+			size_t n = keccak_impl->absorb(ctx->u64, p, len,
+			                               ctx->rate, ctx->rounds);
+			p += n;
+			len -= n;
+			KECCAK_STAT(block_bytes, n);
+		}
+
+		KECCAK_STAT(lane_bytes, len & ~(size_t)7);
+		KECCAK_STAT(byte_bytes, len & 7);
+
 		while (len > 7) {
-			ctx->u64[ctx->index / 8] ^= read64le(p++);
-			ctx->index += 8;
+			ctx->u64[index / 8] ^= next64le(&p);
+			index += 8;
 			len -= 8;
 
-			if (ctx->index == ctx->rate) {
-				ctx->index = 0;
-				keccakf_1600(ctx->u64);
+			if (index == ctx->rate) {
+				index = 0;
+				keccak_impl->p1600(ctx->u64, ctx->rounds);
 			}
 		}
 
-		buf = p;
+		while (len--)
+			lane |= (uint64_t)*p++ << 8 * (index++ & 7);
 	}
 
-	const uint8_t *q = buf;
-	while (len--) {
-#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
-		uint8_t i = ctx->index++;
-		ctx->u8[(i / 8) + (7 - i % 8)] ^= *q++;
-#elif __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
-		ctx->u8[ctx->index++] ^= *q++;
-#endif
+	if (index & 7)
+		ctx->u64[index / 8] ^= lane;
 
-		if (ctx->index == ctx->rate) {
-			ctx->index = 0;
-			keccakf_1600(ctx->u64);
-		}
-	}
+	ctx->index = index;
 }
 
-void sha3_final(struct sha3_ctx *ctx, void *md)
+void keccak_pad(struct sha3_ctx *ctx, uint8_t ds)
 {
 	/*
 	 * The SHA-3 functions are defined in terms of the KECCAK[c] sponge
@@ -445,16 +605,280 @@ void sha3_final(struct sha3_ctx *ctx, void *md)
 	 *
 	 * where r is the padding rate and i is the least-significant bit of
 	 * the byte at the current input position.
+	 *
+	 * Other functions built on KECCAK[c] only differ in the suffix, so @ds
+	 * holds the suffix bits followed by the first bit of padding: 0x06
+	 * (0b00000110) for SHA-3, 0x1f (0b00011111) for SHAKE, and so on.
 	 */
-	ctx->u8[ctx->index] ^= 0x06;    /* 0b00000110 */
-	ctx->u8[ctx->rate - 1] ^= 0x80; /* 0b10000000 */
+	ctx->u8[keccak_u8(ctx->index)] ^= ds;
+	ctx->u8[keccak_u8(ctx->rate - 1)] ^= 0x80; /* 0b10000000 */
 
 	/*
 	 * We have now completed our final block of input, so apply the
 	 * permutation function once more.
 	 */
-	keccakf_1600(ctx->u64);
+	keccak_impl->p1600(ctx->u64, ctx->rounds);
+	ctx->index = 0;
+	KECCAK_STAT(finals, 1);
+}
+
+/**
+ * extract - Copy bytes out of the state.
+ *
+ * @A:   Keccak internal state.
+ * @off: Byte index in the state of the first byte to copy.
+ * @out: Output buffer.
+ * @len: Number of bytes to copy.
+ *
+ * @return: None.
+ *
+ * On a big-endian host the bytes of each lane have to be reversed on the way
+ * out, which is done a whole lane at a time with store64le().
+ */
+static inline void extract(const uint64_t A[25], size_t off, void *out,
+                           size_t len)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	uint8_t *q = out;
+
+	for (; len && off % 8; len--, off++)
+		*q++ = A[off / 8] >> 8 * (off % 8);
+
+	for (; len >= 8; len -= 8, off += 8, q += 8)
+		store64le(q, A[off / 8]);
+
+	for (; len; len--, off++)
+		*q++ = A[off / 8] >> 8 * (off % 8);
+#elif __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	memcpy(out, (const uint8_t *)A + off, len);
+#endif
+}
+
+void sha3_final(struct sha3_ctx *ctx, void *md)
+{
+	KECCAK_PROBE2(final, ctx, ctx->rate);
+
+	keccak_pad(ctx, ctx->ds);
+
+	extract(ctx->u64, 0, md, ctx->size);
+	memset(ctx->u8, 0, 200);
+}
+
+/**
+ * sha3_store - Write the digest from the final state.
+ *
+ * @A:    Keccak internal state.
+ * @md:   Pointer to the buffer in which the digest will be written.
+ * @algo: Size of the digest in bytes. Must be a compile-time constant.
+ *
+ * @return: None.
+ *
+ * Only the lanes making up the digest are stored.
+ */
+static inline __attribute__((always_inline))
+void sha3_store(const uint64_t A[25], uint8_t *md, enum sha3_algo algo)
+{
+	for (size_t i = 0; i < algo / 8; i++)
+		store64le(md + 8 * i, A[i]);
+
+	if (algo % 8) {
+		uint8_t lane[8];
+		store64le(lane, A[algo / 8]);
+		memcpy(md + algo / 8 * 8, lane, algo % 8);
+	}
+}
+
+/**
+ * sha3_oneshot - Compute a SHA-3 digest with the algorithm known in advance.
+ *
+ * @buf:  Pointer to input data.
+ * @len:  Length, in bytes, of the input data.
+ * @md:   Pointer to the buffer in which the digest will be written.
+ * @algo: Size of the digest in bytes. Must be a compile-time constant.
+ *
+ * @return: None.
+ *
+ * This is sha3_init(), sha3_update(), and sha3_final() with the bookkeeping of
+ * a context removed. The rate is a constant, so the padding of the last block
+ * is unrolled, and the final state is left on the stack rather than cleared.
+ */
+static inline __attribute__((always_inline))
+void sha3_oneshot(const void *buf, size_t len, void *md, enum sha3_algo algo)
+{
+	const size_t rate = 200 - 2 * algo;
+	const uint8_t *p = buf;
+	uint8_t *q = md;
+	uint64_t A[25] = { 0 };
+
+	size_t n = keccak_impl->absorb(A, p, len, rate, 24);
+	p += n;
+	len -= n;
+
+	keccak_last_block(A, 1, p, len, rate, 0x06, false);
+	keccak_impl->p1600(A, 24);
+	sha3_store(A, q, algo);
+}
+
+/**
+ * sha3_short - Compute a SHA-3 digest of less than one block of input.
+ *
+ * @buf:  Pointer to input data.
+ * @len:  Length, in bytes, of the input data. Less than the rate.
+ * @md:   Pointer to the buffer in which the digest will be written.
+ * @algo: Size of the digest in bytes. Must be a compile-time constant.
+ *
+ * @return: None.
+ *
+ * The state is built directly from the padded input, so it's never cleared,
+ * and the only call made is the one permutation.
+ */
+static inline __attribute__((always_inline))
+void sha3_short(const void *buf, size_t len, void *md, enum sha3_algo algo)
+{
+	uint64_t A[25];
+
+	keccak_last_block(A, 1, buf, len, 200 - 2 * algo, 0x06, true);
+	keccak_impl->p1600(A, 24);
+	sha3_store(A, md, algo);
+}
+
+void sha3_224(const void *buf, size_t len, void *md)
+{
+	sha3_oneshot(buf, len, md, SHA3_224);
+}
+
+void sha3_256(const void *buf, size_t len, void *md)
+{
+	sha3_oneshot(buf, len, md, SHA3_256);
+}
+
+void sha3_384(const void *buf, size_t len, void *md)
+{
+	sha3_oneshot(buf, len, md, SHA3_384);
+}
+
+void sha3_512(const void *buf, size_t len, void *md)
+{
+	sha3_oneshot(buf, len, md, SHA3_512);
+}
+
+/*
+ * Inputs of a whole block or more are handed to the general one-shot
+ * functions, so the short entry points are always safe to call.
+ */
+void sha3_224_short(const void *buf, size_t len, void *md)
+{
+	if (len < 200 - 2 * SHA3_224)
+		sha3_short(buf, len, md, SHA3_224);
+	else
+		sha3_oneshot(buf, len, md, SHA3_224);
+}
+
+void sha3_256_short(const void *buf, size_t len, void *md)
+{
+	if (len < 200 - 2 * SHA3_256)
+		sha3_short(buf, len, md, SHA3_256);
+	else
+		sha3_oneshot(buf, len, md, SHA3_256);
+}
+
+void sha3_384_short(const void *buf, size_t len, void *md)
+{
+	if (len < 200 - 2 * SHA3_384)
+		sha3_short(buf, len, md, SHA3_384);
+	else
+		sha3_oneshot(buf, len, md, SHA3_384);
+}
+
+void sha3_512_short(const void *buf, size_t len, void *md)
+{
+	if (len < 200 - 2 * SHA3_512)
+		sha3_short(buf, len, md, SHA3_512);
+	else
+		sha3_oneshot(buf, len, md, SHA3_512);
+}
+
+void sha3_ctx_clone(struct sha3_ctx *dst, const struct sha3_ctx *src)
+{
+	memcpy(dst, src, sizeof(*dst));
+}
+
+#define EXPORT_VERSION 1
+
+void sha3_export(const struct sha3_ctx *ctx, void *buf)
+{
+	uint8_t *q = buf;
+
+	q[0] = EXPORT_VERSION;
+	q[1] = ctx->index;
+	q[2] = ctx->rate;
+	q[3] = ctx->size;
+	q[4] = ctx->rounds;
+	q[5] = ctx->ds;
+
+	for (size_t i = 0; i < 25; i++)
+		store64le(q + 6 + 8 * i, ctx->u64[i]);
+}
+
+int sha3_import(struct sha3_ctx *ctx, const void *buf)
+{
+	const uint8_t *p = buf;
+
+	/*
+	 * Every rate in use is a whole number of lanes, so anything else is
+	 * corrupt. The index reaches the rate after squeezing a whole block.
+	 */
+	if (p[0] != EXPORT_VERSION || !p[2] || p[2] >= 200 || p[2] % 8
+	    || p[1] > p[2] || p[3] > p[2] || !p[4] || p[4] > 24)
+		return -1;
+
+	ctx->index = p[1];
+	ctx->rate = p[2];
+	ctx->size = p[3];
+	ctx->rounds = p[4];
+	ctx->ds = p[5];
 
-	memcpy(md, ctx->u8, ctx->size);
+	for (size_t i = 0; i < 25; i++)
+		ctx->u64[i] = load64le(p + 6 + 8 * i);
+
+	return 0;
+}
+
+void shake_init(struct sha3_ctx *ctx, enum shake_algo algo)
+{
+	ctx->index = 0;
+	ctx->rate = 200 - 2 * algo;
+	ctx->size = 0;
+	ctx->rounds = 24;
+	ctx->ds = 0x1f;
 	memset(ctx->u8, 0, 200);
 }
+
+void shake_final(struct sha3_ctx *ctx)
+{
+	KECCAK_PROBE2(final, ctx, ctx->rate);
+
+	keccak_pad(ctx, ctx->ds);
+}
+
+void shake_squeeze(struct sha3_ctx *ctx, void *out, size_t len)
+{
+	uint8_t *q = out;
+
+	while (len) {
+		if (ctx->index == ctx->rate) {
+			keccak_impl->p1600(ctx->u64, ctx->rounds);
+			ctx->index = 0;
+		}
+
+		size_t n = ctx->rate - ctx->index;
+		if (n > len)
+			n = len;
+
+		extract(ctx->u64, ctx->index, q, n);
+
+		ctx->index += n;
+		q += n;
+		len -= n;
+	}
+}
@@ -20,6 +20,23 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * With SHA3_IMPLEMENTATION defined before this header is included, the
+ * functions marked SHA3_INLINE are defined as static inline functions in the
+ * including file, from sha3-inline.h, instead of being called in the library.
+ * This lets the compiler inline them and fold in the algorithm where it's a
+ * constant, which matters most for short messages. See sha3-inline.h.
+ */
+#if defined(SHA3_IMPLEMENTATION)
+	#define SHA3_INLINE static inline
+#else
+	#define SHA3_INLINE
+#endif
+
 /**
  * enum sha3_algo - SHA-3 algorithm selection constants.
  *
@@ -53,19 +70,50 @@ enum sha3_size {
 	SHA3_512_SIZE = 64
 };
 
+/**
+ * enum shake_algo - SHAKE algorithm selection constants.
+ *
+ * @SHAKE128: SHAKE128.
+ * @SHAKE256: SHAKE256.
+ *
+ * The values are the security strengths in bytes. SHAKE has no fixed output
+ * size.
+ */
+enum shake_algo {
+	SHAKE128 = 16,
+	SHAKE256 = 32,
+};
+
+/**
+ * enum k12_algo - KangarooTwelve algorithm selection constants.
+ *
+ * @KT128: KT128, built on TurboSHAKE128.
+ * @KT256: KT256, built on TurboSHAKE256.
+ *
+ * The values are the security strengths in bytes, as enum shake_algo.
+ */
+enum k12_algo {
+	KT128 = 16,
+	KT256 = 32,
+};
+
 /**
  * struct sha3_ctx - SHA-3 context.
  *
- * @index: Byte index in the state that the next input byte will modify.
- * @rate:  Padding rate in bytes. The rate is equal to the difference between
- *         the size of the state and the "capactity" of the algorithm. The
- *         capactity is specified as double the size of digest. SHA3-224, for
- *         example, has a specified capacity of 448 bits, meaning the padding
- *         rate is 1152 bits, or 144 bytes. SHA3-512, similarly, has a padding
- *         rate of 72 bytes.
- * @size:  Digest size in bytes.
- * @u8:    Byte-wise view of the internal state.
- * @u64:   Lane-wise view of the internal state.
+ * @index:  Byte index in the state that the next input byte will modify.
+ * @rate:   Padding rate in bytes. The rate is equal to the difference between
+ *          the size of the state and the "capactity" of the algorithm. The
+ *          capactity is specified as double the size of digest. SHA3-224,
+ *          for example, has a specified capacity of 448 bits, meaning the
+ *          padding rate is 1152 bits, or 144 bytes. SHA3-512, similarly, has
+ *          a padding rate of 72 bytes.
+ * @size:   Digest size in bytes, or zero for SHAKE.
+ * @rounds: Number of rounds of the permutation. This is 24 for everything
+ *          except TurboSHAKE, which uses 12.
+ * @ds:     Domain separation byte appended to the input by sha3_final() and
+ *          shake_final(), as keccak_pad().
+ * @u8:     Byte-wise view of the internal state.
+ * @u64:    Lane-wise view of the internal state.
  *
  * The lanes of the internal state are labelled as follows:
  *
@@ -84,6 +132,8 @@ struct sha3_ctx {
 	uint8_t index;
 	uint8_t rate;
 	uint8_t size;
+	uint8_t rounds;
+	uint8_t ds;
 
 	union {
 		uint8_t  u8[200];
@@ -99,18 +149,40 @@ struct sha3_ctx {
  *
  * @return: None.
  */
-void sha3_init(struct sha3_ctx *ctx, enum sha3_algo algo);
+SHA3_INLINE void sha3_init(struct sha3_ctx *ctx, enum sha3_algo algo);
 
 /**
  * sha3_update - Update a SHA-3 context with input data.
  *
  * @ctx: Pointer to an initialised SHA-3 context structure.
- * @buf: Pointer to input data.
+ * @buf: Pointer to input data. There are no alignment requirements.
  * @len: Length, in bytes, of the input data.
  *
  * @return: None.
  */
-void sha3_update(struct sha3_ctx *ctx, const void *buf, size_t len);
+SHA3_INLINE void sha3_update(struct sha3_ctx *ctx, const void *buf,
+                             size_t len);
+
+/*
+ * struct iovec - Buffer descriptor from <sys/uio.h>.
+ */
+struct iovec;
+
+/**
+ * sha3_updatev - Update a SHA-3 context with input data from several buffers.
+ *
+ * @ctx:    Pointer to an initialised SHA-3 context structure.
+ * @iov:    Array of @iovcnt buffers, as readv(). There are no alignment
+ *          requirements.
+ * @iovcnt: Number of buffers.
+ *
+ * @return: None.
+ *
+ * This is equivalent to calling sha3_update() on each buffer in turn, but the
+ * lanes that straddle buffer boundaries are assembled in a register rather
+ * than absorbed into the state a byte at a time.
+ */
+void sha3_updatev(struct sha3_ctx *ctx, const struct iovec *iov, int iovcnt);
 
 /**
  * sha3_final - Finalise a SHA-3 context and write the digest.
@@ -121,6 +193,1242 @@ void sha3_update(struct sha3_ctx *ctx, const void *buf, size_t len);
  *
  * @return: None.
  */
-void sha3_final(struct sha3_ctx *ctx, void *md);
+SHA3_INLINE void sha3_final(struct sha3_ctx *ctx, void *md);
+
+/**
+ * sha3_ctx_clone - Copy a SHA-3 context.
+ *
+ * @dst: Pointer to the SHA-3 context structure to copy to.
+ * @src: Pointer to an initialised SHA-3 context structure.
+ *
+ * @return: None.
+ *
+ * Both contexts may then be updated and finalised independently. This is how
+ * to reuse a midstate: a context that a common prefix (a salt, a header, a key
+ * block) has been absorbed into and is then cloned for each message instead of
+ * absorbing the prefix again. Any context, including ones initialised with
+ * shake_init() or turboshake_init(), may be cloned.
+ */
+SHA3_INLINE void sha3_ctx_clone(struct sha3_ctx *dst,
+                                const struct sha3_ctx *src);
+
+/*
+ * SHA3_EXPORT_SIZE - Size in bytes of an exported SHA-3 context.
+ */
+#define SHA3_EXPORT_SIZE 206
+
+/**
+ * sha3_export - Serialise a SHA-3 context.
+ *
+ * @ctx: Pointer to an initialised SHA-3 context structure.
+ * @buf: Pointer to a buffer of SHA3_EXPORT_SIZE bytes.
+ *
+ * @return: None.
+ *
+ * The format doesn't depend on the host, so a context may be exported on one
+ * machine and imported on another. It is:
+ *
+ *     Offset  Size  Contents
+ *          0     1  Format version, currently 1.
+ *          1     1  @index
+ *          2     1  @rate
+ *          3     1  @size
+ *          4     1  @rounds
+ *          5     1  @ds
+ *          6   200  The state, lanes in order, each least-significant byte
+ *                   first.
+ *
+ * Like a context, the exported state lets anyone who has it compute the digest
+ * of any extension of the input absorbed so far, and a KMAC context holds the
+ * key in this way, so it should be protected accordingly.
+ */
+void sha3_export(const struct sha3_ctx *ctx, void *buf);
+
+/**
+ * sha3_import - Restore a SHA-3 context serialised with sha3_export().
+ *
+ * @ctx: Pointer to the SHA-3 context structure to restore.
+ * @buf: Pointer to SHA3_EXPORT_SIZE bytes written by sha3_export().
+ *
+ * @return: Zero on success, or -1 if @buf doesn't hold a context in a known
+ *          format, in which case @ctx is not modified.
+ *
+ * The restored context continues exactly where the exported one left off,
+ * whether it was absorbing or squeezing.
+ */
+int sha3_import(struct sha3_ctx *ctx, const void *buf);
+
+/**
+ * sha3_256 - Compute the SHA3-256 digest of a buffer.
+ *
+ * @buf: Pointer to input data. There are no alignment requirements.
+ * @len: Length, in bytes, of the input data.
+ * @md:  Pointer to the buffer in which the 32-byte digest will be written.
+ *
+ * @return: None.
+ *
+ * This is equivalent to sha3_init(), sha3_update(), and sha3_final(), but is
+ * specialised for the rate of SHA3-256 at compile time. Unlike sha3_final(),
+ * the internal state left on the stack is not cleared.
+ *
+ * sha3_224(), sha3_384(), and sha3_512() are the same for the other digest
+ * sizes.
+ */
+SHA3_INLINE void sha3_224(const void *buf, size_t len, void *md);
+SHA3_INLINE void sha3_256(const void *buf, size_t len, void *md);
+SHA3_INLINE void sha3_384(const void *buf, size_t len, void *md);
+SHA3_INLINE void sha3_512(const void *buf, size_t len, void *md);
+
+/**
+ * sha3_256_short - Compute the SHA3-256 digest of less than one block.
+ *
+ * @buf: Pointer to input data. There are no alignment requirements.
+ * @len: Length, in bytes, of the input data. Best less than the rate, 136
+ *       bytes, but longer input is handled by sha3_256().
+ * @md:  Pointer to the buffer in which the 32-byte digest will be written.
+ *
+ * @return: None.
+ *
+ * This builds the padded block directly in the state and applies the
+ * permutation once, for keys, hash table keys, tree nodes, and other inputs
+ * too short for the setup of sha3_256() to be negligible.
+ *
+ * sha3_224_short(), sha3_384_short(), and sha3_512_short() are the same for
+ * the other digest sizes, with rates of 144, 104, and 72 bytes.
+ */
+SHA3_INLINE void sha3_224_short(const void *buf, size_t len, void *md);
+SHA3_INLINE void sha3_256_short(const void *buf, size_t len, void *md);
+SHA3_INLINE void sha3_384_short(const void *buf, size_t len, void *md);
+SHA3_INLINE void sha3_512_short(const void *buf, size_t len, void *md);
+
+/**
+ * sha3_update_fd - Update a SHA-3 context with the rest of a file.
+ *
+ * @ctx: Pointer to an initialised SHA-3 context structure.
+ * @fd:  File descriptor open for reading.
+ *
+ * @return: Zero on success, or -1 on error with errno set. After an error,
+ *          @ctx has absorbed some unknown part of the input.
+ *
+ * Everything from the current file offset to end of file is absorbed, and the
+ * offset is left at end of file. Large regular files are read ahead through
+ * io_uring where the kernel supports it, and are otherwise memory-mapped a
+ * window at a time. Pipes, sockets, and other files that can't be read at an
+ * offset are read ahead by a thread that this call creates and joins before it
+ * returns. Small files are read into a single buffer.
+ *
+ * Only on the memory-mapped path must the file not be truncated while it's
+ * being hashed, or the process will receive SIGBUS.
+ *
+ * Any context may be updated this way, including ones initialised with
+ * shake_init(), cshake_init(), and kmac_init().
+ */
+int sha3_update_fd(struct sha3_ctx *ctx, int fd);
+
+/**
+ * sha3_hash_fd - Compute the SHA-3 digest of the rest of a file.
+ *
+ * @fd:   File descriptor open for reading.
+ * @algo: Size of the final digest in bytes.
+ * @md:   Pointer to the buffer in which the digest will be written.
+ *
+ * @return: Zero on success, or -1 on error with errno set.
+ *
+ * This is sha3_init(), sha3_update_fd(), and sha3_final().
+ */
+int sha3_hash_fd(int fd, enum sha3_algo algo, void *md);
+
+/**
+ * sha3_hash_path - Compute the SHA-3 digest of a file.
+ *
+ * @path: Path of the file.
+ * @algo: Size of the final digest in bytes.
+ * @md:   Pointer to the buffer in which the digest will be written.
+ *
+ * @return: Zero on success, or -1 on error with errno set.
+ */
+int sha3_hash_path(const char *path, enum sha3_algo algo, void *md);
+
+/**
+ * shake_init - Initialise a SHA-3 context structure for SHAKE.
+ *
+ * @ctx:  Pointer to a SHA-3 context structure.
+ * @algo: SHAKE variant.
+ *
+ * @return: None.
+ *
+ * Input is absorbed with sha3_update() as usual, and output is read with
+ * shake_final() and shake_squeeze() instead of sha3_final().
+ */
+SHA3_INLINE void shake_init(struct sha3_ctx *ctx, enum shake_algo algo);
+
+/**
+ * shake_final - Finish absorbing input into a SHAKE context.
+ *
+ * @ctx: Pointer to a SHA-3 context structure initialised with shake_init() or
+ *      cshake_init().
+ *
+ * @return: None.
+ *
+ * After this, @ctx may only be passed to shake_squeeze(). Unlike sha3_final(),
+ * the state is not cleared, so the caller should clear @ctx once it's done
+ * with it if the output is sensitive.
+ */
+SHA3_INLINE void shake_final(struct sha3_ctx *ctx);
+
+/**
+ * shake_squeeze - Read output from a finalised SHAKE context.
+ *
+ * @ctx: Pointer to a SHA-3 context structure finalised with shake_final().
+ * @out: Pointer to the output buffer.
+ * @len: Number of bytes to write to @out.
+ *
+ * @return: None.
+ *
+ * Output continues from where the previous call left off, so any sequence of
+ * calls produces the same bytes as a single call for the total length.
+ */
+SHA3_INLINE void shake_squeeze(struct sha3_ctx *ctx, void *out, size_t len);
+
+/**
+ * struct sha3_ctx_x4 - Four-way multi-buffer SHA-3 context.
+ *
+ * @index: Byte index in each state that the next input byte will modify.
+ * @rate:  Padding rate in bytes. See struct sha3_ctx.
+ * @size:  Digest size in bytes.
+ * @u64:   Lane-wise view of the four interleaved internal states.
+ *
+ * The four states are interleaved lane by lane: Index(x + 5y) of state j is
+ * stored at Index(4(x + 5y) + j) in @u64. All four states always absorb the
+ * same number of bytes, so a single @index describes all of them.
+ */
+struct sha3_ctx_x4 {
+	uint8_t index;
+	uint8_t rate;
+	uint8_t size;
+
+	uint64_t u64[100];
+};
+
+/**
+ * sha3_init_x4 - Initialise a four-way multi-buffer SHA-3 context structure.
+ *
+ * @ctx:  Pointer to a four-way SHA-3 context structure.
+ * @algo: Size of the final digests in bytes.
+ *
+ * @return: None.
+ */
+void sha3_init_x4(struct sha3_ctx_x4 *ctx, enum sha3_algo algo);
+
+/**
+ * sha3_update_x4 - Update a four-way SHA-3 context with four input buffers.
+ *
+ * @ctx: Pointer to an initialised four-way SHA-3 context structure.
+ * @buf: Array of four pointers to input data, one for each state. There are
+ *       no alignment requirements.
+ * @len: Length, in bytes, of each of the four inputs.
+ *
+ * @return: None.
+ */
+void sha3_update_x4(struct sha3_ctx_x4 *ctx, const void *const buf[4],
+                    size_t len);
+
+/**
+ * sha3_init_x4_from - Initialise a four-way SHA-3 context from a midstate.
+ *
+ * @ctx: Pointer to a four-way SHA-3 context structure.
+ * @mid: Pointer to a SHA-3 context initialised with sha3_init() and updated
+ *       with the common prefix, but not finalised.
+ *
+ * @return: Zero on success, or -1 if @mid isn't a SHA-3 context, such as one
+ *          from shake_init() or turboshake_init(), in which case @ctx is not
+ *          modified.
+ *
+ * Each of the four states starts as a copy of @mid, as if by
+ * sha3_ctx_clone(). The multi-buffer contexts only do SHA-3 padding and the
+ * full 24 rounds, so other midstates are rejected rather than finalised
+ * wrongly.
+ */
+int sha3_init_x4_from(struct sha3_ctx_x4 *ctx, const struct sha3_ctx *mid);
+
+/**
+ * sha3_final_x4 - Finalise a four-way SHA-3 context and write the digests.
+ *
+ * @ctx: Pointer to an initialised four-way SHA-3 context structure.
+ * @md:  Array of four pointers to the buffers in which the digests will be
+ *       written. Each must be a valid pointer and may not be NULL.
+ *
+ * @return: None.
+ */
+void sha3_final_x4(struct sha3_ctx_x4 *ctx, void *const md[4]);
+
+/**
+ * struct sha3_ctx_x8 - Eight-way multi-buffer SHA-3 context.
+ *
+ * @index: Byte index in each state that the next input byte will modify.
+ * @rate:  Padding rate in bytes. See struct sha3_ctx.
+ * @size:  Digest size in bytes.
+ * @u64:   Lane-wise view of the eight interleaved internal states.
+ *
+ * As struct sha3_ctx_x4, but Index(x + 5y) of state j is stored at
+ * Index(8(x + 5y) + j) in @u64.
+ */
+struct sha3_ctx_x8 {
+	uint8_t index;
+	uint8_t rate;
+	uint8_t size;
+
+	uint64_t u64[200];
+};
+
+/**
+ * sha3_init_x8 - Initialise an eight-way multi-buffer SHA-3 context structure.
+ *
+ * @ctx:  Pointer to an eight-way SHA-3 context structure.
+ * @algo: Size of the final digests in bytes.
+ *
+ * @return: None.
+ */
+void sha3_init_x8(struct sha3_ctx_x8 *ctx, enum sha3_algo algo);
+
+/**
+ * sha3_update_x8 - Update an eight-way SHA-3 context with eight input buffers.
+ *
+ * @ctx: Pointer to an initialised eight-way SHA-3 context structure.
+ * @buf: Array of eight pointers to input data, one for each state. There are
+ *       no alignment requirements.
+ * @len: Length, in bytes, of each of the eight inputs.
+ *
+ * @return: None.
+ */
+void sha3_update_x8(struct sha3_ctx_x8 *ctx, const void *const buf[8],
+                    size_t len);
+
+/**
+ * sha3_init_x8_from - Initialise an eight-way SHA-3 context from a midstate.
+ *
+ * @ctx: Pointer to an eight-way SHA-3 context structure.
+ * @mid: Pointer to a SHA-3 context, as sha3_init_x4_from().
+ *
+ * @return: As sha3_init_x4_from().
+ */
+int sha3_init_x8_from(struct sha3_ctx_x8 *ctx, const struct sha3_ctx *mid);
+
+/**
+ * sha3_final_x8 - Finalise an eight-way SHA-3 context and write the digests.
+ *
+ * @ctx: Pointer to an initialised eight-way SHA-3 context structure.
+ * @md:  Array of eight pointers to the buffers in which the digests will be
+ *       written. Each must be a valid pointer and may not be NULL.
+ *
+ * @return: None.
+ */
+void sha3_final_x8(struct sha3_ctx_x8 *ctx, void *const md[8]);
+
+/**
+ * struct sha3_rng - Deterministic random bit generator built on SHAKE.
+ *
+ * @ctx: SHAKE context holding the generator state, in the squeezing phase.
+ */
+struct sha3_rng {
+	struct sha3_ctx ctx;
+};
+
+/**
+ * sha3_rng_seed - Seed a generator.
+ *
+ * @rng:  Pointer to a generator.
+ * @algo: SHAKE variant to generate output with. SHAKE128 has the larger rate,
+ *        so is faster.
+ * @seed: Pointer to the seed.
+ * @len:  Length, in bytes, of the seed.
+ *
+ * @return: None.
+ *
+ * The output of a newly-seeded generator is exactly the SHAKE output for the
+ * seed, so a stream can be reproduced with any SHAKE implementation.
+ */
+void sha3_rng_seed(struct sha3_rng *rng, enum shake_algo algo,
+                   const void *seed, size_t len);
+
+/**
+ * sha3_rng_reseed - Mix more input into a generator.
+ *
+ * @rng:  Pointer to a seeded generator.
+ * @seed: Pointer to the input.
+ * @len:  Length, in bytes, of the input.
+ *
+ * @return: None.
+ *
+ * The state is permuted and the input is absorbed into it as another SHAKE
+ * message, with the same padding. The output afterwards depends on every seed
+ * so far and on how many blocks of output had been started before each
+ * reseed.
+ */
+void sha3_rng_reseed(struct sha3_rng *rng, const void *seed, size_t len);
+
+/**
+ * sha3_rng_fill - Read random bytes from a generator.
+ *
+ * @rng: Pointer to a seeded generator.
+ * @buf: Pointer to the output buffer. There are no alignment requirements.
+ * @len: Number of bytes to write to @buf.
+ *
+ * @return: None.
+ *
+ * Successive calls continue the same stream, so the output doesn't depend on
+ * how it's split into calls. Whole blocks are written straight from the state
+ * into @buf.
+ */
+void sha3_rng_fill(struct sha3_rng *rng, void *buf, size_t len);
+
+/**
+ * sha3_rng_local - Get the calling thread's generator.
+ *
+ * @return: Pointer to the calling thread's generator, or NULL on error with
+ *          errno set.
+ *
+ * Each thread's generator is seeded with SHAKE128 from /dev/urandom the first
+ * time it's requested, so it's not reproducible unless it's seeded again with
+ * sha3_rng_seed(). It's seeded afresh in the child after fork(), so parent
+ * and child never share a stream. NULL is only returned if the system's
+ * entropy source can't be read.
+ */
+struct sha3_rng *sha3_rng_local(void);
+
+/**
+ * struct sha3_rng_x8 - Eight interleaved generators.
+ *
+ * @index: Byte index of the next output byte in the current group of blocks,
+ *         as sha3_rng_fill_x8().
+ * @rate:  Rate of each stream in bytes.
+ * @u64:   The eight interleaved states, as struct sha3_ctx_x8.
+ */
+struct sha3_rng_x8 {
+	uint16_t index;
+	uint8_t rate;
+
+	uint64_t u64[200];
+};
+
+/**
+ * sha3_rng_seed_x8 - Seed eight interleaved generators.
+ *
+ * @rng:  Pointer to eight interleaved generators.
+ * @algo: SHAKE variant to generate output with.
+ * @seed: Pointer to the seed.
+ * @len:  Length, in bytes, of the seed.
+ *
+ * @return: None.
+ *
+ * Stream j, for j from 0 to 7, is the SHAKE output for @seed followed by the
+ * single byte j.
+ */
+void sha3_rng_seed_x8(struct sha3_rng_x8 *rng, enum shake_algo algo,
+                      const void *seed, size_t len);
+
+/**
+ * sha3_rng_reseed_x8 - Mix more input into eight interleaved generators.
+ *
+ * As sha3_rng_reseed(), with @seed followed by the byte j absorbed into
+ * stream j.
+ */
+void sha3_rng_reseed_x8(struct sha3_rng_x8 *rng, const void *seed,
+                        size_t len);
+
+/**
+ * sha3_rng_fill_x8 - Read random bytes from eight interleaved generators.
+ *
+ * @rng: Pointer to eight seeded interleaved generators.
+ * @buf: Pointer to the output buffer. There are no alignment requirements.
+ * @len: Number of bytes to write to @buf.
+ *
+ * @return: None.
+ *
+ * The output is a block of stream 0, then a block of stream 1, and so on up to
+ * stream 7, then the next block of stream 0, where a block is the rate of the
+ * SHAKE variant. As sha3_rng_fill(), the output doesn't depend on how it's
+ * split into calls, nor on which kernels are in use, but all eight streams are
+ * generated with one multi-buffer permutation.
+ */
+void sha3_rng_fill_x8(struct sha3_rng_x8 *rng, void *buf, size_t len);
+
+/**
+ * turboshake_init - Initialise a SHA-3 context structure for TurboSHAKE.
+ *
+ * @ctx:  Pointer to a SHA-3 context structure.
+ * @algo: TurboSHAKE variant. SHAKE128 selects TurboSHAKE128 and SHAKE256
+ *        selects TurboSHAKE256.
+ *
+ * @return: None.
+ *
+ * Input is absorbed with sha3_update(), and output is read with
+ * turboshake_final() and shake_squeeze().
+ */
+void turboshake_init(struct sha3_ctx *ctx, enum shake_algo algo);
+
+/**
+ * turboshake_final - Finish absorbing input into a TurboSHAKE context.
+ *
+ * @ctx: Pointer to a SHA-3 context structure initialised with
+ *       turboshake_init().
+ * @ds:  Domain separation byte, in the range 0x01 to 0x7f.
+ *
+ * @return: None.
+ *
+ * As shake_final().
+ */
+void turboshake_final(struct sha3_ctx *ctx, uint8_t ds);
+
+/*
+ * struct sha3_pool - Worker pool used to spread hashing over several threads.
+ */
+struct sha3_pool;
+
+/**
+ * sha3_pool_create - Create a worker pool.
+ *
+ * @nthreads: Number of threads to hash with, including the calling thread, or
+ *            zero for the number of online CPUs.
+ *
+ * @return: Pointer to a new worker pool, or NULL if memory couldn't be
+ *          allocated or the threads couldn't be created.
+ *
+ * A pool may be shared by any number of contexts and threads, but only runs
+ * one job at a time.
+ */
+struct sha3_pool *sha3_pool_create(size_t nthreads);
+
+/**
+ * sha3_pool_run - Run a job on a worker pool and wait for it to finish.
+ *
+ * @pool:  Pointer to a worker pool, or NULL to run the job on the calling
+ *         thread.
+ * @fn:    Task function, called once as fn(@arg, i) for every i less than
+ *         @count, in no particular order and from any of the pool's threads.
+ * @arg:   Argument passed to @fn.
+ * @count: Number of tasks.
+ *
+ * @return: None.
+ *
+ * This is the same mechanism KangarooTwelve and ParallelHash use to spread
+ * their work, so callers can share one pool between those and their own jobs.
+ * Jobs submitted from different threads run one after another. Must not be
+ * called from a task running on the same pool.
+ */
+void sha3_pool_run(struct sha3_pool *pool, void (*fn)(void *arg, size_t i),
+                   void *arg, size_t count);
+
+/**
+ * sha3_pool_destroy - Stop the threads of a worker pool and free it.
+ *
+ * @pool: Pointer to a worker pool, or NULL. No context using @pool may be
+ *        updated during or after this call.
+ *
+ * @return: None.
+ */
+void sha3_pool_destroy(struct sha3_pool *pool);
+
+/**
+ * struct k12_ctx - KangarooTwelve context.
+ *
+ * @node:   TurboSHAKE state of the final node.
+ * @leaf:   TurboSHAKE state of the leaf currently being absorbed, if any.
+ * @pool:   Worker pool for hashing leaves, or NULL.
+ * @len:    Number of bytes of input absorbed so far.
+ * @leaves: Number of leaves absorbed into the final node so far.
+ * @algo:   KangarooTwelve variant.
+ */
+struct k12_ctx {
+	struct sha3_ctx node;
+	struct sha3_ctx leaf;
+	struct sha3_pool *pool;
+	uint64_t len;
+	uint64_t leaves;
+	uint8_t algo;
+};
+
+/**
+ * k12_init - Initialise a KangarooTwelve context structure.
+ *
+ * @ctx:  Pointer to a KangarooTwelve context structure.
+ * @algo: KangarooTwelve variant.
+ * @pool: Worker pool to hash leaves with, or NULL to hash on the calling
+ *        thread only.
+ *
+ * @return: None.
+ */
+void k12_init(struct k12_ctx *ctx, enum k12_algo algo, struct sha3_pool *pool);
+
+/**
+ * k12_update - Update a KangarooTwelve context with input data.
+ *
+ * @ctx: Pointer to an initialised KangarooTwelve context structure.
+ * @buf: Pointer to input data.
+ * @len: Length, in bytes, of the input data.
+ *
+ * @return: None.
+ *
+ * Whole 8 KiB chunks of input are hashed in parallel, so passing large buffers
+ * is much faster than passing many small ones.
+ */
+void k12_update(struct k12_ctx *ctx, const void *buf, size_t len);
+
+/**
+ * k12_final - Finish absorbing input into a KangarooTwelve context.
+ *
+ * @ctx:    Pointer to an initialised KangarooTwelve context structure.
+ * @custom: Pointer to the customisation string, or NULL if @len is zero.
+ * @len:    Length, in bytes, of the customisation string.
+ *
+ * @return: None.
+ *
+ * After this, @ctx may only be passed to k12_squeeze().
+ */
+void k12_final(struct k12_ctx *ctx, const void *custom, size_t len);
+
+/**
+ * k12_squeeze - Read output from a finalised KangarooTwelve context.
+ *
+ * @ctx: Pointer to a KangarooTwelve context finalised with k12_final().
+ * @out: Pointer to the output buffer.
+ * @len: Number of bytes to write to @out.
+ *
+ * @return: None.
+ *
+ * As shake_squeeze().
+ */
+void k12_squeeze(struct k12_ctx *ctx, void *out, size_t len);
+
+/**
+ * k12 - Compute KangarooTwelve of a buffer.
+ *
+ * @algo:   KangarooTwelve variant.
+ * @buf:    Pointer to input data.
+ * @len:    Length, in bytes, of the input data.
+ * @custom: Pointer to the customisation string, or NULL if @clen is zero.
+ * @clen:   Length, in bytes, of the customisation string.
+ * @out:    Pointer to the output buffer.
+ * @outlen: Number of bytes to write to @out.
+ * @pool:   Worker pool to hash leaves with, or NULL.
+ *
+ * @return: None.
+ */
+void k12(enum k12_algo algo, const void *buf, size_t len, const void *custom,
+         size_t clen, void *out, size_t outlen, struct sha3_pool *pool);
+
+/**
+ * keccak_p1600 - Apply the KECCAK-p[1600] permutation to a state.
+ *
+ * @state:   Keccak state, with Lane(x, y) at Index(x + 5y) as in struct
+ *           sha3_ctx. Byte i of the state in FIPS 202 is bits 8(i % 8) to
+ *           8(i % 8) + 7 of @state[i / 8].
+ * @nrounds: Number of rounds, from 1 to 24. These are the last @nrounds rounds
+ *           of KECCAK-f[1600], so 24 is KECCAK-f[1600] itself and 12 is the
+ *           permutation of TurboSHAKE and KangarooTwelve.
+ *
+ * @return: None.
+ *
+ * This uses the same dispatched kernels as the rest of the library.
+ */
+void keccak_p1600(uint64_t state[25], unsigned nrounds);
+
+/**
+ * struct keccak_sponge - A general Keccak sponge or duplex object.
+ *
+ * @ctx:       State and parameters of the sponge. Only the fields used by
+ *             keccak_sponge_init() are meaningful.
+ * @squeezing: Whether keccak_sponge_squeeze() has been called since the last
+ *             input was absorbed.
+ */
+struct keccak_sponge {
+	struct sha3_ctx ctx;
+	uint8_t squeezing;
+};
+
+/**
+ * keccak_sponge_init - Initialise a sponge with arbitrary parameters.
+ *
+ * @s:       Pointer to a sponge.
+ * @rate:    Rate in bytes. This must be a multiple of 8 from 8 to 192.
+ * @ds:      Domain separation byte, from 0x01 to 0x7f, as keccak_pad(). This is
+ *           the suffix bits followed by the first bit of padding, for example
+ *           0x1f for SHAKE or 0x01 for plain pad10*1 padding.
+ * @nrounds: Number of rounds of the permutation, from 1 to 24.
+ *
+ * @return: Zero on success, or -1 with errno set to EINVAL if the parameters
+ *          are out of range.
+ *
+ * With a rate of 168 and @ds of 0x1f, for example, the sponge is SHAKE128.
+ */
+int keccak_sponge_init(struct keccak_sponge *s, size_t rate, uint8_t ds,
+                       unsigned nrounds);
+
+/**
+ * keccak_sponge_absorb - Absorb input into a sponge.
+ *
+ * @s:   Pointer to an initialised sponge.
+ * @buf: Pointer to input data. There are no alignment requirements.
+ * @len: Length, in bytes, of the input data.
+ *
+ * @return: None.
+ *
+ * Absorbing after output has been read starts a new message in the same
+ * state: the state is permuted once and absorbing continues from the start of
+ * a block. A transcript can therefore alternate between absorbing messages and
+ * squeezing challenges in a single pass, at the cost of one permutation for
+ * each switch in either direction.
+ */
+void keccak_sponge_absorb(struct keccak_sponge *s, const void *buf,
+                          size_t len);
+
+/**
+ * keccak_sponge_squeeze - Read output from a sponge.
+ *
+ * @s:   Pointer to an initialised sponge.
+ * @out: Pointer to the output buffer.
+ * @len: Number of bytes to write to @out.
+ *
+ * @return: None.
+ *
+ * The first call after absorbing pads the message with the domain separation
+ * byte. Successive calls continue the same output stream.
+ */
+void keccak_sponge_squeeze(struct keccak_sponge *s, void *out, size_t len);
+
+/**
+ * keccak_duplex - Apply one duplexing call to a sponge.
+ *
+ * @s:      Pointer to an initialised sponge that is only used for duplexing.
+ * @in:     Pointer to the input block σ, or NULL if @inlen is zero.
+ * @inlen:  Length, in bytes, of @in. Less than the rate.
+ * @out:    Pointer to the output buffer, or NULL if @outlen is zero.
+ * @outlen: Number of bytes to write to @out. At most the rate.
+ *
+ * @return: None.
+ *
+ * This is the duplexing call of the Keccak duplex construction: @in is padded
+ * with the domain separation byte into a block, which is XORed into the state,
+ * the state is permuted, and the first @outlen bytes of the rate are output.
+ * A sponge used with keccak_duplex() must not also be used with
+ * keccak_sponge_absorb() or keccak_sponge_squeeze().
+ */
+void keccak_duplex(struct keccak_sponge *s, const void *in, size_t inlen,
+                   void *out, size_t outlen);
+
+/**
+ * cshake_init - Initialise a SHA-3 context structure for cSHAKE.
+ *
+ * @ctx:    Pointer to a SHA-3 context structure.
+ * @algo:   cSHAKE variant. SHAKE128 selects cSHAKE128 and SHAKE256 selects
+ *          cSHAKE256.
+ * @name:   Pointer to the function-name string N, or NULL if @nlen is zero.
+ * @nlen:   Length, in bytes, of @name.
+ * @custom: Pointer to the customisation string S, or NULL if @clen is zero.
+ * @clen:   Length, in bytes, of @custom.
+ *
+ * @return: None.
+ *
+ * Input is absorbed with sha3_update(), and output is read with shake_final()
+ * and shake_squeeze(). If both strings are empty, cSHAKE is SHAKE.
+ */
+void cshake_init(struct sha3_ctx *ctx, enum shake_algo algo, const void *name,
+                 size_t nlen, const void *custom, size_t clen);
+
+/**
+ * cshake - Compute cSHAKE of a message from a precomputed context.
+ *
+ * @mid:    Pointer to a SHA-3 context initialised with cshake_init(). It is not
+ *          modified, so it can be set up once for a given N and S and reused
+ *          for every message.
+ * @buf:    Pointer to the message.
+ * @len:    Length, in bytes, of the message.
+ * @out:    Pointer to the output buffer.
+ * @outlen: Number of bytes to write to @out.
+ *
+ * @return: None.
+ *
+ * cshake_init() leaves the state on a block boundary, so this costs a copy of
+ * the state more than hashing the message alone.
+ */
+void cshake(const struct sha3_ctx *mid, const void *buf, size_t len, void *out,
+            size_t outlen);
+
+/**
+ * tuplehash_init - Initialise a SHA-3 context structure for TupleHash.
+ *
+ * @ctx:    Pointer to a SHA-3 context structure.
+ * @algo:   TupleHash variant. SHAKE128 selects TupleHash128 and SHAKE256
+ *          selects TupleHash256.
+ * @custom: Pointer to the customisation string S, or NULL if @clen is zero.
+ * @clen:   Length, in bytes, of @custom.
+ *
+ * @return: None.
+ *
+ * Elements are absorbed in order with tuplehash_update(), tuplehash_updatev(),
+ * or tuplehash_element(), and output is read with tuplehash_final() and
+ * shake_squeeze(). As with kmac_init(), the initialised context may instead be
+ * kept unmodified and passed to tuplehash() for each tuple.
+ */
+void tuplehash_init(struct sha3_ctx *ctx, enum shake_algo algo,
+                    const void *custom, size_t clen);
+
+/**
+ * tuplehash_element - Start an element of a TupleHash tuple.
+ *
+ * @ctx: Pointer to a SHA-3 context structure initialised with
+ *       tuplehash_init().
+ * @len: Length, in bytes, of the element.
+ *
+ * @return: None.
+ *
+ * This absorbs the length prefix of the element only. Exactly @len bytes must
+ * then be absorbed with sha3_update() or sha3_updatev(), so an element can be
+ * gathered from any number of fragments.
+ */
+void tuplehash_element(struct sha3_ctx *ctx, size_t len);
+
+/**
+ * tuplehash_update - Absorb an element of a TupleHash tuple.
+ *
+ * @ctx: Pointer to a SHA-3 context structure initialised with
+ *       tuplehash_init().
+ * @buf: Pointer to the element.
+ * @len: Length, in bytes, of the element.
+ *
+ * @return: None.
+ */
+void tuplehash_update(struct sha3_ctx *ctx, const void *buf, size_t len);
+
+/**
+ * tuplehash_updatev - Absorb several elements of a TupleHash tuple.
+ *
+ * @ctx:   Pointer to a SHA-3 context structure initialised with
+ *         tuplehash_init().
+ * @elems: Array of @n buffers, each of which is one element.
+ * @n:     Number of elements.
+ *
+ * @return: None.
+ *
+ * As tuplehash_update() for each element, but the length prefixes and
+ * elements are absorbed together with sha3_updatev().
+ */
+void tuplehash_updatev(struct sha3_ctx *ctx, const struct iovec *elems, int n);
+
+/**
+ * tuplehash_final - Finish absorbing a tuple into a TupleHash context.
+ *
+ * @ctx:    Pointer to a SHA-3 context structure initialised with
+ *          tuplehash_init().
+ * @outlen: Number of bytes of output that will be read, or zero for
+ *          TupleHashXOF.
+ *
+ * @return: None.
+ *
+ * As kmac_final(), exactly @outlen bytes should be read with shake_squeeze().
+ */
+void tuplehash_final(struct sha3_ctx *ctx, size_t outlen);
+
+/**
+ * tuplehash - Compute TupleHash of a tuple from a precomputed context.
+ *
+ * @mid:    Pointer to a SHA-3 context initialised with tuplehash_init(). It is
+ *          not modified.
+ * @elems:  Array of @n buffers, each of which is one element.
+ * @n:      Number of elements.
+ * @out:    Pointer to the output buffer.
+ * @outlen: Number of bytes to write to @out.
+ *
+ * @return: None.
+ */
+void tuplehash(const struct sha3_ctx *mid, const struct iovec *elems, int n,
+               void *out, size_t outlen);
+
+/**
+ * tuplehash_xof - Compute TupleHashXOF of a tuple from a precomputed context.
+ *
+ * As tuplehash(), except that the output for a shorter @outlen is a prefix of
+ * the output for a longer one.
+ */
+void tuplehash_xof(const struct sha3_ctx *mid, const struct iovec *elems,
+                   int n, void *out, size_t outlen);
+
+/**
+ * kmac_init - Initialise a SHA-3 context structure with a KMAC key.
+ *
+ * @ctx:    Pointer to a SHA-3 context structure.
+ * @algo:   KMAC variant. SHAKE128 selects KMAC128 and SHAKE256 selects
+ *          KMAC256.
+ * @key:    Pointer to the key.
+ * @klen:   Length, in bytes, of the key.
+ * @custom: Pointer to the customisation string S, or NULL if @clen is zero.
+ * @clen:   Length, in bytes, of @custom.
+ *
+ * @return: None.
+ *
+ * The initialised context is a key schedule. It may be updated with a message
+ * and finished with kmac_final() and shake_squeeze() directly, but is more
+ * usefully kept unmodified and passed to kmac() and kmac_many(), or copied
+ * with sha3_ctx_clone(), for each message. Clear it once the key is no longer
+ * needed.
+ */
+void kmac_init(struct sha3_ctx *ctx, enum shake_algo algo, const void *key,
+               size_t klen, const void *custom, size_t clen);
+
+/**
+ * kmac_final - Finish absorbing a message into a KMAC context.
+ *
+ * @ctx:    Pointer to a SHA-3 context structure initialised with kmac_init().
+ * @outlen: Number of bytes of output that will be read, or zero for KMACXOF.
+ *
+ * @return: None.
+ *
+ * As parallelhash_final(), the output length is part of the input, so
+ * exactly @outlen bytes should be read with shake_squeeze().
+ */
+void kmac_final(struct sha3_ctx *ctx, size_t outlen);
+
+/**
+ * kmac - Compute the KMAC tag of a message.
+ *
+ * @key:    Pointer to a key schedule initialised with kmac_init(). It is not
+ *          modified, and determines whether this is KMAC128 or KMAC256.
+ * @buf:    Pointer to the message.
+ * @len:    Length, in bytes, of the message.
+ * @tag:    Pointer to the output buffer.
+ * @taglen: Length, in bytes, of the tag.
+ *
+ * @return: None.
+ */
+void kmac(const struct sha3_ctx *key, const void *buf, size_t len, void *tag,
+          size_t taglen);
+
+/**
+ * kmac_many - Compute the KMAC tags of many messages with the same key.
+ *
+ * @key:    Pointer to a key schedule, as kmac().
+ * @bufs:   Array of @n pointers to messages. There are no alignment
+ *          requirements.
+ * @lens:   Array of @n message lengths in bytes.
+ * @n:      Number of messages.
+ * @out:    Pointer to the buffer in which the tags will be written. The tag of
+ *          message i is written at byte offset i * @taglen.
+ * @taglen: Length, in bytes, of each tag.
+ *
+ * @return: None.
+ *
+ * As sha3_hash_many(), messages are hashed in groups with the multi-buffer
+ * permutations, each starting from a copy of the key schedule.
+ */
+void kmac_many(const struct sha3_ctx *key, const void *const *bufs,
+               const size_t *lens, size_t n, void *out, size_t taglen);
+
+/**
+ * struct parallelhash_ctx - ParallelHash context.
+ *
+ * @outer:  cSHAKE state that the block digests are absorbed into.
+ * @inner:  SHAKE state of the block currently being absorbed, if any.
+ * @pool:   Worker pool for hashing blocks, or NULL.
+ * @block:  Block size B in bytes.
+ * @len:    Number of bytes of input absorbed so far.
+ * @blocks: Number of block digests absorbed into @outer so far.
+ * @algo:   ParallelHash variant.
+ */
+struct parallelhash_ctx {
+	struct sha3_ctx outer;
+	struct sha3_ctx inner;
+	struct sha3_pool *pool;
+	size_t block;
+	uint64_t len;
+	uint64_t blocks;
+	uint8_t algo;
+};
+
+/**
+ * parallelhash_init - Initialise a ParallelHash context structure.
+ *
+ * @ctx:    Pointer to a ParallelHash context structure.
+ * @algo:   ParallelHash variant. SHAKE128 selects ParallelHash128 and SHAKE256
+ *          selects ParallelHash256.
+ * @block:  Block size B in bytes. Must be greater than zero.
+ * @custom: Pointer to the customisation string S, or NULL if @clen is zero.
+ * @clen:   Length, in bytes, of @custom.
+ * @pool:   Worker pool to hash blocks with, or NULL to hash on the calling
+ *          thread only.
+ *
+ * @return: None.
+ */
+void parallelhash_init(struct parallelhash_ctx *ctx, enum shake_algo algo,
+                       size_t block, const void *custom, size_t clen,
+                       struct sha3_pool *pool);
+
+/**
+ * parallelhash_update - Update a ParallelHash context with input data.
+ *
+ * @ctx: Pointer to an initialised ParallelHash context structure.
+ * @buf: Pointer to input data.
+ * @len: Length, in bytes, of the input data.
+ *
+ * @return: None.
+ *
+ * Whole blocks of input are hashed in parallel, so passing large buffers is
+ * much faster than passing many small ones.
+ */
+void parallelhash_update(struct parallelhash_ctx *ctx, const void *buf,
+                         size_t len);
+
+/**
+ * parallelhash_final - Finish absorbing input into a ParallelHash context.
+ *
+ * @ctx:    Pointer to an initialised ParallelHash context structure.
+ * @outlen: Number of bytes of output that will be read, or zero for
+ *          ParallelHashXOF.
+ *
+ * @return: None.
+ *
+ * The output length is part of the input to ParallelHash, so exactly @outlen
+ * bytes should be read with parallelhash_squeeze(). ParallelHashXOF may be
+ * read indefinitely.
+ */
+void parallelhash_final(struct parallelhash_ctx *ctx, size_t outlen);
+
+/**
+ * parallelhash_squeeze - Read output from a finalised ParallelHash context.
+ *
+ * @ctx: Pointer to a ParallelHash context finalised with parallelhash_final().
+ * @out: Pointer to the output buffer.
+ * @len: Number of bytes to write to @out.
+ *
+ * @return: None.
+ *
+ * As shake_squeeze().
+ */
+void parallelhash_squeeze(struct parallelhash_ctx *ctx, void *out, size_t len);
+
+/**
+ * parallelhash - Compute ParallelHash of a buffer.
+ *
+ * @algo:   ParallelHash variant.
+ * @buf:    Pointer to input data.
+ * @len:    Length, in bytes, of the input data.
+ * @block:  Block size B in bytes. Must be greater than zero.
+ * @custom: Pointer to the customisation string, or NULL if @clen is zero.
+ * @clen:   Length, in bytes, of the customisation string.
+ * @out:    Pointer to the output buffer.
+ * @outlen: Number of bytes to write to @out.
+ * @pool:   Worker pool to hash blocks with, or NULL.
+ *
+ * @return: None.
+ */
+void parallelhash(enum shake_algo algo, const void *buf, size_t len,
+                  size_t block, const void *custom, size_t clen, void *out,
+                  size_t outlen, struct sha3_pool *pool);
+
+/**
+ * parallelhash_xof - Compute ParallelHashXOF of a buffer.
+ *
+ * As parallelhash(), except that the output for a shorter @outlen is a prefix
+ * of the output for a longer one.
+ */
+void parallelhash_xof(enum shake_algo algo, const void *buf, size_t len,
+                      size_t block, const void *custom, size_t clen, void *out,
+                      size_t outlen, struct sha3_pool *pool);
+
+/**
+ * sha3_hash_many - Compute the SHA-3 digests of many messages.
+ *
+ * @algo: Size of the final digests in bytes.
+ * @bufs: Array of @n pointers to input data. There are no alignment
+ *        requirements.
+ * @lens: Array of @n input lengths in bytes.
+ * @n:    Number of messages.
+ * @out:  Pointer to the buffer in which the digests will be written. The
+ *        digest of message i is written at byte offset i * @algo, so the
+ *        buffer must be at least @n * @algo bytes.
+ *
+ * @return: None.
+ *
+ * This is equivalent to calling sha3_init(), sha3_update(), and sha3_final()
+ * for each message, but is considerably faster for many short messages as it
+ * hashes groups of messages of similar length together using the multi-buffer
+ * permutations.
+ */
+void sha3_hash_many(enum sha3_algo algo, const void *const *bufs,
+                    const size_t *lens, size_t n, void *out);
+
+/**
+ * sha3_hash_many_from - Compute the SHA-3 digests of many messages that share
+ *                       a prefix.
+ *
+ * @mid:  Pointer to a SHA-3 context initialised with sha3_init() and updated
+ *        with the common prefix, but not finalised. It is not modified.
+ * @bufs: Array of @n pointers to input data, as sha3_hash_many().
+ * @lens: Array of @n input lengths in bytes.
+ * @n:    Number of messages.
+ * @out:  Pointer to the output buffer, as sha3_hash_many().
+ *
+ * @return: None.
+ *
+ * The digest of message i is that of the prefix followed by the message, as
+ * if @mid were cloned and updated with it.
+ */
+void sha3_hash_many_from(const struct sha3_ctx *mid, const void *const *bufs,
+                         const size_t *lens, size_t n, void *out);
+
+/**
+ * struct merkle_tree - Merkle tree over fixed-size chunks of a buffer.
+ *
+ * @leaf:    SHA3-256 midstate with the leaf prefix absorbed.
+ * @node:    SHA3-256 midstate with the node prefix absorbed.
+ * @pool:    Worker pool for hashing large levels, or NULL.
+ * @data:    The buffer.
+ * @len:     Length of the buffer in bytes.
+ * @chunk:   Chunk size in bytes.
+ * @leaves:  Number of leaves.
+ * @levels:  Number of levels, including the leaves and the root.
+ * @level:   Index in @nodes of the first node of each level, followed by the
+ *           total number of nodes.
+ * @nodes:   Digests of every node, level by level from the leaves up.
+ * @dirty:   Leaves marked dirty since the root was last computed.
+ * @ndirty:  Number of entries in @dirty.
+ * @mark:    Whether each leaf is in @dirty.
+ */
+struct merkle_tree {
+	struct sha3_ctx leaf;
+	struct sha3_ctx node;
+	struct sha3_pool *pool;
+	const uint8_t *data;
+	size_t len;
+	size_t chunk;
+	size_t leaves;
+	size_t levels;
+	size_t *level;
+	uint8_t *nodes;
+	size_t *dirty;
+	size_t ndirty;
+	uint8_t *mark;
+};
+
+/**
+ * merkle_init - Build a Merkle tree over a buffer.
+ *
+ * @t:     Pointer to a Merkle tree structure.
+ * @data:  Pointer to the buffer, which must stay valid until merkle_free().
+ *         There are no alignment requirements.
+ * @len:   Length of the buffer in bytes.
+ * @chunk: Chunk size in bytes. Must not be zero. The last chunk may be
+ *         shorter, and an empty buffer has a single empty chunk.
+ * @pool:  Worker pool for hashing large levels, or NULL.
+ *
+ * @return: Zero on success, or -1 if memory couldn't be allocated.
+ *
+ * Leaf i is SHA3-256(0x00 || chunk i) and each node above the leaves is
+ * SHA3-256(0x01 || left || right). A node at the end of a level with no right
+ * sibling is carried up to the next level unchanged.
+ */
+int merkle_init(struct merkle_tree *t, const void *data, size_t len,
+                size_t chunk, struct sha3_pool *pool);
+
+/**
+ * merkle_dirty - Mark part of the buffer of a Merkle tree as changed.
+ *
+ * @t:   Pointer to an initialised Merkle tree.
+ * @off: Byte offset of the change in the buffer.
+ * @len: Length of the change in bytes. Anything past the end of the buffer is
+ *       ignored.
+ *
+ * @return: None.
+ *
+ * Nothing is hashed until the next call to merkle_root().
+ */
+void merkle_dirty(struct merkle_tree *t, size_t off, size_t len);
+
+/**
+ * merkle_root - Get the root digest of a Merkle tree.
+ *
+ * @t:  Pointer to an initialised Merkle tree.
+ * @md: Pointer to the buffer in which the 32-byte root will be written.
+ *
+ * @return: None.
+ *
+ * Only the leaves marked dirty since the last call, and their ancestors, are
+ * hashed again.
+ */
+void merkle_root(struct merkle_tree *t, void *md);
+
+/**
+ * merkle_free - Free the memory held by a Merkle tree.
+ *
+ * @t: Pointer to an initialised Merkle tree, or to a structure that
+ *     merkle_init() failed on.
+ *
+ * @return: None.
+ */
+void merkle_free(struct merkle_tree *t);
+
+/**
+ * sha3_kernel - Get the name of the selected KECCAK-f[1600] kernels.
+ *
+ * @return: Name of the kernel set selected for the running CPU, as accepted by
+ *          the SHA3_KERNEL environment variable. One of "generic",
+ *          "generic-lc", "generic32", "avx2", "avx512", or "arm-sha3".
+ *
+ * The kernels are selected once, when the library is loaded. Setting
+ * SHA3_KERNEL in the environment overrides the choice if the named kernels are
+ * supported by the CPU.
+ */
+const char *sha3_kernel(void);
+
+/**
+ * struct sha3_stats - Hashing counters for one thread.
+ *
+ * @block_bytes:  Bytes absorbed by the block absorb kernels.
+ * @lane_bytes:   Bytes absorbed by sha3_update() a lane at a time.
+ * @byte_bytes:   Bytes absorbed by sha3_update() a byte at a time.
+ * @permutations: KECCAK-p[1600] permutations. A multi-buffer permutation
+ *                counts the states that hold a message, so padding states in a
+ *                partly filled batch aren't included.
+ * @finals:       States padded for output, whether by sha3_final(),
+ *                shake_final(), a one-shot function, or a batch.
+ * @kernel:       Name of the selected kernel set, as sha3_kernel().
+ */
+struct sha3_stats {
+	uint64_t block_bytes;
+	uint64_t lane_bytes;
+	uint64_t byte_bytes;
+	uint64_t permutations;
+	uint64_t finals;
+	const char *kernel;
+};
+
+/**
+ * sha3_stats_get - Read the calling thread's hashing counters.
+ *
+ * @st: Pointer to the structure in which the counters will be written.
+ *
+ * @return: Zero on success, or -1 with errno set to ENOTSUP if the library was
+ *          built without SHA3_STATS.
+ *
+ * The counters are only kept when the library is built with SHA3_STATS
+ * defined, for example with `make CPPFLAGS=-DSHA3_STATS`. They count from the
+ * start of the thread or the last sha3_stats_reset(). Work done on a worker
+ * pool is counted by the pool's threads, not the caller.
+ */
+int sha3_stats_get(struct sha3_stats *st);
+
+/**
+ * sha3_stats_reset - Zero the calling thread's hashing counters.
+ *
+ * @return: None.
+ */
+void sha3_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#if defined(SHA3_IMPLEMENTATION)
+	#include "sha3-inline.h"
+#endif
 
 #endif /* SHA3_H */
@@ -0,0 +1,306 @@
+/* SPDX-License-Identifier: 0BSD
+ *
+ * Copyright © 2022 Alex Minghella <a@minghella.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * C++ interface.
+ *
+ * sha3::hasher<Bits> wraps struct sha3_ctx for incremental hashing, and
+ * sha3::digest<Bits>() hashes a whole message at once. Digests are returned as
+ * std::array, so nothing is ever allocated.
+ *
+ * sha3::digest<Bits>() is constexpr. During constant evaluation it uses the
+ * plain implementation of the permutation below, so digests of literals such as
+ * route names can be computed at compile time,
+ *
+ *     constexpr auto id = sha3::digest<256>("/v1/orders");
+ *
+ * while at run time it calls the library's one-shot functions, which use the
+ * dispatched kernels and have the absorb loop for each rate unrolled. This
+ * header needs C++20, for std::span and std::is_constant_evaluated().
+ */
+
+#ifndef SHA3_HPP
+#define SHA3_HPP 1
+
+#if __cplusplus < 202002L
+	#error "sha3.hpp requires C++20"
+#endif
+
+#include "sha3.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+namespace sha3 {
+
+namespace detail {
+
+/*
+ * KECCAK-f[1600] round constants, as keccak_rc.
+ */
+inline constexpr std::uint64_t rc[24] = {
+	0x0000000000000001, 0x0000000000008082, 0x800000000000808a,
+	0x8000000080008000, 0x000000000000808b, 0x0000000080000001,
+	0x8000000080008081, 0x8000000000008009, 0x000000000000008a,
+	0x0000000000000088, 0x0000000080008009, 0x000000008000000a,
+	0x000000008000808b, 0x800000000000008b, 0x8000000000008089,
+	0x8000000000008003, 0x8000000000008002, 0x8000000000000080,
+	0x000000000000800a, 0x800000008000000a, 0x8000000080008081,
+	0x8000000000008080, 0x0000000080000001, 0x8000000080008008,
+};
+
+/*
+ * The ρ offsets, by lane index from Index(1), and the π cycle, as in the loop
+ * version of keccakp_1600_inline() in sha3.c, which describes how they're
+ * derived.
+ */
+inline constexpr unsigned rho[24] = {
+	 1, 62, 28, 27, 36, 44,  6, 55, 20,  3, 10, 43,
+	25, 39, 41, 45, 15, 21,  8, 18,  2, 61, 56, 14,
+};
+
+inline constexpr unsigned pi[24] = {
+	 1,  6,  9, 22, 14, 20,  2, 12, 13, 19, 23, 15,
+	 4, 24, 21,  8, 16,  5,  3, 18, 17, 11,  7, 10,
+};
+
+constexpr std::uint64_t rotl64(std::uint64_t x, unsigned n)
+{
+	return n ? (x << n) | (x >> (64 - n)) : x;
+}
+
+/**
+ * permute - KECCAK-f[1600] for constant evaluation.
+ *
+ * @A: Keccak internal state, with Lane(x, y) at Index(x + 5y).
+ *
+ * @return: None.
+ *
+ * This is written for clarity rather than speed, since it only runs in the
+ * compiler.
+ */
+constexpr void permute(std::array<std::uint64_t, 25> &A)
+{
+	for (unsigned r = 0; r < 24; r++) {
+		std::uint64_t C[5] = {}, D[5] = {};
+
+		/* θ */
+		for (unsigned x = 0; x < 5; x++)
+			C[x] = A[x] ^ A[x + 5] ^ A[x + 10] ^ A[x + 15] ^ A[x + 20];
+		for (unsigned x = 0; x < 5; x++)
+			D[x] = C[(x + 4) % 5] ^ rotl64(C[(x + 1) % 5], 1);
+		for (unsigned i = 0; i < 25; i++)
+			A[i] ^= D[i % 5];
+
+		/* ρ */
+		for (unsigned i = 0; i < 24; i++)
+			A[i + 1] = rotl64(A[i + 1], rho[i]);
+
+		/* π, around the cycle of lanes starting from Index(1) */
+		std::uint64_t t = A[pi[0]];
+		for (unsigned i = 0; i < 23; i++)
+			A[pi[i]] = A[pi[i + 1]];
+		A[pi[23]] = t;
+
+		/* χ */
+		for (unsigned y = 0; y < 25; y += 5) {
+			for (unsigned x = 0; x < 5; x++)
+				C[x] = A[y + x];
+			for (unsigned x = 0; x < 5; x++)
+				A[y + x] = C[x] ^ (~C[(x + 1) % 5] & C[(x + 2) % 5]);
+		}
+
+		/* ι */
+		A[0] ^= rc[r];
+	}
+}
+
+constexpr std::uint8_t to_u8(char c)
+{
+	return static_cast<std::uint8_t>(c);
+}
+
+constexpr std::uint8_t to_u8(std::byte b)
+{
+	return std::to_integer<std::uint8_t>(b);
+}
+
+/**
+ * digest - Compute a SHA-3 digest by constant evaluation.
+ *
+ * @p:   Pointer to input data, of chars or std::bytes.
+ * @len: Length, in bytes, of the input data.
+ *
+ * @return: The digest.
+ */
+template <std::size_t Size, typename Byte>
+constexpr std::array<std::byte, Size> digest(const Byte *p, std::size_t len)
+{
+	constexpr std::size_t rate = 200 - 2 * Size;
+	std::array<std::uint64_t, 25> A = {};
+
+	for (; len >= rate; len -= rate, p += rate) {
+		for (std::size_t i = 0; i < rate; i++)
+			A[i / 8] ^= std::uint64_t{to_u8(p[i])} << 8 * (i % 8);
+		permute(A);
+	}
+
+	/* See keccak_pad() for a description of the padding. */
+	for (std::size_t i = 0; i < len; i++)
+		A[i / 8] ^= std::uint64_t{to_u8(p[i])} << 8 * (i % 8);
+	A[len / 8] ^= std::uint64_t{0x06} << 8 * (len % 8);
+	A[rate / 8 - 1] ^= 0x8000000000000000;
+	permute(A);
+
+	std::array<std::byte, Size> md = {};
+	for (std::size_t i = 0; i < Size; i++)
+		md[i] = static_cast<std::byte>(A[i / 8] >> 8 * (i % 8));
+	return md;
+}
+
+/**
+ * oneshot - Compute a SHA-3 digest with the library.
+ *
+ * @buf: Pointer to input data.
+ * @len: Length, in bytes, of the input data.
+ * @md:  Pointer to the buffer in which the digest will be written.
+ *
+ * @return: None.
+ */
+template <unsigned Bits>
+inline void oneshot(const void *buf, std::size_t len, void *md) noexcept
+{
+	if constexpr (Bits == 224)
+		sha3_224_short(buf, len, md);
+	else if constexpr (Bits == 256)
+		sha3_256_short(buf, len, md);
+	else if constexpr (Bits == 384)
+		sha3_384_short(buf, len, md);
+	else
+		sha3_512_short(buf, len, md);
+}
+
+} /* namespace detail */
+
+/**
+ * hasher - Incremental SHA-3 hashing.
+ *
+ * @Bits: Digest size in bits: 224, 256, 384, or 512.
+ *
+ * A hasher is a struct sha3_ctx, so it can be copied to fork a hash of a
+ * common prefix and moved freely. final() leaves it ready to hash another
+ * message.
+ */
+template <unsigned Bits>
+class hasher {
+	static_assert(Bits == 224 || Bits == 256 || Bits == 384 || Bits == 512,
+	              "SHA-3 digests are 224, 256, 384, or 512 bits");
+
+public:
+	static constexpr std::size_t digest_size = Bits / 8;
+	static constexpr std::size_t block_size = 200 - 2 * digest_size;
+
+	using digest_type = std::array<std::byte, digest_size>;
+
+	hasher() noexcept
+	{
+		reset();
+	}
+
+	void reset() noexcept
+	{
+		sha3_init(&ctx_, static_cast<enum sha3_algo>(digest_size));
+	}
+
+	hasher &update(std::span<const std::byte> data) noexcept
+	{
+		sha3_update(&ctx_, data.data(), data.size());
+		return *this;
+	}
+
+	hasher &update(std::string_view data) noexcept
+	{
+		sha3_update(&ctx_, data.data(), data.size());
+		return *this;
+	}
+
+	digest_type final() noexcept
+	{
+		digest_type md;
+		sha3_final(&ctx_, md.data());
+		return md;
+	}
+
+	/* The underlying context, for use with the C functions. */
+	struct sha3_ctx *native() noexcept
+	{
+		return &ctx_;
+	}
+
+	const struct sha3_ctx *native() const noexcept
+	{
+		return &ctx_;
+	}
+
+private:
+	struct sha3_ctx ctx_;
+};
+
+/**
+ * digest - Compute the SHA-3 digest of a message.
+ *
+ * @Bits: Digest size in bits: 224, 256, 384, or 512.
+ * @data: The message.
+ *
+ * @return: The digest, computed at compile time in a constant expression.
+ */
+template <unsigned Bits>
+constexpr std::array<std::byte, Bits / 8>
+digest(std::span<const std::byte> data) noexcept
+{
+	static_assert(Bits == 224 || Bits == 256 || Bits == 384 || Bits == 512,
+	              "SHA-3 digests are 224, 256, 384, or 512 bits");
+
+	if (std::is_constant_evaluated())
+		return detail::digest<Bits / 8>(data.data(), data.size());
+
+	std::array<std::byte, Bits / 8> md;
+	detail::oneshot<Bits>(data.data(), data.size(), md.data());
+	return md;
+}
+
+template <unsigned Bits>
+constexpr std::array<std::byte, Bits / 8>
+digest(std::string_view data) noexcept
+{
+	static_assert(Bits == 224 || Bits == 256 || Bits == 384 || Bits == 512,
+	              "SHA-3 digests are 224, 256, 384, or 512 bits");
+
+	if (std::is_constant_evaluated())
+		return detail::digest<Bits / 8>(data.data(), data.size());
+
+	std::array<std::byte, Bits / 8> md;
+	detail::oneshot<Bits>(data.data(), data.size(), md.data());
+	return md;
+}
+
+} /* namespace sha3 */
+
+#endif /* SHA3_HPP */
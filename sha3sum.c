@@ -0,0 +1,793 @@
+/* SPDX-License-Identifier: 0BSD
+ *
+ * Copyright © 2022 Alex Minghella <a@minghella.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * sha3sum - Print or check SHA-3 digests.
+ *
+ * The output and check file formats are those of the coreutils sha*sum tools,
+ * including their escaping of file names that contain backslashes or newlines,
+ * and the BSD-style format written by --tag is accepted when checking too.
+ *
+ * Files are hashed on a worker pool, a chunk at a time so that results can be
+ * printed in order as they become available. Each task takes a run of files
+ * and reads the small regular files among them into memory, to be hashed
+ * together with sha3_hash_many(), and hashes everything else with
+ * sha3_update_fd().
+ */
+
+#include "sha3.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Files are hashed CHUNK at a time, in tasks of TASK files each. Regular files
+ * of up to SMALL_MAX bytes are batched.
+ */
+#define CHUNK     4096
+#define TASK      32
+#define SMALL_MAX (16 << 10)
+
+/**
+ * struct job - A file to hash.
+ *
+ * @name: File name, or "-" for standard input.
+ * @algo: Digest size in bytes.
+ * @want: Expected digest, when checking.
+ * @md:   Computed digest.
+ * @err:  Error number if the file couldn't be read, or zero.
+ */
+struct job {
+	char *name;
+	unsigned algo;
+	uint8_t want[64];
+	uint8_t md[64];
+	int err;
+};
+
+/**
+ * struct batch - Small files read by a task, waiting to be hashed together.
+ *
+ * @jobs:  Jobs the files belong to.
+ * @bufs:  File contents.
+ * @lens:  File sizes.
+ * @n:     Number of files.
+ * @algo:  Digest size shared by every file in the batch.
+ * @arena: TASK buffers of SMALL_MAX + 1 bytes each.
+ */
+struct batch {
+	struct job *jobs[TASK];
+	const void *bufs[TASK];
+	size_t lens[TASK];
+	size_t n;
+	unsigned algo;
+	uint8_t *arena;
+};
+
+/*
+ * struct run - Argument of hash_task(), a chunk of @n jobs.
+ */
+struct run {
+	struct job *jobs;
+	size_t n;
+};
+
+static const char *prog = "sha3sum";
+
+static struct {
+	unsigned algo;
+	bool check;
+	bool binary;
+	bool tag;
+	bool quiet;
+	bool status;
+	size_t jobs;
+} opts;
+
+/**
+ * read_all - Read a file descriptor until end of file or a buffer is full.
+ *
+ * @fd:   File descriptor open for reading.
+ * @buf:  Pointer to the buffer.
+ * @size: Size of the buffer in bytes.
+ *
+ * @return: Number of bytes read, or -1 on error with errno set.
+ */
+static ssize_t read_all(int fd, uint8_t *buf, size_t size)
+{
+	size_t n = 0;
+
+	while (n < size) {
+		ssize_t r = read(fd, buf + n, size - n);
+		if (r > 0)
+			n += r;
+		else if (!r)
+			break;
+		else if (errno != EINTR)
+			return -1;
+	}
+
+	return n;
+}
+
+static void batch_flush(struct batch *b)
+{
+	uint8_t out[TASK * 64];
+
+	if (!b->n)
+		return;
+
+	sha3_hash_many(b->algo, b->bufs, b->lens, b->n, out);
+	for (size_t i = 0; i < b->n; i++)
+		memcpy(b->jobs[i]->md, out + i * b->algo, b->algo);
+
+	b->n = 0;
+}
+
+/**
+ * hash_small - Read a small regular file into a batch.
+ *
+ * @b:  Pointer to the task's batch.
+ * @j:  Pointer to the job.
+ * @fd: File descriptor of the file.
+ *
+ * @return: None.
+ *
+ * A file that turns out to have grown past SMALL_MAX since it was measured is
+ * hashed on its own, starting with what has already been read.
+ */
+static void hash_small(struct batch *b, struct job *j, int fd)
+{
+	uint8_t *buf;
+	ssize_t n;
+
+	if (b->n == TASK || (b->n && b->algo != j->algo))
+		batch_flush(b);
+
+	buf = b->arena + b->n * (SMALL_MAX + 1);
+	n = read_all(fd, buf, SMALL_MAX + 1);
+	if (n < 0) {
+		j->err = errno;
+		return;
+	}
+
+	if (n > SMALL_MAX) {
+		struct sha3_ctx ctx;
+
+		sha3_init(&ctx, j->algo);
+		sha3_update(&ctx, buf, n);
+		if (sha3_update_fd(&ctx, fd))
+			j->err = errno;
+		else
+			sha3_final(&ctx, j->md);
+		return;
+	}
+
+	b->jobs[b->n] = j;
+	b->bufs[b->n] = buf;
+	b->lens[b->n] = n;
+	b->algo = j->algo;
+	b->n++;
+}
+
+static void hash_task(void *arg, size_t t)
+{
+	struct run *run = arg;
+	size_t end = (t + 1) * TASK < run->n ? (t + 1) * TASK : run->n;
+	struct batch b = { .n = 0 };
+
+	b.arena = malloc(TASK * (SMALL_MAX + 1));
+
+	for (size_t i = t * TASK; i < end; i++) {
+		struct job *j = &run->jobs[i];
+		bool std = !strcmp(j->name, "-");
+		struct stat st;
+		int fd = STDIN_FILENO;
+
+		if (!std) {
+			do
+				fd = open(j->name, O_RDONLY | O_CLOEXEC);
+			while (fd < 0 && errno == EINTR);
+		}
+
+		if (fd < 0) {
+			j->err = errno;
+			continue;
+		}
+
+		if (b.arena && !fstat(fd, &st) && S_ISREG(st.st_mode)
+		    && st.st_size <= SMALL_MAX) {
+			hash_small(&b, j, fd);
+		} else if (sha3_hash_fd(fd, j->algo, j->md)) {
+			j->err = errno;
+		}
+
+		if (!std)
+			close(fd);
+	}
+
+	batch_flush(&b);
+	free(b.arena);
+}
+
+/**
+ * hash_jobs - Hash a chunk of files.
+ *
+ * @pool: Worker pool, or NULL.
+ * @jobs: Array of @n jobs.
+ * @n:    Number of jobs.
+ *
+ * @return: None.
+ */
+static void hash_jobs(struct sha3_pool *pool, struct job *jobs, size_t n)
+{
+	struct run run = { jobs, n };
+
+	if (n)
+		sha3_pool_run(pool, hash_task, &run, (n + TASK - 1) / TASK);
+}
+
+static const char *algo_name(unsigned algo)
+{
+	switch (algo) {
+	case SHA3_224:
+		return "SHA3-224";
+	case SHA3_256:
+		return "SHA3-256";
+	case SHA3_384:
+		return "SHA3-384";
+	default:
+		return "SHA3-512";
+	}
+}
+
+/**
+ * print_name - Write a file name, escaped as coreutils does.
+ *
+ * @name: File name.
+ *
+ * @return: None.
+ *
+ * Backslashes and newlines are written as "\\" and "\n". The caller is
+ * responsible for the leading backslash that marks an escaped line.
+ */
+static void print_name(const char *name)
+{
+	for (; *name; name++) {
+		if (*name == '\\')
+			fputs("\\\\", stdout);
+		else if (*name == '\n')
+			fputs("\\n", stdout);
+		else
+			putchar(*name);
+	}
+}
+
+static void print_digest(const struct job *j)
+{
+	bool escape = strpbrk(j->name, "\\\n");
+
+	if (escape)
+		putchar('\\');
+
+	if (opts.tag) {
+		printf("%s (", algo_name(j->algo));
+		print_name(j->name);
+		fputs(") = ", stdout);
+	}
+
+	for (size_t i = 0; i < j->algo; i++)
+		printf("%02x", j->md[i]);
+
+	if (!opts.tag) {
+		fputs(opts.binary ? " *" : "  ", stdout);
+		print_name(j->name);
+	}
+
+	putchar('\n');
+}
+
+/**
+ * hash_files - Print the digests of files.
+ *
+ * @pool:  Worker pool, or NULL.
+ * @names: Array of @n file names.
+ * @n:     Number of file names.
+ *
+ * @return: Whether every file could be read.
+ */
+static bool hash_files(struct sha3_pool *pool, char **names, size_t n)
+{
+	struct job *jobs = calloc(n < CHUNK ? n : CHUNK, sizeof(*jobs));
+	bool ok = true;
+
+	if (!jobs) {
+		perror(prog);
+		exit(1);
+	}
+
+	for (size_t i = 0; i < n; i += CHUNK) {
+		size_t m = n - i < CHUNK ? n - i : CHUNK;
+
+		for (size_t k = 0; k < m; k++) {
+			jobs[k].name = names[i + k];
+			jobs[k].algo = opts.algo;
+			jobs[k].err = 0;
+		}
+
+		hash_jobs(pool, jobs, m);
+
+		for (size_t k = 0; k < m; k++) {
+			if (jobs[k].err) {
+				fflush(stdout);
+				fprintf(stderr, "%s: %s: %s\n", prog, jobs[k].name,
+				        strerror(jobs[k].err));
+				ok = false;
+			} else {
+				print_digest(&jobs[k]);
+			}
+		}
+	}
+
+	free(jobs);
+	return ok;
+}
+
+static int hexval(int c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+/**
+ * parse_hex - Parse a digest.
+ *
+ * @s:   Pointer to the hexadecimal digits.
+ * @len: Number of digits.
+ * @md:  Where to store the digest.
+ *
+ * @return: Digest size in bytes, or zero if @len isn't the length of a SHA-3
+ *          digest or the digits aren't all hexadecimal.
+ */
+static unsigned parse_hex(const char *s, size_t len, uint8_t *md)
+{
+	if (len != 56 && len != 64 && len != 96 && len != 128)
+		return 0;
+
+	for (size_t i = 0; i < len; i += 2) {
+		int hi = hexval(s[i]), lo = hexval(s[i + 1]);
+		if (hi < 0 || lo < 0)
+			return 0;
+		md[i / 2] = hi << 4 | lo;
+	}
+
+	return len / 2;
+}
+
+/**
+ * unescape - Undo print_name() in place.
+ *
+ * @s: File name.
+ *
+ * @return: False if @s contains an invalid escape.
+ */
+static bool unescape(char *s)
+{
+	char *d = s;
+
+	for (; *s; s++) {
+		if (*s != '\\') {
+			*d++ = *s;
+			continue;
+		}
+
+		if (s[1] == '\\')
+			*d++ = '\\';
+		else if (s[1] == 'n')
+			*d++ = '\n';
+		else
+			return false;
+		s++;
+	}
+
+	*d = '\0';
+	return true;
+}
+
+/**
+ * parse_line - Parse a line of a check file.
+ *
+ * @line: Line without its newline character. Modified in place.
+ * @j:    Job to fill in.
+ *
+ * @return: Whether the line is properly formatted.
+ *
+ * Both "<digest>  <name>" (or " *<name>") and "SHA3-<n> (<name>) = <digest>"
+ * are accepted, with a leading backslash if the name is escaped.
+ */
+static bool parse_line(char *line, struct job *j)
+{
+	bool escaped = *line == '\\';
+	char *name, *hex;
+	size_t hexlen;
+
+	line += escaped;
+
+	if (!strncmp(line, "SHA3-", 5)) {
+		char *close = strrchr(line, ')');
+		unsigned bits = strtoul(line + 5, &name, 10);
+
+		if (!close || strncmp(name, " (", 2) || strncmp(close, ") = ", 4))
+			return false;
+
+		name += 2;
+		*close = '\0';
+		hex = close + 4;
+		hexlen = strlen(hex);
+		if (hexlen != bits / 4)
+			return false;
+	} else {
+		hex = line;
+		hexlen = strcspn(line, " ");
+		if (line[hexlen] != ' '
+		    || (line[hexlen + 1] != ' ' && line[hexlen + 1] != '*'))
+			return false;
+		name = line + hexlen + 2;
+	}
+
+	j->algo = parse_hex(hex, hexlen, j->want);
+	if (!j->algo || (opts.algo && j->algo != opts.algo) || !*name)
+		return false;
+
+	if (escaped && !unescape(name))
+		return false;
+
+	j->name = strdup(name);
+	j->err = 0;
+	return j->name;
+}
+
+/**
+ * struct tally - Results of checking files.
+ *
+ * @lines:    Properly formatted lines.
+ * @bad:      Improperly formatted lines.
+ * @failed:   Files whose digests didn't match.
+ * @unread:   Files that couldn't be read.
+ */
+struct tally {
+	size_t lines;
+	size_t bad;
+	size_t failed;
+	size_t unread;
+};
+
+static void check_jobs(struct sha3_pool *pool, struct job *jobs, size_t n,
+                       struct tally *t)
+{
+	hash_jobs(pool, jobs, n);
+
+	for (size_t k = 0; k < n; k++) {
+		struct job *j = &jobs[k];
+		const char *result = "OK";
+
+		if (j->err) {
+			fflush(stdout);
+			if (!opts.status)
+				fprintf(stderr, "%s: %s: %s\n", prog, j->name,
+				        strerror(j->err));
+			result = "FAILED open or read";
+			t->unread++;
+		} else if (memcmp(j->md, j->want, j->algo)) {
+			result = "FAILED";
+			t->failed++;
+		} else if (opts.quiet) {
+			result = NULL;
+		}
+
+		if (result && !opts.status) {
+			bool escape = strpbrk(j->name, "\\\n");
+
+			if (escape)
+				putchar('\\');
+			print_name(j->name);
+			printf(": %s\n", result);
+		}
+
+		free(j->name);
+	}
+}
+
+/**
+ * check_file - Verify the digests listed in a check file.
+ *
+ * @pool: Worker pool, or NULL.
+ * @path: Path of the check file, or "-" for standard input.
+ *
+ * @return: Whether the file could be read, had at least one properly
+ *          formatted line, and every listed file matched.
+ */
+static bool check_file(struct sha3_pool *pool, const char *path)
+{
+	FILE *f = strcmp(path, "-") ? fopen(path, "r") : stdin;
+	struct job *jobs;
+	struct tally t = { 0 };
+	char *line = NULL;
+	size_t cap = 0, n = 0;
+	ssize_t len;
+
+	if (!f) {
+		fprintf(stderr, "%s: %s: %s\n", prog, path, strerror(errno));
+		return false;
+	}
+
+	jobs = malloc(CHUNK * sizeof(*jobs));
+	if (!jobs) {
+		perror(prog);
+		exit(1);
+	}
+
+	while ((len = getline(&line, &cap, f)) > 0) {
+		if (line[len - 1] == '\n')
+			line[--len] = '\0';
+		if (len && line[len - 1] == '\r')
+			line[--len] = '\0';
+
+		if (!parse_line(line, &jobs[n])) {
+			t.bad++;
+			continue;
+		}
+
+		t.lines++;
+		if (++n == CHUNK) {
+			check_jobs(pool, jobs, n, &t);
+			n = 0;
+		}
+	}
+
+	check_jobs(pool, jobs, n, &t);
+	free(jobs);
+	free(line);
+
+	if (ferror(f))
+		fprintf(stderr, "%s: %s: %s\n", prog, path, strerror(errno));
+	if (f != stdin)
+		fclose(f);
+
+	fflush(stdout);
+	if (!t.lines) {
+		fprintf(stderr,
+		        "%s: %s: no properly formatted checksum lines found\n",
+		        prog, path);
+		return false;
+	}
+
+	if (!opts.status) {
+		if (t.bad)
+			fprintf(stderr,
+			        "%s: WARNING: %zu line%s improperly formatted\n",
+			        prog, t.bad, t.bad == 1 ? " is" : "s are");
+		if (t.unread)
+			fprintf(stderr,
+			        "%s: WARNING: %zu listed file%s could not be read\n",
+			        prog, t.unread, t.unread == 1 ? "" : "s");
+		if (t.failed)
+			fprintf(stderr,
+			        "%s: WARNING: %zu computed checksum%s did NOT match\n",
+			        prog, t.failed, t.failed == 1 ? "" : "s");
+	}
+
+	return !t.unread && !t.failed;
+}
+
+static void usage(void)
+{
+	fprintf(stderr,
+	        "usage: %s [-bct] [-a bits] [-j jobs] [--tag] [--quiet] "
+	        "[--status] [file ...]\n"
+	        "\n"
+	        "  -a, --algorithm  224, 256, 384, or 512. (default 256)\n"
+	        "  -b, --binary     Mark files as read in binary mode.\n"
+	        "  -c, --check      Read digests from the files and check them.\n"
+	        "  -j, --jobs       Number of threads, or 0 for one per CPU.\n"
+	        "                   (default 0)\n"
+	        "  -t, --text       Mark files as read in text mode. (default)\n"
+	        "      --tag        Print BSD-style digests.\n"
+	        "      --quiet      Don't print OK for files that match.\n"
+	        "      --status     Print nothing, only set the exit status.\n"
+	        "\n"
+	        "With no file, or when file is -, read standard input.\n",
+	        prog);
+	exit(2);
+}
+
+static void set_algo(const char *s)
+{
+	char *end;
+	unsigned long bits = strtoul(s, &end, 10);
+
+	if (*end || (bits != 224 && bits != 256 && bits != 384 && bits != 512)) {
+		fprintf(stderr, "%s: invalid algorithm: %s\n", prog, s);
+		usage();
+	}
+
+	opts.algo = bits / 8;
+}
+
+static void set_jobs(const char *s)
+{
+	char *end;
+
+	opts.jobs = strtoul(s, &end, 10);
+	if (!*s || *end) {
+		fprintf(stderr, "%s: invalid number of jobs: %s\n", prog, s);
+		usage();
+	}
+}
+
+/**
+ * long_opt - Match a long option.
+ *
+ * @arg:  Command-line argument, after the leading "--".
+ * @name: Option name.
+ * @val:  Where to store a pointer to the value after "=", if the option takes
+ *        one, or NULL if it doesn't.
+ *
+ * @return: Whether @arg is the option.
+ */
+static bool long_opt(const char *arg, const char *name, const char **val)
+{
+	size_t n = strlen(name);
+
+	if (strncmp(arg, name, n))
+		return false;
+	if (!val)
+		return !arg[n];
+	if (arg[n] != '=')
+		return false;
+
+	*val = arg + n + 1;
+	return true;
+}
+
+/**
+ * parse_args - Parse the command line.
+ *
+ * @argc: Argument count.
+ * @argv: Arguments. The file names are moved to the front.
+ *
+ * @return: Number of file names.
+ *
+ * getopt_long() isn't POSIX, so long options are handled here alongside the
+ * short ones.
+ */
+static size_t parse_args(int argc, char **argv)
+{
+	size_t n = 0;
+	bool opts_done = false;
+
+	for (int i = 1; i < argc; i++) {
+		char *arg = argv[i];
+		const char *val;
+
+		if (opts_done || arg[0] != '-' || !arg[1]) {
+			argv[n++] = arg;
+		} else if (!strcmp(arg, "--")) {
+			opts_done = true;
+		} else if (arg[1] == '-') {
+			arg += 2;
+			if (long_opt(arg, "algorithm", &val))
+				set_algo(val);
+			else if (long_opt(arg, "jobs", &val))
+				set_jobs(val);
+			else if (long_opt(arg, "binary", NULL))
+				opts.binary = true;
+			else if (long_opt(arg, "text", NULL))
+				opts.binary = false;
+			else if (long_opt(arg, "check", NULL))
+				opts.check = true;
+			else if (long_opt(arg, "tag", NULL))
+				opts.tag = true;
+			else if (long_opt(arg, "quiet", NULL))
+				opts.quiet = true;
+			else if (long_opt(arg, "status", NULL))
+				opts.status = true;
+			else
+				usage();
+		} else {
+			for (arg++; *arg; arg++) {
+				switch (*arg) {
+				case 'a':
+				case 'j':
+					val = arg[1] ? arg + 1 : argv[++i];
+					if (!val)
+						usage();
+					if (*arg == 'a')
+						set_algo(val);
+					else
+						set_jobs(val);
+					arg += strlen(arg) - 1;
+					break;
+				case 'b':
+					opts.binary = true;
+					break;
+				case 't':
+					opts.binary = false;
+					break;
+				case 'c':
+					opts.check = true;
+					break;
+				default:
+					usage();
+				}
+			}
+		}
+	}
+
+	return n;
+}
+
+int main(int argc, char **argv)
+{
+	static char *stdin_name[] = { "-" };
+	struct sha3_pool *pool;
+	char **names = argv;
+	size_t n;
+	bool ok = true;
+
+	n = parse_args(argc, argv);
+	if (!n) {
+		names = stdin_name;
+		n = 1;
+	}
+
+	if (opts.tag && opts.check) {
+		fprintf(stderr, "%s: --tag is meaningless when checking\n", prog);
+		usage();
+	}
+
+	pool = opts.jobs == 1 ? NULL : sha3_pool_create(opts.jobs);
+
+	if (opts.check) {
+		for (size_t i = 0; i < n; i++)
+			ok &= check_file(pool, names[i]);
+	} else {
+		if (!opts.algo)
+			opts.algo = SHA3_256;
+		ok = hash_files(pool, names, n);
+	}
+
+	sha3_pool_destroy(pool);
+
+	if (fflush(stdout) || ferror(stdout)) {
+		perror(prog);
+		return 1;
+	}
+
+	return !ok;
+}
@@ -0,0 +1,490 @@
+/* SPDX-License-Identifier: 0BSD
+ *
+ * Copyright © 2022 Alex Minghella <a@minghella.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * References
+ *
+ * [1] NIST SP 800-185, SHA-3 Derived Functions: cSHAKE, KMAC, TupleHash and
+ *     ParallelHash, J. Kelsey, S. Chang, R. Perlner, December 2016,
+ *     https://doi.org/10.6028/NIST.SP.800-185
+ */
+
+/*
+ * SP 800-185 functions.
+ *
+ * cSHAKE is SHAKE with its input prefixed by bytepad(encode_string(N) ||
+ * encode_string(S), rate) and a different domain separation byte, so it's a
+ * struct sha3_ctx like any other. [1]
+ *
+ * TupleHash is cSHAKE with N = "TupleHash" over the concatenation of
+ * encode_string() of each element. The encodings are absorbed straight into
+ * the state, with each element taken in place from the caller's memory, so a
+ * tuple never has to be serialised into a buffer first.
+ *
+ * KMAC is cSHAKE with N = "KMAC" and a second bytepad() block holding the key.
+ * Both blocks are absorbed by kmac_init(), which leaves the state on a block
+ * boundary, so the keyed context can be cloned for each message at the cost of
+ * a copy and the batch functions can start every message from it.
+ *
+ * ParallelHash splits its input into B-byte blocks, hashes each to a digest
+ * with cSHAKE (with empty N and S, so really SHAKE), and absorbs the digests
+ * into an outer cSHAKE in order. As with the leaves of KangarooTwelve, any run
+ * of whole blocks in the input is hashed with the multi-buffer permutations
+ * and spread over a worker pool if there is one. Pool threads claim tasks of
+ * a few blocks at a time, so a thread that falls behind simply takes fewer.
+ */
+
+#include "sha3.h"
+#include "keccak.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/uio.h>
+
+/*
+ * Maximum number of whole blocks hashed before their digests are absorbed into
+ * the outer state, and the minimum size of each pool task in blocks and bytes.
+ * Small blocks are grouped so that a task is worth handing to another thread.
+ */
+#define PH_SEGMENT    256
+#define PH_TASK       8
+#define PH_TASK_BYTES 65536
+
+/**
+ * left_encode - Encode an integer as defined for SP 800-185.
+ *
+ * @x:   Integer to encode.
+ * @buf: Output buffer of at least 9 bytes.
+ *
+ * @return: Length of the encoding in bytes.
+ *
+ * This is a byte holding the length of the big-endian encoding of @x with no
+ * leading zeros, followed by that encoding. Zero is encoded as 0x01 0x00.
+ */
+static size_t left_encode(uint64_t x, uint8_t buf[9])
+{
+	uint8_t be[8];
+	size_t n = 1;
+	for (uint64_t y = x >> 8; y; y >>= 8)
+		n++;
+
+	/*
+	 * The encoding is built in full and its tail copied, so that the
+	 * compiler can see it's never more than 8 bytes.
+	 */
+	for (size_t i = 0; i < 8; i++)
+		be[i] = x >> 8 * (7 - i);
+	buf[0] = n;
+	memcpy(buf + 1, be + 8 - n, n);
+
+	return n + 1;
+}
+
+/**
+ * right_encode - Encode an integer as defined for SP 800-185.
+ *
+ * @x:   Integer to encode.
+ * @buf: Output buffer of at least 9 bytes.
+ *
+ * @return: Length of the encoding in bytes.
+ *
+ * As left_encode(), but the length byte follows the encoding of @x.
+ */
+static size_t right_encode(uint64_t x, uint8_t buf[9])
+{
+	uint8_t be[8];
+	size_t n = 1;
+	for (uint64_t y = x >> 8; y; y >>= 8)
+		n++;
+
+	for (size_t i = 0; i < 8; i++)
+		be[i] = x >> 8 * (7 - i);
+	memcpy(buf, be + 8 - n, n);
+	buf[n] = n;
+
+	return n + 1;
+}
+
+/**
+ * absorb_string - Absorb encode_string() of a string.
+ *
+ * @ctx: Pointer to an initialised SHA-3 context structure.
+ * @s:   Pointer to the string, or NULL if @len is zero.
+ * @len: Length, in bytes, of the string.
+ *
+ * @return: None.
+ *
+ * The encoding is the bit length of the string as left_encode() followed by
+ * the string itself, which is absorbed in place rather than copied.
+ */
+static void absorb_string(struct sha3_ctx *ctx, const void *s, size_t len)
+{
+	uint8_t enc[9];
+
+	sha3_update(ctx, enc, left_encode((uint64_t)len * 8, enc));
+	sha3_update(ctx, s, len);
+}
+
+/**
+ * absorb_bytepad_end - Finish absorbing a bytepad() prefix.
+ *
+ * @ctx: Pointer to an initialised SHA-3 context structure.
+ *
+ * @return: None.
+ *
+ * bytepad() pads its input with zero bytes to a multiple of the rate. Zero
+ * bytes don't modify the state, so that amounts to permuting the state if the
+ * current block is partially filled.
+ */
+static void absorb_bytepad_end(struct sha3_ctx *ctx)
+{
+	if (ctx->index) {
+		ctx->index = 0;
+		keccak_impl->p1600(ctx->u64, ctx->rounds);
+	}
+}
+
+void cshake_init(struct sha3_ctx *ctx, enum shake_algo algo, const void *name,
+                 size_t nlen, const void *custom, size_t clen)
+{
+	uint8_t enc[9];
+
+	shake_init(ctx, algo);
+	if (!nlen && !clen)
+		return;
+
+	ctx->ds = 0x04;
+	sha3_update(ctx, enc, left_encode(ctx->rate, enc));
+	absorb_string(ctx, name, nlen);
+	absorb_string(ctx, custom, clen);
+	absorb_bytepad_end(ctx);
+}
+
+void cshake(const struct sha3_ctx *mid, const void *buf, size_t len, void *out,
+            size_t outlen)
+{
+	struct sha3_ctx ctx;
+
+	sha3_ctx_clone(&ctx, mid);
+	sha3_update(&ctx, buf, len);
+	shake_final(&ctx);
+	shake_squeeze(&ctx, out, outlen);
+}
+
+void tuplehash_init(struct sha3_ctx *ctx, enum shake_algo algo,
+                    const void *custom, size_t clen)
+{
+	cshake_init(ctx, algo, "TupleHash", 9, custom, clen);
+}
+
+void tuplehash_element(struct sha3_ctx *ctx, size_t len)
+{
+	uint8_t enc[9];
+
+	sha3_update(ctx, enc, left_encode((uint64_t)len * 8, enc));
+}
+
+void tuplehash_update(struct sha3_ctx *ctx, const void *buf, size_t len)
+{
+	absorb_string(ctx, buf, len);
+}
+
+/*
+ * Number of elements whose encodings are gathered into each sha3_updatev()
+ * call by tuplehash_updatev().
+ */
+#define TH_BATCH 16
+
+void tuplehash_updatev(struct sha3_ctx *ctx, const struct iovec *elems, int n)
+{
+	uint8_t enc[TH_BATCH][9];
+	struct iovec iov[2 * TH_BATCH];
+
+	/*
+	 * Each length prefix and element is one buffer of a gather list, so
+	 * that the lanes spanning them are assembled in registers rather than
+	 * a byte at a time.
+	 */
+	for (int i = 0; i < n; i += TH_BATCH) {
+		int m = n - i < TH_BATCH ? n - i : TH_BATCH;
+
+		for (int j = 0; j < m; j++) {
+			size_t len = elems[i + j].iov_len;
+
+			iov[2 * j].iov_base = enc[j];
+			iov[2 * j].iov_len = left_encode((uint64_t)len * 8, enc[j]);
+			iov[2 * j + 1] = elems[i + j];
+		}
+
+		sha3_updatev(ctx, iov, 2 * m);
+	}
+}
+
+void tuplehash_final(struct sha3_ctx *ctx, size_t outlen)
+{
+	uint8_t enc[9];
+
+	sha3_update(ctx, enc, right_encode((uint64_t)outlen * 8, enc));
+	shake_final(ctx);
+}
+
+void tuplehash(const struct sha3_ctx *mid, const struct iovec *elems, int n,
+               void *out, size_t outlen)
+{
+	struct sha3_ctx ctx;
+
+	sha3_ctx_clone(&ctx, mid);
+	tuplehash_updatev(&ctx, elems, n);
+	tuplehash_final(&ctx, outlen);
+	shake_squeeze(&ctx, out, outlen);
+}
+
+void tuplehash_xof(const struct sha3_ctx *mid, const struct iovec *elems,
+                   int n, void *out, size_t outlen)
+{
+	struct sha3_ctx ctx;
+
+	sha3_ctx_clone(&ctx, mid);
+	tuplehash_updatev(&ctx, elems, n);
+	tuplehash_final(&ctx, 0);
+	shake_squeeze(&ctx, out, outlen);
+}
+
+void kmac_init(struct sha3_ctx *ctx, enum shake_algo algo, const void *key,
+               size_t klen, const void *custom, size_t clen)
+{
+	uint8_t enc[9];
+
+	cshake_init(ctx, algo, "KMAC", 4, custom, clen);
+	sha3_update(ctx, enc, left_encode(ctx->rate, enc));
+	absorb_string(ctx, key, klen);
+	absorb_bytepad_end(ctx);
+}
+
+void kmac_final(struct sha3_ctx *ctx, size_t outlen)
+{
+	uint8_t enc[9];
+
+	sha3_update(ctx, enc, right_encode((uint64_t)outlen * 8, enc));
+	shake_final(ctx);
+}
+
+void kmac(const struct sha3_ctx *key, const void *buf, size_t len, void *tag,
+          size_t taglen)
+{
+	struct sha3_ctx ctx;
+
+	sha3_ctx_clone(&ctx, key);
+	sha3_update(&ctx, buf, len);
+	kmac_final(&ctx, taglen);
+	shake_squeeze(&ctx, tag, taglen);
+	memset(&ctx, 0, sizeof(ctx));
+}
+
+void kmac_many(const struct sha3_ctx *key, const void *const *bufs,
+               const size_t *lens, size_t n, void *out, size_t taglen)
+{
+	uint8_t *tag = out;
+	uint8_t enc[9];
+
+	/* Tags longer than one block need more than one squeeze. */
+	if (taglen > key->rate) {
+		for (size_t i = 0; i < n; i++)
+			kmac(key, bufs[i], lens[i], tag + i * taglen, taglen);
+		return;
+	}
+
+	size_t elen = right_encode((uint64_t)taglen * 8, enc);
+	keccak_hash_many_from(key, enc, elen, taglen, bufs, lens, n, out);
+}
+
+struct blocks {
+	enum shake_algo algo;
+	const uint8_t *p;
+	size_t block;
+	size_t count;
+	size_t task;
+	uint8_t *md;
+};
+
+static void blocks_task(void *arg, size_t t)
+{
+	const struct blocks *b = arg;
+	const void *bufs[PH_SEGMENT];
+	size_t lens[PH_SEGMENT];
+
+	size_t first = t * b->task;
+	size_t n = b->count - first < b->task ? b->count - first : b->task;
+
+	for (size_t i = 0; i < n; i++) {
+		bufs[i] = b->p + (first + i) * b->block;
+		lens[i] = b->block;
+	}
+
+	/* z_i = cSHAKE(X_i, 2L, "", "") = SHAKE(X_i, 2L) */
+	keccak_hash_many(200 - 2 * b->algo, 0x1f, 24, 2 * b->algo, bufs, lens,
+	                 n, b->md + first * 2 * b->algo);
+}
+
+/**
+ * ph_blocks - Hash whole blocks and absorb their digests.
+ *
+ * @ctx:   Pointer to a ParallelHash context with no block in progress.
+ * @p:     Pointer to the first block.
+ * @count: Number of blocks. At most PH_SEGMENT.
+ *
+ * @return: None.
+ */
+static void ph_blocks(struct parallelhash_ctx *ctx, const uint8_t *p,
+                      size_t count)
+{
+	uint8_t md[PH_SEGMENT * 64];
+	struct blocks b = {
+		.algo = ctx->algo,
+		.p = p,
+		.block = ctx->block,
+		.count = count,
+		.task = PH_TASK,
+		.md = md,
+	};
+
+	if (b.task * b.block < PH_TASK_BYTES)
+		b.task = (PH_TASK_BYTES + b.block - 1) / b.block;
+	if (b.task > PH_SEGMENT)
+		b.task = PH_SEGMENT;
+
+	sha3_pool_run(ctx->pool, blocks_task, &b,
+	              (count + b.task - 1) / b.task);
+
+	sha3_update(&ctx->outer, md, count * 2 * ctx->algo);
+	ctx->blocks += count;
+}
+
+/**
+ * ph_block_final - Finish the block in progress and absorb its digest.
+ *
+ * @ctx: Pointer to a ParallelHash context with a block in progress.
+ *
+ * @return: None.
+ */
+static void ph_block_final(struct parallelhash_ctx *ctx)
+{
+	uint8_t md[64];
+
+	shake_final(&ctx->inner);
+	shake_squeeze(&ctx->inner, md, 2 * ctx->algo);
+	sha3_update(&ctx->outer, md, 2 * ctx->algo);
+	ctx->blocks++;
+}
+
+void parallelhash_init(struct parallelhash_ctx *ctx, enum shake_algo algo,
+                       size_t block, const void *custom, size_t clen,
+                       struct sha3_pool *pool)
+{
+	uint8_t enc[9];
+
+	cshake_init(&ctx->outer, algo, "ParallelHash", 12, custom, clen);
+	sha3_update(&ctx->outer, enc, left_encode(block, enc));
+
+	ctx->pool = pool;
+	ctx->block = block;
+	ctx->len = 0;
+	ctx->blocks = 0;
+	ctx->algo = algo;
+}
+
+void parallelhash_update(struct parallelhash_ctx *ctx, const void *buf,
+                         size_t len)
+{
+	const uint8_t *p = buf;
+
+	size_t off = ctx->len % ctx->block;
+	ctx->len += len;
+
+	if (off) {
+		size_t n = ctx->block - off;
+		if (n > len)
+			n = len;
+
+		sha3_update(&ctx->inner, p, n);
+		p += n;
+		len -= n;
+
+		if (off + n < ctx->block)
+			return;
+
+		ph_block_final(ctx);
+	}
+
+	while (len >= ctx->block) {
+		size_t count = len / ctx->block;
+		if (count > PH_SEGMENT)
+			count = PH_SEGMENT;
+
+		ph_blocks(ctx, p, count);
+		p += count * ctx->block;
+		len -= count * ctx->block;
+	}
+
+	if (len) {
+		shake_init(&ctx->inner, (enum shake_algo)ctx->algo);
+		sha3_update(&ctx->inner, p, len);
+	}
+}
+
+void parallelhash_final(struct parallelhash_ctx *ctx, size_t outlen)
+{
+	uint8_t enc[9];
+
+	if (ctx->len % ctx->block)
+		ph_block_final(ctx);
+
+	sha3_update(&ctx->outer, enc, right_encode(ctx->blocks, enc));
+	sha3_update(&ctx->outer, enc, right_encode((uint64_t)outlen * 8, enc));
+	shake_final(&ctx->outer);
+	memset(&ctx->inner, 0, sizeof(ctx->inner));
+}
+
+void parallelhash_squeeze(struct parallelhash_ctx *ctx, void *out, size_t len)
+{
+	shake_squeeze(&ctx->outer, out, len);
+}
+
+void parallelhash(enum shake_algo algo, const void *buf, size_t len,
+                  size_t block, const void *custom, size_t clen, void *out,
+                  size_t outlen, struct sha3_pool *pool)
+{
+	struct parallelhash_ctx ctx;
+
+	parallelhash_init(&ctx, algo, block, custom, clen, pool);
+	parallelhash_update(&ctx, buf, len);
+	parallelhash_final(&ctx, outlen);
+	parallelhash_squeeze(&ctx, out, outlen);
+	memset(&ctx, 0, sizeof(ctx));
+}
+
+void parallelhash_xof(enum shake_algo algo, const void *buf, size_t len,
+                      size_t block, const void *custom, size_t clen, void *out,
+                      size_t outlen, struct sha3_pool *pool)
+{
+	struct parallelhash_ctx ctx;
+
+	parallelhash_init(&ctx, algo, block, custom, clen, pool);
+	parallelhash_update(&ctx, buf, len);
+	parallelhash_final(&ctx, 0);
+	parallelhash_squeeze(&ctx, out, outlen);
+	memset(&ctx, 0, sizeof(ctx));
+}
@@ -0,0 +1,55 @@
+/* SPDX-License-Identifier: 0BSD
+ *
+ * Copyright © 2022 Alex Minghella <a@minghella.net>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Per-thread hashing counters.
+ *
+ * The counters are only kept when the library is built with SHA3_STATS, in
+ * which case the hot paths add to them through KECCAK_STAT(). They live in
+ * thread-local storage so that counting never needs atomics or contends on a
+ * shared cache line.
+ */
+
+#include "sha3.h"
+#include "keccak.h"
+
+#include <errno.h>
+#include <string.h>
+
+#if defined(SHA3_STATS)
+KECCAK_TLS struct sha3_stats keccak_stats;
+#endif
+
+int sha3_stats_get(struct sha3_stats *st)
+{
+#if defined(SHA3_STATS)
+	*st = keccak_stats;
+	st->kernel = sha3_kernel();
+	return 0;
+#else
+	memset(st, 0, sizeof(*st));
+	st->kernel = sha3_kernel();
+	errno = ENOTSUP;
+	return -1;
+#endif
+}
+
+void sha3_stats_reset(void)
+{
+#if defined(SHA3_STATS)
+	memset(&keccak_stats, 0, sizeof(keccak_stats));
+#endif
+}